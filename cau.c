@@ -22,16 +22,23 @@
 * DESCRIPTION
 *	`cau' is a utility which provides some commonly used Channel Access
 *	capabilities.  These include:
-*	o  storing a new value for a channel
+*	o  storing new values for channels, including whole waveforms,
+*	   inline or from a file
 *	o  getting the present value for one or more channels
 *	o  sending software signal generator output(s) to one or more
 *	   channels
 *	o  monitoring one or more channels
 *	o  some simple tests for monitored channels
+*	o  measuring the round trip latency from a put to the resulting
+*	   monitor update
+*	o  spreading monitors for many channels over several Channel
+*	   Access contexts (shards), to make use of several processors
+*	o  saving the values of many channels in a snapshot file, and
+*	   restoring them
 *
 * WISH LIST
-* o	handle waveforms--put and signal generation
-* o	investigate usefulness of additional commands: snapshot, restore,
+* o	handle waveforms--signal generation
+* o	investigate usefulness of additional commands:
 *	pause (waiting for operator), delay timeInterval, assert condition,
 *	abort (as script), waitUntil condition
 *
@@ -39,6 +46,7 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <float.h>
 #include "genDefs.h"
 #include "cmdDefs.h"
 #include "cadef.h"
@@ -46,6 +54,10 @@
 #include "nextFieldSubrDefs.h"
 #include "cvtNumbersDefs.h"
 #include "epicsTime.h"
+#include "epicsThread.h"
+#include "epicsEvent.h"
+#include "epicsRingBytes.h"
+#include "epicsMutex.h"
 
 #ifdef vxWorks
 /*----------------------------------------------------------------------------
@@ -70,84 +82,664 @@
 #   include <setjmp.h>
 #ifndef _WIN32
 #   include <unistd.h>
+#   include <sys/types.h>	/* for 'select' operations */
+#   include <sys/time.h>	/* for 'select' operations */
+#   include <fcntl.h>
+#   include <pthread.h>
+#   include <sys/mman.h>	/* for the metadata cache and array files */
+#   include <sys/stat.h>
+#   define CAU_SHARDS		/* monitors can be spread over CA contexts */
+#   define CAU_MMAP_CACHE	/* channel metadata can be cached on disk */
+#   define CAU_MMAP_ARRAY	/* array files for put can be mapped */
 #endif
 #endif
 
 #define CAU_ABS(val) ((val) >= 0 ? (val) : -(val))
+#define CAU_WAIT_MAX 1.		/* longest wait in main loop, in seconds */
+#define CAU_WAIT_POLL .1	/* longest wait if input can't be watched */
+#define CAU_CMD_Q_DIM 32	/* number of lines in the command queue */
+#define CAU_CA_FD_DIM 64	/* max CA file descriptors watched */
+#define CAU_HASH_DIM 256	/* initial size of channel hash table */
+#define CAU_CONN_POLL .01	/* poll interval while waiting for connects */
+#define CAU_LOAD_BATCH 200	/* default searches per batch for load */
+#define CAU_LOAD_PACE .1	/* default seconds per batch for load */
+#define CAU_LOAD_WAIT 5.	/* seconds load waits for last connects */
+#define CAU_LOAD_LINE_DIM 256	/* longest line in a load file */
+#define CAU_CACHE_MAGIC 0x43415543L /* "CAUC", at start of cache file */
+#define CAU_CACHE_VERSION 2	/* version of cache file layout */
+#define CAU_CACHE_GROW 1024	/* entries added when cache file grows */
+#define CAU_SNAP_MAGIC 0x43415553L /* "CAUS", at start of snapshot file */
+#define CAU_SNAP_VERSION 1	/* version of snapshot file layout */
+#define CAU_SNAP_ENTRY_MAX 1000000L /* most channels restore will read */
+#define CAU_SNAP_BYTES_MAX 0x4000000L /* largest buffer restore will read */
+#define CAU_GET_PEND -3	/* status marking a get not yet answered */
+#define CAU_GET_TMO 1.	/* seconds to wait for a list of gets */
+#define CAU_GET_WINDOW 1024	/* most streamed gets outstanding */
+#define CAU_ENUM_HASH_DIM 32	/* enum hash slots (power of 2, >= 2*16) */
+#define CAU_HOST_NAME_DIM 64	/* longest IOC host name kept */
+#define CAU_REARM_MIN .5	/* first wait before re-arming after reconnect */
+#define CAU_REARM_MAX 30.	/* longest wait between re-arm attempts */
+#define CAU_SHARD_DIM 64	/* max number of shards */
+#define CAU_SHARD_Q_DIM 256	/* number of ops in a shard's op queue */
+#define CAU_SHARD_MERGE .05	/* longest wait before merging shard output */
+#define CAU_POOL_SLAB_SIZE 16384	/* bytes per pool slab (at least 1 item) */
+#define CAU_BUF_MIN 64		/* size of smallest value buffer class */
+#define CAU_BUF_CLASS_DIM 12	/* number of value buffer classes (to 128k) */
 
+/*/subhead CAU_TMR---------------------------------------------------------
+* CAU_TMR
+*
+*	A cau timer is a deadline which is kept in a timer heap.  The heap
+*	is a binary heap ordered on the deadlines, so that the earliest
+*	deadline is always at the top; arming, re-arming, and cancelling
+*	a timer each take O(log n) time, and finding the timers which
+*	are due takes time only for the timers which are actually due.
+*----------------------------------------------------------------------------*/
+
+typedef struct cauTmr {
+    TS_STAMP	time;			/* deadline */
+    int		heapIx;			/* index in heap, or -1 if unarmed */
+    void	*pArg;			/* owner of timer */
+} CAU_TMR;
+
+typedef struct {
+    CAU_TMR	**ppTmr;		/* heap of pointers to timers */
+    int		nTmr;			/* number of timers in heap */
+    int		dim;			/* dimension of ppTmr */
+} CAU_TMR_HEAP;
+
+/*/subhead CAU_POOL--------------------------------------------------------
+* CAU_POOL
+*
+*	A cau pool hands out items of a single size.  Items are carved
+*	from slabs of about CAU_POOL_SLAB_SIZE bytes, which are kept until cau
+*	exits; an item which is given back goes onto the pool's free
+*	list and is used for the next request.  Once a pool has grown to
+*	the number of items in use at one time, getting and giving back
+*	items costs no malloc or free.
+*
+*	Channel descriptors come from their own pool.  Value buffers and
+*	graphics buffers come from a set of pools with sizes which are
+*	powers of 2, starting at CAU_BUF_MIN; a buffer too large for the
+*	biggest pool is obtained with malloc.
+*
+*	Pools are used only by cauTask, so no locking is needed.
+*----------------------------------------------------------------------------*/
+
+typedef union cauPoolSlab {
+    union cauPoolSlab *pNext;		/* link to next slab in pool */
+    double	align;			/* alignment for items */
+} CAU_POOL_SLAB;
+
+typedef struct cauPoolItem {
+    struct cauPoolItem *pNext;		/* link to next free item */
+} CAU_POOL_ITEM;
+
+typedef struct {
+    size_t	itemSize;		/* size of an item, in bytes */
+    int		nPerSlab;		/* number of items in a slab */
+    CAU_POOL_SLAB *pSlabHead;		/* list of slabs */
+    CAU_POOL_ITEM *pFreeHead;		/* list of free items */
+    long	nSlab;			/* number of slabs */
+    long	nUsed;			/* number of items in use */
+    long	nUsedMax;		/* most items in use at once */
+    unsigned long nGet;			/* number of items handed out */
+} CAU_POOL;
+
 /*/subhead CAU_CHAN--------------------------------------------------------
 * CAU_CHAN
 *
 *	A cau channel descriptor contains the data necessary to
 *	generate the desired signal and the buffers used for ca_get
+*
+*	A channel starts out on the connect list, in CAU_CONN_SEARCH
+*	state.  When it connects, it is moved to the channel list and is
+*	in CAU_CONN_OK state.  If the connection is lost, the channel
+*	stays on the channel list, in CAU_CONN_DOWN state, until Channel
+*	Access reconnects it.  Disconnects and reconnects are printed,
+*	with the time, to the channel's dataOut.
+*
+*	Channel Access keeps a channel's monitor across a reconnect, but
+*	if the channel comes back with a different native type or count,
+*	the buffer has to be resized and the monitor placed again.  Such
+*	channels are put on a re-arm list for the channel's IOC host (see
+*	CAU_HOST).
+*
+*	The graphics information (DBR_CTRL_xxx, which holds everything
+*	in DBR_GR_xxx, at the same offsets, plus the control limits) isn't
+*	fetched when the channel connects.  It is requested (by
+*	cauChanGRRequest) only when something needs it--precision or enum
+*	strings for printing, units for the info command, display limits
+*	for ramp, or control limits and enum strings for put.  Until it
+*	has arrived, pGRBuf may be NULL; CauChanGR gives the buffer only
+*	when grState is CAU_GR_OK.  For ENUM channels, pEnumHash indexes
+*	the state strings; it is rebuilt each time the information
+*	arrives.
+*
+*	The fields used on every monitor (list links, interval, time of
+*	last monitor, deadTime timer, value buffer) are kept together at
+*	the front of the descriptor; the name and the rest come after.
+*	The state for signal generation is in a separate CAU_SIGGEN, from
+*	its own pool, which exists only while a signal is being
+*	generated for the channel.  Only one member of its val union is
+*	used, as selected by the channel's dbfType.
 *----------------------------------------------------------------------------*/
 
+typedef struct cauSigGen {
+    long	(*pFn)();		/* function to call */
+    CAU_TMR	nextTime;		/* time for next step in signal */
+    double	secPerStep;		/* seconds between steps */
+    short	nSteps;			/* number of steps in signal */
+    long	stepCount;		/* steps done since signal started */
+    long	stepSkipCount;		/* steps skipped because late */
+    double	stepErrLast;		/* lateness of last step, in seconds */
+    double	stepErrMax;		/* maximum lateness of a step */
+    double	stepErrSum;		/* sum of lateness, for average */
+    union {				/* member selected by chan's dbfType */
+	struct {
+	    short	endVal;		/* end value for signal */
+	    short	begVal;		/* begin value for signal */
+	    short	currVal;	/* current value for signal */
+	    short	addVal;		/* amount to add for next value */
+	    char	string[db_strval_dim];
+	} str;
+	struct {
+	    char	endVal;		/* end value for signal */
+	    char	begVal;		/* begin value for signal */
+	    char	currVal;	/* current value for signal */
+	    char	addVal;		/* amount to add for next value */
+	} chr;
+	struct {
+	    float	endVal;		/* end value for signal */
+	    float	begVal;		/* begin value for signal */
+	    float	currVal;	/* current value for signal */
+	    float	addVal;		/* amount to add for next value */
+	} flt;
+	struct {
+	    short	endVal;		/* end value for signal */
+	    short	begVal;		/* begin value for signal */
+	    short	currVal;	/* current value for signal */
+	    short	addVal;		/* amount to add for next value */
+	} shrt;
+	struct {
+	    double	endVal;		/* end value for signal */
+	    double	begVal;		/* begin value for signal */
+	    double	currVal;	/* current value for signal */
+	    double	addVal;		/* amount to add for next value */
+	} dbl;
+	struct {
+	    long	endVal;		/* end value for signal */
+	    long	begVal;		/* begin value for signal */
+	    long	currVal;	/* current value for signal */
+	    long	addVal;		/* amount to add for next value */
+	} lng;
+	struct {
+	    short	endVal;		/* end value for signal */
+	    short	begVal;		/* begin value for signal */
+	    short	currVal;	/* current value for signal */
+	    short	addVal;		/* amount to add for next value */
+	} enm;
+    } val;
+} CAU_SIGGEN;
+
 typedef struct cauSetChannel {
-    double	interval;		/* desired interval, in seconds */
-    double	jitter;			/* allowed jitter, in seconds */
     struct cauSetChannel *pPrev;	/* link to previous channel */
     struct cauSetChannel *pNext;	/* link to next channel */
+    double	interval;		/* desired interval, in seconds */
+    double	jitter;			/* allowed jitter, in seconds */
+    TS_STAMP	lastMonTime;		/* last time handler was called */
+    CAU_TMR	deadTime;		/* time at which channel goes dead */
+    union db_access_val *pBuf;		/* pointer to buffer */
+    CAU_SIGGEN	*pSigGen;		/* signal generation state, or NULL */
     CX_CMD	*pCxCmd;		/* ptr to cmd context, for printing */
-    char	name[db_name_dim];	/* channel name (as entered) */
-    char	*units;			/* pointer to units, or NULL */
-    USHORT	reqCount;		/* requested count, for arrays */
-    USHORT	elCount;		/* native count of channel */
-    chtype	dbfType;		/* native type of channel */
-    chtype	dbrType;		/* desired type for retrieved data */
     chid	pCh;			/* channel pointer */
     evid	pEv;			/* event pointer */
-    union db_access_val *pBuf;		/* pointer to buffer */
-    union db_access_val *pGRBuf;	/* pointer to graphics info buffer */
-    long	(*pFn)();		/* function to call */
-    TS_STAMP	lastMonTime;		/* last time handler was called */
+    chtype	dbfType;		/* native type of channel */
+    chtype	dbrType;		/* desired type for retrieved data */
+    unsigned long reqCount;		/* requested count; 0 for dynamic */
+    unsigned long elCount;		/* native count of channel */
+    unsigned long nEl;			/* number of elements in pBuf */
     int		lastMonErr;		/* 1 says err msg printed */
-    struct {
-	short	endVal;			/* end value for signal */
-	short	begVal;			/* begin value for signal */
-	short	currVal;		/* current value for signal */
-	short	addVal;			/* amount to add for next value */
-	char	string[db_strval_dim];
-    } str;
-    struct {
-	char	endVal;			/* end value for signal */
-	char	begVal;			/* begin value for signal */
-	char	currVal;		/* current value for signal */
-	char	addVal;			/* amount to add for next value */
-    } chr;
-    struct {
-	float	endVal;			/* end value for signal */
-	float	begVal;			/* begin value for signal */
-	float	currVal;		/* current value for signal */
-	float	addVal;			/* amount to add for next value */
-    } flt;
-    struct {
-	short	endVal;			/* end value for signal */
-	short	begVal;			/* begin value for signal */
-	short	currVal;		/* current value for signal */
-	short	addVal;			/* amount to add for next value */
-    } shrt;
-    struct {
-	double	endVal;			/* end value for signal */
-	double	begVal;			/* begin value for signal */
-	double	currVal;		/* current value for signal */
-	double	addVal;			/* amount to add for next value */
-    } dbl;
-    struct {
-	long	endVal;			/* end value for signal */
-	long	begVal;			/* begin value for signal */
-	long	currVal;		/* current value for signal */
-	long	addVal;			/* amount to add for next value */
-    } lng;
-    struct {
-	short	endVal;			/* end value for signal */
-	short	begVal;			/* begin value for signal */
-	short	currVal;		/* current value for signal */
-	short	addVal;			/* amount to add for next value */
-    } enm;
-    short	nSteps;			/* number of steps in signal */
-    TS_STAMP	nextTime;		/* time for next step in signal */
-    double	secPerStep;		/* seconds between steps */
+    int		connState;		/* CAU_CONN_xxx */
+    TS_STAMP	connTime;		/* time of last connect or disconnect */
+    long	nDisconn;		/* number of times disconnected */
+    struct cauHost *pHost;		/* host, while waiting for re-arm */
+    struct cauSetChannel *pRearmNext;	/* link in host's re-arm list */
+    struct cauPoll *pPoll;		/* poll group, or NULL */
+    struct cauPing *pPing;		/* ping, or NULL */
+    int		pollPend;		/* 1 says poll get is outstanding */
+    unsigned long pollSent;		/* number of poll gets sent */
+    unsigned long pollRecv;		/* number of poll answers received */
+    CAU_TMR	putHeld;		/* time held put may be sent */
+    TS_STAMP	putNext;		/* earliest time for next put */
+    union cauValue *pPutValue;		/* held put value, or NULL */
+    chtype	putType;		/* DBR_xxx type of held put */
+    struct cauHost *pPutHost;		/* host, for putRate, or NULL */
+    long	nPutCoalesced;		/* puts replaced before being sent */
+    int		grState;		/* CAU_GR_xxx */
+    int		grCached;		/* 1 says pGRBuf is from cache, unchecked */
+    long	connBatch;		/* connect batch channel was added in */
+    long	grBatch;		/* graphics batch of last request */
+    size_t	bufSize;		/* size of pBuf, in bytes */
+    union db_access_val *pGRBuf;	/* pointer to graphics info buffer */
+    unsigned char *pEnumHash;		/* enum string hash, or NULL */
+    char	*units;			/* pointer to units, or NULL */
+    unsigned long nameHash;		/* hash of name, without .VAL */
+    int		nameLen;		/* length of name, without .VAL */
+    char	name[db_name_dim];	/* channel name (as entered) */
+#ifdef CAU_SHARDS
+    struct cauShard *pShard;		/* shard doing monitor, or NULL */
+    union db_access_val *pBufBack;	/* shard's back buffer, or NULL */
+    size_t	bufBackSize;		/* size of pBufBack, in bytes */
+    size_t	bufBackNeed;		/* size shard asked cauTask for, or 0 */
+    int		bufBackBusy;		/* 1 says shard is copying to pBufBack */
+    unsigned long nShardDrop;		/* updates dropped, buffer too small */
+    chid	pShardCh;		/* channel in shard's CA context */
+    evid	pShardEv;		/* event in shard's CA context */
+    struct cauSetChannel *pShardPrev;	/* link to previous in shard */
+    struct cauSetChannel *pShardNext;	/* link to next in shard */
+#endif
 } CAU_CHAN;
+
+#define CAU_CONN_SEARCH	0	/* on connect list, not yet connected */
+#define CAU_CONN_OK	1	/* connected */
+#define CAU_CONN_DOWN	2	/* was connected, connection lost */
+
+#define CAU_GR_NONE	0	/* graphics info not requested */
+#define CAU_GR_PEND	1	/* graphics info requested, not yet received */
+#define CAU_GR_OK	2	/* graphics info received */
+
+#define CAU_GR_NEED_NONE  0	/* graphics info isn't needed */
+#define CAU_GR_NEED_PRINT 1	/* needed to print values (FLOAT, DOUBLE, ENUM) */
+#define CAU_GR_NEED_ALL	  2	/* needed for all but STRING (units, limits) */
+
+#define CauChanGR(pChan) \
+	((pChan)->grState == CAU_GR_OK ? (pChan)->pGRBuf : NULL)
+
+#ifdef CAU_SHARDS
+#   define CauChanMonitored(pChan) \
+	((pChan)->pEv != NULL || (pChan)->pShard != NULL)
+#else
+#   define CauChanMonitored(pChan) ((pChan)->pEv != NULL)
+#endif
+
+#define CauChanGetCount(pChan) \
+	((pChan)->reqCount > 0 ? (pChan)->reqCount : (pChan)->elCount)
+
+#define CauSigGenFn(pChan) \
+	((pChan)->pSigGen != NULL ? (pChan)->pSigGen->pFn : NULL)
+
+/*/subhead CAU_PATTERN-----------------------------------------------------
+* CAU_PATTERN
+*
+*	A channel name pattern, as given to a command, can contain the
+*	wildcards `*' (any sequence of characters) and `?' (any single
+*	character).  cauPatternCompile splits the pattern at the `*'s
+*	into segments, so that a name is matched by finding the segments
+*	in order, without backtracking.
+*
+*	Patterns select from the channels which are connected.  These are
+*	kept in a sorted index, ppChanSort, which is rebuilt when it's
+*	needed after channels have been added or deleted.  The characters
+*	of the pattern before the first wildcard are used to find, by
+*	binary search, the part of the index which can match; only the
+*	names in that part are checked against the segments.  The
+*	pattern also holds the position in the index, for
+*	cauChanMatchNext.
+*----------------------------------------------------------------------------*/
+
+typedef struct {
+    char	text[db_name_dim];	/* pattern, with '\0' for each '*' */
+    char	*pSeg[db_name_dim];	/* segments of pattern */
+    int		segLen[db_name_dim];	/* length of each segment */
+    int		nSeg;			/* number of segments */
+    int		prefixLen;		/* length before first wildcard */
+    int		ix;			/* position in ppChanSort */
+} CAU_PATTERN;
+
+/*/subhead CAU_SNAP--------------------------------------------------------
+* CAU_SNAP
+*
+*	A snapshot file starts with a CAU_SNAP_HDR, which is followed by
+*	nEntry channels.  Each channel is a CAU_SNAP_ENTRY, then the
+*	channel name (nameLen bytes, with no '\0'), then the channel's
+*	DBR_TIME_xxx buffer (nBytes bytes), for count elements of its
+*	native type.  The file is written in the byte order of the host
+*	which took the snapshot.
+*
+*	While a snapshot is taken or restored, each channel is described
+*	by a CAU_SNAP_ITEM.  restore rejects a file with more than
+*	CAU_SNAP_ENTRY_MAX channels, and an entry whose type isn't valid,
+*	whose nBytes is more than CAU_SNAP_BYTES_MAX, or whose nBytes
+*	isn't the size of a DBR_TIME_xxx buffer for its type and count.
+*----------------------------------------------------------------------------*/
+typedef struct {
+    long	magic;		/* CAU_SNAP_MAGIC */
+    long	version;	/* CAU_SNAP_VERSION */
+    long	nEntry;		/* number of channels in file */
+} CAU_SNAP_HDR;
+typedef struct {
+    short	nameLen;	/* length of name */
+    short	dbfType;	/* native type of channel */
+    long	count;		/* number of elements */
+    long	nBytes;		/* size of DBR_TIME_xxx buffer */
+} CAU_SNAP_ENTRY;
+typedef struct {
+    CAU_CHAN	*pChan;		/* channel */
+    CAU_SNAP_ENTRY entry;	/* entry for file */
+    char	name[db_name_dim];/* channel name */
+    union db_access_val *pBuf;	/* DBR_TIME_xxx buffer */
+    size_t	bufSize;	/* size of pBuf */
+} CAU_SNAP_ITEM;
+
+/*/subhead CAU_GET---------------------------------------------------------
+* CAU_GET
+*
+*	For getMode stream and ordered, each get is sent with
+*	ca_array_get_callback and is described by a CAU_GET in a ring of
+*	CAU_GET_WINDOW records, indexed by the get's sequence number.  The
+*	value is kept in the record's own buffer when it arrives.  Records
+*	are released in sequence order; in ordered mode, values are printed
+*	as they are released (so the ring is the reorder buffer), and in
+*	stream mode they are printed as soon as they arrive.  Each record
+*	has its own timer, so a get which isn't answered times out without
+*	holding up the others longer than CAU_GET_TMO.  When the ring is
+*	full, further channels wait in ppGet until records are released.
+*----------------------------------------------------------------------------*/
+typedef struct {
+    CAU_CHAN	*pChan;		/* channel, or NULL if it's been deleted */
+    long	seq;		/* sequence number */
+    int		state;		/* CAU_GET_xxx */
+    CAU_TMR	tmo;		/* time at which get times out */
+    union db_access_val *pBuf;	/* value, when it has arrived */
+    size_t	bufSize;	/* size of pBuf */
+    chtype	type;		/* DBR type of value in pBuf */
+    long	count;		/* number of elements in pBuf */
+} CAU_GET;
+#define CAU_GET_FREE	0	/* record not in use */
+#define CAU_GET_SENT	1	/* waiting for value */
+#define CAU_GET_OK	2	/* value has arrived */
+#define CAU_GET_FAIL	3	/* error, timeout, or not connected */
+
+#define CAU_GET_MODE_PEND	0	/* batched gets, with ca_pend_io */
+#define CAU_GET_MODE_STREAM	1	/* callback gets, printed on arrival */
+#define CAU_GET_MODE_ORDERED	2	/* callback gets, printed in order */
+
+/*/subhead CAU_POLL--------------------------------------------------------
+* CAU_POLL
+*
+*	Channels which are polled at the same rate are kept in a poll
+*	group.  Each period, when the group's timer comes due, a get is
+*	sent (with ca_array_get_callback) for each channel in the group,
+*	with a single flush, and the values are printed by cauPollDone as
+*	they arrive.  The timer is kept on a fixed schedule of deadlines,
+*	so the sampling doesn't drift.
+*
+*	The difference between a deadline and the time the gets are
+*	actually sent is kept as jitter.  A cycle is counted as missed if
+*	cau was too busy to get to it at all.  A channel whose get from an
+*	earlier cycle is still outstanding when a cycle comes due isn't
+*	sent another; its sample is counted as skipped, and the group's
+*	other channels are sampled as usual, so one slow or hung IOC
+*	doesn't stall the whole group.
+*
+*	Channel Access answers each of a channel's gets once, in order, so
+*	the channel's counts of gets sent and answers received tag each
+*	answer with the get it belongs to.  An answer to a get which was
+*	given up on (because the channel was taken out of its group, and
+*	perhaps put back since) is recognized that way and ignored.
+*----------------------------------------------------------------------------*/
+typedef struct cauPoll {
+    struct cauPoll *pNext;	/* link to next poll group */
+    double	period;		/* seconds between samples */
+    CAU_TMR	next;		/* deadline for next cycle */
+    CX_CMD	*pCxCmd;	/* command context, for dataOut */
+    CAU_CHAN	**ppChan;	/* channels in group */
+    int		chanDim;	/* dimension of ppChan */
+    int		nChan;		/* number of channels in group */
+    long	nCycle;		/* cycles done */
+    long	nMissed;	/* cycles missed */
+    long	nSkipped;	/* samples skipped, get still outstanding */
+    double	jitterSum;	/* sum of jitter, in seconds */
+    double	jitterMax;	/* largest jitter, in seconds */
+} CAU_POLL;
+
+/*/subhead CAU_PING--------------------------------------------------------
+* CAU_PING
+*
+*	The state of a ping (see cau_ping).  Puts of a sequence of values
+*	are sent at a fixed rate; cauMonitor matches each update to its put
+*	by value, and the time from sending the put to receiving the update
+*	is the put's latency.  The value for put seq is
+*	CAU_PING_BASE + seq % modulus (or + seq, if modulus is 0), so the
+*	put for an update is found without searching.
+*
+*	cauMonitor may run in a shard's thread, so nSent, pSendTime,
+*	pLatency, and nRecv are changed only with the channel locked.
+*----------------------------------------------------------------------------*/
+typedef struct cauPing {
+    CAU_CHAN	*pChan;		/* channel being pinged */
+    CX_CMD	*pCxCmd;	/* command context, for printing */
+    CAU_TMR	next;		/* time of next put, or next check */
+    TS_STAMP	endTime;	/* time to stop waiting for updates */
+    double	period;		/* seconds between puts */
+    long	count;		/* number of puts to send */
+    long	nSent;		/* number of puts sent */
+    long	nRecv;		/* number of updates matched to puts */
+    long	modulus;	/* number of distinct values, or 0 */
+    TS_STAMP	*pSendTime;	/* time each put was sent */
+    double	*pLatency;	/* latency of each put, or -1. */
+    int		monAdded;	/* 1 says ping added the monitor */
+} CAU_PING;
+
+#define CAU_PING_COUNT 100	/* default number of puts for ping */
+#define CAU_PING_RATE 10.	/* default puts per second for ping */
+#define CAU_PING_BASE 1		/* value of first put for ping */
+#define CAU_PING_TMO 2.		/* wait for updates after last put, in sec */
+#define CAU_PING_CHECK .05	/* interval for checking for last updates */
+
+/*/subhead CAU_VALUE-------------------------------------------------------
+* CAU_VALUE
+*
+*	A single value of any of the native types, as converted from text
+*	by cauPutConvert.  The member is selected by the channel's dbfType.
+*----------------------------------------------------------------------------*/
+typedef union cauValue {
+    dbr_string_t str;
+    dbr_char_t	chr;
+    dbr_short_t	shrt;
+    dbr_enum_t	enm;
+    dbr_long_t	lng;
+    dbr_float_t	flt;
+    dbr_double_t dbl;
+} CAU_VALUE;
+
+/*/subhead CAU_PUT---------------------------------------------------------
+* CAU_PUT
+*
+*	For putMode callback, each put which hasn't completed yet is
+*	described by a CAU_PUT, on the cau descriptor's list of puts.
+*	The time the put was sent is kept, so that its latency (until
+*	the record finishes processing and the completion arrives) can be
+*	reported.
+*----------------------------------------------------------------------------*/
+typedef struct cauPut {
+    struct cauPut *pPrev;	/* link to previous put */
+    struct cauPut *pNext;	/* link to next put */
+    CAU_CHAN	*pChan;		/* channel */
+    CX_CMD	*pCxCmd;	/* command context, for dataOut */
+    TS_STAMP	sendTime;	/* time put was sent */
+} CAU_PUT;
+
+#define CAU_PUT_MODE_PEND	0	/* puts with ca_pend_io */
+#define CAU_PUT_MODE_CALLBACK	1	/* puts with ca_put_callback */
+
+/*/subhead CAU_ARRAY-------------------------------------------------------
+* CAU_ARRAY
+*
+*	An array value for put, as the channel's native type.  Inline
+*	values and text files are converted into a buffer from cauBufGet.
+*	A binary file is already in the native type, so its elements are
+*	put straight from the file's mapping, without being copied.
+*	cauArrayRelease frees whichever was used.
+*----------------------------------------------------------------------------*/
+typedef struct {
+    void	*pData;		/* pointer to first element */
+    unsigned long count;	/* number of elements */
+    void	*pBuf;		/* buffer from cauBufGet, or NULL */
+    size_t	bufSize;	/* size of pBuf, in bytes */
+    char	*pFile;		/* contents of file, or NULL */
+    size_t	fileSize;	/* size of file, in bytes */
+    int		fileMapped;	/* 1 says pFile is a mapping, else malloc'd */
+} CAU_ARRAY;
+
+#define CAU_ARRAY_NUM_DIM 40	/* longest number in an array value */
+
+/*/subhead CAU_HOST--------------------------------------------------------
+* CAU_HOST
+*
+*	A host descriptor is kept for each IOC host which has had a
+*	channel come back with a different native type or count.  The
+*	channels are re-armed (buffer resized and monitor placed again)
+*	from cauTask, when the host's retry timer comes due, rather than
+*	in the connection handler; when a whole IOC reboots, its channels
+*	are done together, and a burst of reconnects doesn't hold up the
+*	processing loop.  The first attempt is CAU_REARM_MIN seconds
+*	after the reconnect; if any channel can't be re-armed, the wait
+*	is doubled for the next attempt, up to CAU_REARM_MAX.
+*----------------------------------------------------------------------------*/
+typedef struct cauHost {
+    struct cauHost *pNext;	/* link to next host */
+    char	name[CAU_HOST_NAME_DIM];/* host name, from ca_host_name */
+    double	backoff;	/* seconds before next re-arm attempt */
+    CAU_TMR	retry;		/* time of next re-arm attempt */
+    CAU_CHAN	*pRearmHead;	/* channels waiting to be re-armed */
+    TS_STAMP	putNext;	/* earliest time for next put, for putRate */
+    long	nPutSent;	/* puts sent, for putRate */
+    long	nPutCoalesced;	/* puts replaced before being sent */
+} CAU_HOST;
+
+#ifdef CAU_MMAP_CACHE
+/*/subhead CAU_CACHE-------------------------------------------------------
+* CAU_CACHE
+*
+*	The metadata cache is a file, mapped into memory, holding the
+*	native type, element count, and DBR_CTRL_xxx information for
+*	channels, keyed by channel name.  When a channel's graphics
+*	information is needed and the cache has an entry with the same
+*	native type and count, the cached information is used at once
+*	(grCached is set) and the live DBR_CTRL_xxx request isn't waited
+*	for.  When the live information arrives, cauChanGR replaces the
+*	cached copy and the cache entry is brought up to date.
+*
+*	The file is a CAU_CACHE_HDR followed by fixed size entries.  It
+*	holds binary data for the host it was written on; a file with a
+*	different magic number, version, or entry size isn't used.  The
+*	index to the entries is a hash table which is built when the file
+*	is opened.
+*----------------------------------------------------------------------------*/
+typedef struct {
+    long	magic;		/* CAU_CACHE_MAGIC */
+    long	version;	/* CAU_CACHE_VERSION */
+    long	entrySize;	/* sizeof(CAU_CACHE_ENTRY) */
+    long	nEntry;		/* number of entries in use */
+} CAU_CACHE_HDR;
+
+typedef struct {
+    char	name[db_name_dim];/* channel name */
+    short	dbfType;	/* native type of channel */
+    long	elCount;	/* native count of channel */
+    union db_access_val gr;	/* DBR_CTRL_xxx information */
+} CAU_CACHE_ENTRY;
+
+typedef struct {
+    int		fd;		/* cache file, or -1 if no cache */
+    char	path[80];	/* path of cache file */
+    size_t	mapSize;	/* size of mapping, in bytes */
+    CAU_CACHE_HDR *pHdr;	/* mapped file */
+    CAU_CACHE_ENTRY *pEntry;	/* entries, following header */
+    long	dim;		/* number of entries file has room for */
+    long	*pHash;		/* hash table of entry index + 1 */
+    long	hashDim;	/* dimension of pHash; power of 2 */
+    unsigned long nHit;		/* lookups which found a usable entry */
+    unsigned long nMiss;	/* lookups with no entry */
+    unsigned long nStale;	/* entries with wrong type or count */
+    unsigned long nChanged;	/* entries changed by live information */
+} CAU_CACHE;
+#endif
+
+#ifdef CAU_SHARDS
+/*/subhead CAU_SHARD-------------------------------------------------------
+* CAU_SHARD
+*
+*	A shard is a preemptive Channel Access context, with its own
+*	thread, which handles monitors for part of the channels.  When
+*	cau has shards, each monitored channel is given to a shard based
+*	on a hash of its name; the shard makes its own connection to the
+*	channel and keeps it on the shard's channel list.  Monitor
+*	callbacks run in the shard's Channel Access threads and print
+*	into the shard's own output buffer; cauTask merges the output
+*	from all the shards into dataOut.
+*
+*	cauTask asks a shard to start and stop monitors by way of the
+*	shard's op queue.  The channel's monitor buffer, time of last
+*	monitor, and the shard's output buffer are protected by the
+*	shard's lock.
+*
+*	Each channel monitored by a shard also has a back buffer, which
+*	only the shard uses.  cauMonitor copies an update into the back
+*	buffer without the lock (marking the channel's bufBackBusy, so the
+*	buffer isn't replaced meanwhile), and then, with the lock, swaps
+*	it with the monitor buffer.  So the lock is never held for the copy of a
+*	large array, and cauTask, holding the lock, always sees a whole
+*	update.
+*
+*	The shard can't allocate buffers (the pools belong to cauTask), so
+*	an update too big for the back buffer is dropped.  The drop is
+*	counted, for the channel and for the shard, and the size needed
+*	is left in the channel's bufBackNeed; cauShardGrow, in cauTask,
+*	then grows both buffers, with the lock, so later updates fit.
+*----------------------------------------------------------------------------*/
+typedef struct cauShard {
+    int		ix;		/* index of shard */
+    struct ca_client_context *pCtx;/* shard's CA context, or NULL */
+    epicsMutexId lock;		/* lock for monitor data and output */
+    epicsRingBytesId opQueue;	/* CAU_SHARD_OP's from cauTask */
+    epicsEventId opEvent;	/* signalled when an op is queued */
+    epicsEventId opDoneEvent;	/* signalled when ops have been done */
+    volatile long nOpPut;	/* number of ops put into opQueue */
+    volatile long nOpDone;	/* number of ops done by shard */
+    volatile int stop;		/* shard requested to stop if != 0 */
+    volatile int stopped;	/* shard has stopped if != 0 */
+    CAU_CHAN	*pChanHead;	/* pointer to head of shard's channel list */
+    CAU_CHAN	*pChanTail;	/* pointer to tail of shard's channel list */
+    int		nChan;		/* number of channels on list */
+    unsigned long nMon;		/* number of monitor events handled */
+    unsigned long nDrop;	/* updates dropped, buffer too small */
+    int		nGrow;		/* channels waiting for bigger buffers */
+    CAU_TMR_HEAP deadTimeHeap;	/* heap of channel deadTime timers */
+    TS_STAMP	deadTimeWait;	/* time to which shard thread is waiting */
+    FILE	*out[2];	/* output streams, used alternately */
+    char	*outBuf[2];	/* buffers for out[] */
+    size_t	outSize[2];	/* number of bytes in outBuf[] */
+    int		outIx;		/* index of out[] presently being written */
+} CAU_SHARD;
+
+typedef struct {
+    int		op;		/* CAU_SHARD_MON or CAU_SHARD_MON_STOP */
+    CAU_CHAN	*pChan;		/* channel to start or stop monitoring */
+} CAU_SHARD_OP;
+#define CAU_SHARD_MON		1	/* connect channel and start monitor */
+#define CAU_SHARD_MON_STOP	2	/* stop monitor and disconnect */
+
+#   define CauChanLock(pChan) \
+	{if ((pChan)->pShard != NULL) epicsMutexMustLock((pChan)->pShard->lock);}
+#   define CauChanUnlock(pChan) \
+	{if ((pChan)->pShard != NULL) epicsMutexUnlock((pChan)->pShard->lock);}
+#else
+#   define CauChanLock(pChan)
+#   define CauChanUnlock(pChan)
+#endif
 
 /*/subhead CAU_DESC-------------------------------------------------------
 * CAU_DESC
@@ -175,6 +767,18 @@ typedef struct {
     jmp_buf	sigEnv;		/* environment for longjmp at signal time */
 } CAU_TASK_INFO;
 
+/*----------------------------------------------------------------------------
+*    a command line passed from cauInTask to cauTask through the command
+*    queue.  The line is already parsed by cmdRead; the parse state is
+*    kept as offsets into the line.
+*---------------------------------------------------------------------------*/
+typedef struct {
+    char	line[80];	/* input line, as parsed by cmdRead */
+    short	commandIx;	/* offset of pCommand in line */
+    short	lineIx;		/* offset of pLine in line */
+    char	delim;		/* delimiter of command field */
+} CAU_CMD_LINE;
+
 typedef struct cauDesc {
 #ifdef vxWorks
     SEM_ID	semLock;
@@ -187,10 +791,76 @@ typedef struct cauDesc {
     CAU_CHAN	*pChanTail;	/* pointer to tail of channel list */
     CAU_CHAN	*pChanConnHead;	/* pointer to head of channel connect list */
     CAU_CHAN	*pChanConnTail;	/* pointer to tail of channel connect list */
+    long	connBatch;	/* number of present connect batch */
+    int		nConnWait;	/* channels in batch still being waited for */
+    long	grBatch;	/* number of present graphics info batch */
+    int		nGRWait;	/* graphics info in batch still being waited for */
+    CAU_CHAN	**ppChanHash;	/* hash table of channels, by name */
+    int		chanHashDim;	/* dimension of ppChanHash; power of 2 */
+    int		nChanHash;	/* number of channels in ppChanHash */
+    CAU_CHAN	**ppChanSort;	/* connected channels, sorted by name */
+    int		chanSortDim;	/* dimension of ppChanSort */
+    int		nChanSort;	/* number of channels in ppChanSort */
+    int		chanSortValid;	/* 0 says ppChanSort must be rebuilt */
+    CAU_CHAN	**ppGet;	/* channels for the present get, in order */
+    int		getDim;		/* dimension of ppGet */
+    int		nGet;		/* number of channels in ppGet */
+    int		getWaitIx;	/* first channel in ppGet not yet sent */
+    int		getMode;	/* CAU_GET_MODE_xxx */
+    CAU_GET	*pGetRing;	/* ring of streamed gets */
+    long	getSeqIn;	/* sequence number for next streamed get */
+    long	getSeqOut;	/* sequence number of oldest streamed get */
+    CX_CMD	*pGetCxCmd;	/* root command context, for streamed gets */
+    CAU_TMR_HEAP getHeap;	/* heap of streamed get timeouts */
     double	secPerStep;	/* seconds per step for signal generation */
     int		nSteps;		/* number of steps per cycle for sig gen */
     double	begVal;		/* begin value for generated signal */
     double	endVal;		/* end value for generated signal */
+    CAU_TMR_HEAP sigGenHeap;	/* heap of sig gen step times */
+    CAU_TMR_HEAP deadTimeHeap;	/* heap of channel deadTime timers */
+    CAU_HOST	*pHostHead;	/* list of IOC hosts */
+    CAU_POLL	*pPollHead;	/* list of poll groups */
+    CAU_TMR_HEAP pollHeap;	/* heap of poll group timers */
+    CAU_PING	*pPing;		/* ping in progress, or NULL */
+    CAU_TMR_HEAP pingHeap;	/* heap of ping timer */
+    int		putMode;	/* CAU_PUT_MODE_xxx */
+    CAU_PUT	*pPutHead;	/* puts waiting for completion */
+    CAU_PUT	*pPutTail;
+    long	nPutOut;	/* number of puts waiting for completion */
+    long	nPutDone;	/* number of puts completed */
+    double	putLatSum;	/* sum of put latencies, in seconds */
+    double	putLatMax;	/* largest put latency, in seconds */
+    CAU_POOL	putPool;	/* pool of CAU_PUT's */
+    double	putChanRate;	/* max puts/sec per channel; 0 for no limit */
+    double	putHostRate;	/* max puts/sec per IOC host; 0 for no limit */
+    CAU_TMR_HEAP putHeap;	/* heap of held put timers */
+    long	nPutSent;	/* puts sent */
+    long	nPutCoalesced;	/* puts replaced by a later value */
+    long	nPutDropped;	/* held puts dropped by disconnect */
+    CAU_TMR_HEAP rearmHeap;	/* heap of host re-arm timers */
+    CAU_POOL	chanPool;	/* pool of CAU_CHAN's */
+    CAU_POOL	sigGenPool;	/* pool of CAU_SIGGEN's */
+#ifdef CAU_MMAP_CACHE
+    CAU_CACHE	cache;		/* metadata cache */
+#endif
+    CAU_POOL	bufPool[CAU_BUF_CLASS_DIM];/* pools of value buffers */
+    long	nBufLarge;	/* buffers too large for bufPool, in use */
+    unsigned long nBufLargeGet;	/* number of large buffers malloc'd */
+    int		caFd[CAU_CA_FD_DIM];/* fd's registered by Channel Access */
+    int		nCaFd;		/* number of fd's in caFd */
+    int		caFdLost;	/* 1 says some fd's couldn't be watched */
+#ifndef vxWorks
+    epicsRingBytesId cmdQueue;	/* CAU_CMD_LINE's from cauInTask */
+    epicsEventId cmdQueueSpace;	/* signalled when cauTask takes a line */
+    epicsEventId cmdDoneEvent;	/* signalled when a command is done */
+    volatile long nCmdPut;	/* number of lines put into cmdQueue */
+    volatile long nCmdDone;	/* number of commands done by cauTask */
+    int		cmdWakeFd[2];	/* pipe to wake cauTask; -1 if none */
+#endif
+#ifdef CAU_SHARDS
+    CAU_SHARD	*pShard;	/* array of shards, or NULL */
+    int		nShard;		/* number of shards; 0 if none */
+#endif
 } CAU_DESC;
 
 /*-----------------------------------------------------------------------------
@@ -198,6 +868,7 @@ typedef struct cauDesc {
 *----------------------------------------------------------------------------*/
 int cau();
 static void cauCaException();
+static void cauCaFdReg();
 static void cauCmdProcess();
 static long cauTask();
 #ifdef vxWorks
@@ -206,44 +877,169 @@ static long cauInit();
 #endif
 static void cauTaskSigHandler();
 static char *cauInTask();
+#ifndef vxWorks
+static void cauInThread();
+static long cauInTaskWait();
+static long cauCmdQueueInit();
+static void cauCmdQueueFree();
+static char *cauCmdQueueGet();
+static long cauCmdQueuePut();
+#endif
+static void cauDataOut();
+static void cau_cache();
 static void cau_deadband();
 static void cau_debug();
 static void cau_delete();
 static void cau_get();
+static void cau_getMode();
 static void cau_info();
 static void cau_interval(), cau_interval_deadTime_test();
+static void cau_load();
 static void cau_monitor();
+static void cau_ping();
+static void cau_poll();
+static void cau_pools();
 static void cau_put();
+static void cau_putMode();
+static void cau_putRate();
 static void cau_ramp();
+static void cau_restore();
+static void cau_shards();
+static void cau_snapshot();
 
+static long cauArrayFile();
+static long cauArrayLoad();
+static long cauArrayParse();
+static void cauArrayRelease();
+static void *cauBufGet();
+static void cauBufPut();
+#ifdef CAU_MMAP_CACHE
+static void cauCacheClose();
+static CAU_CACHE_ENTRY *cauCacheFind();
+static long cauCacheGet();
+static long cauCacheIndex();
+static long cauCacheMap();
+static long cauCacheOpen();
+static void cauCachePut();
+#endif
 static CAU_CHAN * cauChanAdd();
+static void cauChanAddList();
+static CAU_CHAN * cauChanAddStart();
+static void cauChanConn();
+static void cauChanConnWait();
+static long cauChanBufNeed();
+static void cauChanEnumHash();
+static int cauChanEnumLookup();
+static void cauChanConnDown();
+static void cauChanConnUp();
 static long cauChanDel();
 static CAU_CHAN *cauChanFind();
+static void cauChanGR();
+static void cauChanGRAll();
+static void cauChanGRUnits();
+static union db_access_val *cauChanGRFetch();
+static int cauChanGRNeeded();
+static void cauChanGRRequest();
+static void cauChanGRWait();
+static CAU_HOST *cauHostFind();
+static void cauPingDone();
+static void cauPingMatch();
+static void cauPingRun();
+static void cauPollChanDel();
+static void cauPollDone();
+static void cauPollRun();
+static long cauPutConvert();
+static void cauPutChanDel();
+static void cauPutCharge();
+static void cauPutDone();
+static CAU_HOST *cauPutHost();
+static long cauPutLimit();
+static void cauPutRange();
+static void cauPutRelease();
+static long cauPutSend();
+static long cauPutStart();
+static void cauPutWhen();
+static void cauHostRearm();
+static void cauHostRearmDel();
+static long cauChanRearm();
+static long cauChanHashAdd();
+static void cauChanHashDel();
+static CAU_CHAN *cauChanLookup();
+static CAU_CHAN *cauChanMatchFirst();
+static CAU_CHAN *cauChanMatchNext();
+static long cauChanSort();
 static long cauFree();
 static void cauGetAndPrint();
+static void cauGetChanDel();
+static void cauGetDone();
+static void cauGetEmit();
+static long cauGetQueue();
+static int cauGetRelease();
+static void cauGetSend();
+static void cauGetTimeout();
 static void cauInitAtStartup();
 static void cauMonitor();
+static long cauMonitorAdd();
+static void cauMonitorClear();
+static unsigned long cauNameHash();
+static int cauNameLen();
+static int cauPatternCompile();
+static int cauPatternMatch();
+static void *cauPoolGet();
+static void cauPoolInit();
+static void cauPoolPut();
+static void cauPoolRelease();
+static void cauPoolShow();
 static void cauPrintBuf();
 static void cauPrintBufArray();
 static void cauPrintInfo();
+#ifdef CAU_SHARDS
+static long cauShardBufNeed();
+static void cauShardConn();
+static void cauShardGrow();
+static void cauShardMerge();
+static void cauShardOpDo();
+static long cauShardOpPut();
+static long cauShardStart();
+static void cauShardStop();
+static void cauShardSync();
+static void cauShardTask();
+static long cauShardsSet();
+#endif
 static void cauSigGen();
 static long cauSigGenGetParams();
 static long cauSigGenPut();
 static long cauSigGenRamp();
 static void cauSigGenRampAdd();
+static void cauSigGenStop();
+static long cauTmrArm();
+static void cauTmrCancel();
+static int cauTmrDue();
+static void cauTmrSift();
+static void cauWait();
+static void cauWaitLimit();
 
 /*-----------------------------------------------------------------------------
 * global definitions
 *----------------------------------------------------------------------------*/
 static CX_CMD		glCauCxCmd;
 static CX_CMD		*pglCauCxCmd=NULL;
+#ifndef vxWorks
+static CX_CMD		glCauCxCmdTask;	/* cauTask's own command context */
+#endif
 static CAU_DESC		glCauDesc;
 static CAU_DESC		*pglCauDesc=NULL;
 static int		glCauDebug=0;
 
+static HELP_TOPIC	helpCache;	/* help info--cache command */
 static HELP_TOPIC	helpDebug;	/* help info--debug command */
 static HELP_TOPIC	helpInterval;	/* help info--interval command */
+static HELP_TOPIC	helpLoad;	/* help info--load command */
+static HELP_TOPIC	helpPut;	/* help info--put command */
+static HELP_TOPIC	helpPutRate;	/* help info--putRate command */
 static HELP_TOPIC	helpRamp;	/* help info--ramp command */
+static HELP_TOPIC	helpShards;	/* help info--shards command */
+static HELP_TOPIC	helpSnapshot;	/* help info--snapshot command */
 static unsigned long glCauDeadband=DBE_VALUE | DBE_ALARM;
 static char	*glCauMDEL_msg="prior to ca_add_masked_array_event (MDEL)";
 static char	*glCauADEL_msg="prior to ca_add_masked_array_event (ADEL)";
@@ -441,10 +1237,64 @@ struct exception_handler_args arg;
                 dbr_type_to_text(arg.type),
                 arg.count);
 }
+
+/*+/subr**********************************************************************
+* NAME	cauCaFdReg - keep track of Channel Access file descriptors
+*
+* DESCRIPTION
+*	Called by Channel Access (by way of ca_add_fd_registration) when
+*	it opens or closes a file descriptor.  The descriptors are kept
+*	in the cau descriptor, so that cauWait can include them in its
+*	select().
+*
+*	If there are more descriptors than will fit, the caFdLost flag is
+*	set; cauWait then falls back to waking up every CAU_WAIT_POLL
+*	seconds.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauCaFdReg(pArg, fd, opened)
+void	*pArg;		/* I pointer to cau descriptor */
+int	fd;		/* I file descriptor */
+int	opened;		/* I 1 if fd was opened, 0 if closed */
+{
+    CAU_DESC	*pCauDesc=(CAU_DESC *)pArg;
+    int		i;
+
+    if (opened) {
+	if (pCauDesc->nCaFd < CAU_CA_FD_DIM)
+	    pCauDesc->caFd[pCauDesc->nCaFd++] = fd;
+	else
+	    pCauDesc->caFdLost = 1;
+	return;
+    }
+    for (i=0; i<pCauDesc->nCaFd; i++) {
+	if (pCauDesc->caFd[i] == fd) {
+	    pCauDesc->caFd[i] = pCauDesc->caFd[--pCauDesc->nCaFd];
+	    break;
+	}
+    }
+}
+
 /*+/subr**********************************************************************
 * NAME	cauTask - main processing task for cau
 *
 * DESCRIPTION
+*	Initializes Channel Access and then runs the processing loop,
+*	which handles Channel Access events, signal generation, interval
+*	testing, and commands from cauInTask.
+*
+*	Under VxWorks, cauInTask is a separate task which has been spawned
+*	by cau(); commands are handed over with the serviceNeeded and
+*	serviceDone flags.  On other hosts, cauTask starts cauInTask as a
+*	thread and takes commands from the command queue, one per pass
+*	through the loop, so that a long source'd file doesn't hold up
+*	Channel Access events.  Commands are then processed in a command
+*	context belonging to cauTask, while cauInTask keeps the keyboard
+*	and source'd file contexts for itself.
 *
 * RETURNS
 *	OK, or
@@ -460,14 +1310,20 @@ CX_CMD	**ppCxCmd;
 {
     long	stat;
     CX_CMD	*pCxCmd;
-    int		loopCount;
     int		sigNum;
-
-    pCxCmd = *ppCxCmd;
+    TS_STAMP	now;		/* present time */
+#ifndef vxWorks
+    int		i;
+#endif
 
 #ifdef vxWorks
+    pCxCmd = *ppCxCmd;
     CauLockInitAndLock;
     CauUnlock;
+#else
+    glCauCxCmdTask = **ppCxCmd;	/* inherit help, output, etc. */
+    glCauCxCmdTask.pCxCmdRoot = &glCauCxCmdTask;
+    pCxCmd = pglCauDesc->pCxCmd = &glCauCxCmdTask;
 #endif
 
     genSigInit(cauTaskSigHandler);
@@ -476,44 +1332,81 @@ CX_CMD	**ppCxCmd;
 	goto cauTaskWrapup;
     }
 
+#if !defined(vxWorks) && !defined(_WIN32)
+/*----------------------------------------------------------------------------
+*    with stdin unbuffered, a line which has been typed (or pasted) but
+*    not yet read is still visible to select()
+*---------------------------------------------------------------------------*/
+    (void)setvbuf(stdin, NULL, _IONBF, 0);
+#endif
+
     stat = ca_task_initialize();
     assert(stat == ECA_NORMAL);
     stat = ca_add_exception_event(cauCaException, NULL);
     assert(stat == ECA_NORMAL);
+    stat = ca_add_fd_registration(cauCaFdReg, pglCauDesc);
+    assert(stat == ECA_NORMAL);
+
+#ifndef vxWorks
+    if (cauCmdQueueInit(pglCauDesc) != OK)
+	goto cauTaskWrapup;
+    pglCauDesc->cauInTaskInfo.stopped = 0;
+    if (epicsThreadCreate("cauInTask", epicsThreadPriorityMedium,
+		epicsThreadGetStackSize(epicsThreadStackMedium),
+		cauInThread, (void *)ppCxCmd) == NULL) {
+	(void)printf("error spawning cauInTask\n");
+	pglCauDesc->cauInTaskInfo.stopped = 1;
+	goto cauTaskWrapup;
+    }
+    pglCauDesc->cauInTaskInfo.status = OK;
+#endif
 
 /*----------------------------------------------------------------------------
 *    "processing loop"
+*	Each pass waits until there is something to do--Channel Access
+*	activity, a command, or a signal generator step or deadTime
+*	check coming due--and then does it.
 *---------------------------------------------------------------------------*/
-    loopCount = 10;
     while (!pglCauDesc->cauTaskInfo.stop) {
-	cauCaDebug("main loop, prior to ca_pend_event(0.001)", 2);
-	stat = ca_pend_event(0.001);
-	cauCaDebugStat("main loop, back from ca_pend_event(0.001)", stat, 2);
-	assert(stat != ECA_EVDISALLOW);
-	cauSigGen(pCxCmd, pglCauDesc);
-	if (--loopCount <= 0) {
-	    loopCount = 10;
-	    cau_interval_deadTime_test(pglCauDesc);
+	cauWait(pCxCmd, pglCauDesc);
+#ifdef CAU_SHARDS
+	if (pglCauDesc->nShard > 0) {
+	    cauShardGrow(pglCauDesc);
+	    cauShardMerge(pCxCmd, pglCauDesc);
 	}
-#ifndef vxWorks
-	cauInTask(ppCxCmd);
 #endif
+	(void)epicsTimeGetCurrent(&now);
+	if (cauTmrDue(&pglCauDesc->sigGenHeap, &now))
+	    cauSigGen(pCxCmd, pglCauDesc);
+	if (cauTmrDue(&pglCauDesc->deadTimeHeap, &now))
+	    cau_interval_deadTime_test(&pglCauDesc->deadTimeHeap,
+							pCxCmd->dataOut);
+	if (cauTmrDue(&pglCauDesc->rearmHeap, &now))
+	    cauHostRearm(pCxCmd, pglCauDesc);
+	if (cauTmrDue(&pglCauDesc->getHeap, &now))
+	    cauGetTimeout(pglCauDesc);
+	if (cauTmrDue(&pglCauDesc->pollHeap, &now))
+	    cauPollRun(pglCauDesc);
+	if (cauTmrDue(&pglCauDesc->putHeap, &now))
+	    cauPutRelease(pglCauDesc);
+	if (cauTmrDue(&pglCauDesc->pingHeap, &now))
+	    cauPingRun(pglCauDesc);
+#ifdef vxWorks
 	if (pglCauDesc->cauInTaskInfo.serviceNeeded) {
 	    cauCmdProcess(ppCxCmd, pglCauDesc);
 	    pCxCmd = *ppCxCmd;
 	    pglCauDesc->cauInTaskInfo.serviceNeeded = 0;
 	    pglCauDesc->cauInTaskInfo.serviceDone = 1;
 	}
-#ifdef vxWorks		/* fprintf on vxWorks not flushed on \n */
-	fflush(stdout);
+	fflush(stdout);		/* fprintf on vxWorks not flushed on \n */
 	fflush(pCxCmd->dataOut);
 	fflush(stderr);
-	taskSleep(SELF, 0, 100000);	/* wait .1 sec */
 #else
-	sleep(1);
-/* MDA - usleep isn't POSIX
-	usleep(100000);
-*/
+	if (cauCmdQueueGet(pCxCmd, pglCauDesc) != NULL) {
+	    cauCmdProcess(&pCxCmd, pglCauDesc);
+	    pglCauDesc->nCmdDone++;
+	    epicsEventSignal(pglCauDesc->cmdDoneEvent);
+	}
 #endif
     }
 
@@ -521,9 +1414,24 @@ cauTaskWrapup:
     stat = cauFree(pCxCmd, pglCauDesc);
     assert(stat == OK);
 
+#ifndef vxWorks
+/*----------------------------------------------------------------------------
+*    stop cauInTask before closing its source'd files.  If it is stuck
+*    reading a partial line from the keyboard, don't wait for it.
+*---------------------------------------------------------------------------*/
+    pglCauDesc->cauInTaskInfo.stop = 1;
+    for (i=0; i<20 && !pglCauDesc->cauInTaskInfo.stopped; i++)
+	epicsThreadSleep(.1);
+    if (pglCauDesc->cauInTaskInfo.stopped) {
+	while ((*ppCxCmd)->pPrev != NULL)
+	    cmdCloseContext(ppCxCmd);
+	cauCmdQueueFree(pglCauDesc);
+    }
+#else
     while ((*ppCxCmd)->pPrev != NULL)
 	cmdCloseContext(ppCxCmd);
     pCxCmd = *ppCxCmd;
+#endif
 
     stat = ca_task_exit();
     if (stat != ECA_NORMAL) {
@@ -552,7 +1460,7 @@ cauTaskWrapup:
 
     return 0;
 }
-
+
 /*+/subr**********************************************************************
 * NAME	cauTaskCheck - check on a task
 *
@@ -645,7 +1553,9 @@ int	signo;
 *	    and this task wraps itself up and returns.
 *	o   if the command is "dataOut", this task sets a new destination
 *	    for data output, closing the previous destination, if appropriate,
-*	    and opening the new destination, if appropriate.
+*	    and opening the new destination, if appropriate.  (Except
+*	    under VxWorks, dataOut is passed to cauTask, which owns
+*	    the data output.)
 *	o   if the command is "bg", this task wraps itself up and returns.
 *	    A flag is left in the command context indicating that cauInTask
 *	    doesn't exist any more.
@@ -658,6 +1568,15 @@ int	signo;
 *	    goes into a sleeping loop until cauTask signals
 *	    that it is ready for the next command.
 *
+*	Except under VxWorks, this task runs as a thread, started by
+*	cauTask.  Instead of waiting for each command to be done, the
+*	command line is put into the command queue and cauTask is woken
+*	up.  Lines from a source'd file are queued as fast as cauTask
+*	will take them (waiting only if the queue is full); before
+*	prompting for keyboard input, this task waits until cauTask has
+*	finished all queued commands, so that the prompt follows the
+*	output from the previous command.
+*
 *	Ideally, this task would also support a mechanism for cauTask
 *	to wait explicitly for keyboard input.  An example would be when
 *	operator permission is needed prior to taking an action.
@@ -690,38 +1609,22 @@ CX_CMD	**ppCxCmd;	/* IO ptr to pointer to command context */
 		goto cauInTaskDone;
 	    taskSleep(SELF, 0, 500000);		/* sleep .5 sec */
 	}
+#else
+	if ((*ppCxCmd)->inputName == NULL) {
+	    if (cauInTaskWait(*ppCxCmd, pglCauDesc) != OK)
+		goto cauInTaskDone;
+	}
 #endif
 
 	input = cmdRead(ppCxCmd);
 
-#ifdef vxWorks
 	if (pglCauDesc->cauInTaskInfo.stop == 1)
 	    goto cauInTaskDone;
-#endif
 	if (input == NULL)
-#ifdef vxWorks
 	    ;
-#else
-	    goto cauInTaskDone;
-#endif
-	else if (strcmp((*ppCxCmd)->pCommand,		"dataOut") == 0) {
-	    if ((*ppCxCmd)->dataOutRedir)
-		fclose ((*ppCxCmd)->dataOut);
-	    (*ppCxCmd)->dataOutRedir = 0;
-	    if (nextNonSpaceField( &(*ppCxCmd)->pLine, &(*ppCxCmd)->pField,
-							&(*ppCxCmd)->delim) < 1)
-		(*ppCxCmd)->dataOut = stdout;
-	    else {
-		(*ppCxCmd)->dataOut = fopen((*ppCxCmd)->pField, "a");
-		if ((*ppCxCmd)->dataOut == NULL) {
-		    (void)printf("couldn't open %s\n", (*ppCxCmd)->pField);
-		    (*ppCxCmd)->dataOut = stdout;
-		}
-		else
-		    (*ppCxCmd)->dataOutRedir = 1;
-	    }
-	}
 #ifdef vxWorks
+	else if (strcmp((*ppCxCmd)->pCommand,		"dataOut") == 0)
+	    cauDataOut(*ppCxCmd);
 	else if (strcmp((*ppCxCmd)->pCommand,		"bg") == 0) {
 	    if (cmdBgCheck(*ppCxCmd) == OK)
 		goto cauInTaskDone;
@@ -731,15 +1634,22 @@ CX_CMD	**ppCxCmd;	/* IO ptr to pointer to command context */
 	    pglCauDesc->cauInTaskInfo.serviceNeeded = 1;
 	    goto cauInTaskDone;
 	}
+#else
+	else if (strcmp((*ppCxCmd)->pCommand,		"quit") == 0) {
+	    (void)cauCmdQueuePut(*ppCxCmd, pglCauDesc);
+	    goto cauInTaskDone;
+	}
 #endif
 	else if (strcmp((*ppCxCmd)->pCommand,		"source") == 0) {
 	    cmdSource(ppCxCmd);
 	}
 	else {
+#ifdef vxWorks
 	    pglCauDesc->cauInTaskInfo.serviceDone = 0;
 	    pglCauDesc->cauInTaskInfo.serviceNeeded = 1;
-#ifndef vxWorks
-	    goto cauInTaskDone;
+#else
+	    if (cauCmdQueuePut(*ppCxCmd, pglCauDesc) != OK)
+		goto cauInTaskDone;
 #endif
 	}
     }
@@ -751,45 +1661,128 @@ cauInTaskDone:
 
     if (pglCauDesc->showStack)
 	checkStack(pglCauDesc->cauInTaskInfo.id);
+#endif
     pglCauDesc->cauInTaskInfo.stop = 1;
     pglCauDesc->cauInTaskInfo.stopped = 1;
     pglCauDesc->cauInTaskInfo.status = ERROR;
-#endif
 
     return input;
 }
-
+
+#ifndef vxWorks
 /*+/subr**********************************************************************
-* NAME	cauCmdProcess - process a command line
+* NAME	cauInThread - thread entry for cauInTask
 *
 * DESCRIPTION
+*	Blocks the signals which cauTask catches, so that they are
+*	delivered to cauTask (whose signal handler longjmp's within
+*	cauTask), and then runs cauInTask.
 *
 * RETURNS
 *	void
 *
-* BUGS
-* o	text
-*
 *-*/
 static void
-cauCmdProcess(ppCxCmd, pCauDesc)
-CX_CMD	**ppCxCmd;	/* IO ptr to pointer to command context */
+cauInThread(pArg)
+void	*pArg;		/* I ptr to pointer to command context */
+{
+#ifndef _WIN32
+    sigset_t	sigSet;
+
+    (void)sigfillset(&sigSet);
+    (void)pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
+#endif
+    (void)cauInTask((CX_CMD **)pArg);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauInTaskWait - wait until it's time to read the keyboard
+*
+* DESCRIPTION
+*	Waits until cauTask has done all the commands in the command
+*	queue and then (except for WIN32, where cmdRead waits) until
+*	a line is available from the keyboard.  The waits are done in
+*	short pieces, so that a request to stop is noticed.
+*
+* RETURNS
+*	OK, or
+*	ERROR if cauInTask has been asked to stop
+*
+*-*/
+static long
+cauInTaskWait(pCxCmd, pCauDesc)
+CX_CMD	*pCxCmd;	/* I pointer to command context */
 CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 {
-    CX_CMD	*pCxCmd;	/* local copy of pointer, for convenience */
+#ifndef _WIN32
+    fd_set	fdSet;		/* set of fd's to watch with select */
+    struct timeval fdSetTimeout;/* timeout interval for select */
+#endif
 
-    pCxCmd = *ppCxCmd;
-    if (strcmp(pCxCmd->pCommand,			"quit") == 0) {
-	/* insert wrapup processing here */
-	pCauDesc->cauTaskInfo.stop = 1;
+    while (pCauDesc->nCmdDone != pCauDesc->nCmdPut) {
+	if (pCauDesc->cauInTaskInfo.stop)
+	    return ERROR;
+	(void)epicsEventWaitWithTimeout(pCauDesc->cmdDoneEvent, .5);
     }
-#ifdef vxWorks
-    else if (strcmp(pCxCmd->pCommand,			"showStack") == 0)
-	pCauDesc->showStack = 1;
-#endif
-    else if (strcmp(pCxCmd->pCommand,			"deadband") == 0)
-	cau_deadband(pCxCmd);
-    else if (strcmp(pCxCmd->pCommand,			"debug") == 0)
+    if (pCxCmd->inputEOF)
+	return OK;
+#ifndef _WIN32
+    while (1) {
+	if (pCauDesc->cauInTaskInfo.stop)
+	    return ERROR;
+	if (pCxCmd->prompt != NULL && pCxCmd->promptFlag) {
+	    (void)printf("%s", pCxCmd->prompt);
+	    (void)fflush(stdout);
+	    pCxCmd->promptFlag = 0;
+	}
+	FD_ZERO(&fdSet);
+	FD_SET(fileno(stdin), &fdSet);
+	fdSetTimeout.tv_sec = 0;
+	fdSetTimeout.tv_usec = 500000;
+	if (select(fileno(stdin)+1, &fdSet, NULL, NULL, &fdSetTimeout) > 0)
+	    break;
+    }
+#endif
+    return OK;
+}
+#endif
+
+/*+/subr**********************************************************************
+* NAME	cauCmdProcess - process a command line
+*
+* DESCRIPTION
+*
+* RETURNS
+*	void
+*
+* BUGS
+* o	text
+*
+*-*/
+static void
+cauCmdProcess(ppCxCmd, pCauDesc)
+CX_CMD	**ppCxCmd;	/* IO ptr to pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    CX_CMD	*pCxCmd;	/* local copy of pointer, for convenience */
+
+    pCxCmd = *ppCxCmd;
+    if (strcmp(pCxCmd->pCommand,			"quit") == 0) {
+	/* insert wrapup processing here */
+	pCauDesc->cauTaskInfo.stop = 1;
+    }
+#ifdef vxWorks
+    else if (strcmp(pCxCmd->pCommand,			"showStack") == 0)
+	pCauDesc->showStack = 1;
+#else
+    else if (strcmp(pCxCmd->pCommand,			"dataOut") == 0)
+	cauDataOut(pCxCmd);
+#endif
+    else if (strcmp(pCxCmd->pCommand,			"cache") == 0)
+	cau_cache(pCxCmd, pCauDesc);
+    else if (strcmp(pCxCmd->pCommand,			"deadband") == 0)
+	cau_deadband(pCxCmd);
+    else if (strcmp(pCxCmd->pCommand,			"debug") == 0)
 	cau_debug(pCxCmd);
     else if (strcmp(pCxCmd->pCommand,			"delete") == 0) {
 	if (pCauDesc->pChanHead == NULL) goto noChanErr;
@@ -797,16 +1790,36 @@ CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
     }
     else if (strcmp(pCxCmd->pCommand,			"get") == 0)
 	cau_get(pCxCmd, pCauDesc);
+    else if (strcmp(pCxCmd->pCommand,			"getMode") == 0)
+	cau_getMode(pCxCmd, pCauDesc);
     else if (strcmp(pCxCmd->pCommand,			"info") == 0)
 	cau_info(pCxCmd, pCauDesc);
     else if (strcmp(pCxCmd->pCommand,			"interval") == 0)
 	cau_interval(pCxCmd, pCauDesc);
+    else if (strcmp(pCxCmd->pCommand,			"load") == 0)
+	cau_load(pCxCmd, pCauDesc);
     else if (strcmp(pCxCmd->pCommand,			"monitor") == 0)
 	cau_monitor(pCxCmd, pCauDesc);
+    else if (strcmp(pCxCmd->pCommand,			"ping") == 0)
+	cau_ping(pCxCmd, pCauDesc);
+    else if (strcmp(pCxCmd->pCommand,			"poll") == 0)
+	cau_poll(pCxCmd, pCauDesc);
+    else if (strcmp(pCxCmd->pCommand,			"pools") == 0)
+	cau_pools(pCxCmd, pCauDesc);
     else if (strcmp(pCxCmd->pCommand,			"put") == 0)
 	cau_put(pCxCmd, pCauDesc);
+    else if (strcmp(pCxCmd->pCommand,			"putMode") == 0)
+	cau_putMode(pCxCmd, pCauDesc);
+    else if (strcmp(pCxCmd->pCommand,			"putRate") == 0)
+	cau_putRate(pCxCmd, pCauDesc);
     else if (strcmp(pCxCmd->pCommand,			"ramp") == 0)
 	cau_ramp(pCxCmd, pCauDesc);
+    else if (strcmp(pCxCmd->pCommand,			"restore") == 0)
+	cau_restore(pCxCmd, pCauDesc);
+    else if (strcmp(pCxCmd->pCommand,			"shards") == 0)
+	cau_shards(pCxCmd, pCauDesc);
+    else if (strcmp(pCxCmd->pCommand,			"snapshot") == 0)
+	cau_snapshot(pCxCmd, pCauDesc);
     else {
 /*----------------------------------------------------------------------------
 * help (or illegal command)
@@ -825,6 +1838,46 @@ cmdDone:
     return;
 }
 
+/*+/subr**********************************************************************
+* NAME	cau_cache
+*	cache [filePath]
+*	cache-
+*-*/
+static void
+cau_cache(pCxCmd, pCauDesc)
+CX_CMD	*pCxCmd;	/* IO pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+#ifdef CAU_MMAP_CACHE
+    CAU_CACHE	*pCache=&pCauDesc->cache;
+
+    if (pCxCmd->delim == '-') {
+	if (pCache->fd < 0)
+	    (void)printf("no cache is open\n");
+	else
+	    cauCacheClose(pCache);
+	return;
+    }
+    if (nextNonSpaceField(&pCxCmd->pLine, &pCxCmd->pField,
+						&pCxCmd->delim) > 1) {
+	if (pCache->fd >= 0)
+	    cauCacheClose(pCache);
+	if (cauCacheOpen(pCache, pCxCmd->pField) != OK)
+	    (void)printf("couldn't use cache %s\n", pCxCmd->pField);
+	return;
+    }
+    if (pCache->fd < 0) {
+	(void)printf("no cache is open\n");
+	return;
+    }
+    (void)printf("cache %s: %ld entries\n", pCache->path, pCache->pHdr->nEntry);
+    (void)printf("%lu hits, %lu misses, %lu stale, %lu changed\n",
+		pCache->nHit, pCache->nMiss, pCache->nStale, pCache->nChanged);
+#else
+    (void)printf("the cache isn't available on this system\n");
+#endif
+}
+
 /*+/subr**********************************************************************
 * NAME	cau_deadband
 *-*/
@@ -873,6 +1926,8 @@ CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 {
     CAU_CHAN	*pChan;		/* temp for channel pointer */
     CAU_CHAN	*pChanNext;	/* temp for channel pointer */
+    CAU_PATTERN	pat;		/* compiled pattern */
+    int		isPat;		/* 1 says name is a pattern */
 
     pCxCmd->fldLen =
 	nextChanNameField(&pCxCmd->pLine, &pCxCmd->pField, &pCxCmd->delim);
@@ -890,15 +1945,25 @@ CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 	    }
 	    pChan = pChanNext;
 	}
+	while (pCauDesc->pChanConnHead != NULL) {
+	    if (cauChanDel(pCxCmd, pCauDesc, pCauDesc->pChanConnHead) != OK)
+		break;
+	}
 	return;
     }
     while (pCxCmd->fldLen > 1) {
-	if ((pChan = cauChanFind(pCauDesc, pCxCmd->pField)) == NULL)
+	if ((isPat = cauPatternCompile(&pat, pCxCmd->pField)) != 0) {
+	    if ((pChan = cauChanMatchFirst(pCauDesc, &pat)) == NULL)
+		(void)printf("no channels match %s\n", pCxCmd->pField);
+	}
+	else if ((pChan = cauChanLookup(pCauDesc, pCxCmd->pField)) == NULL)
 	    (void)printf("%s not selected\n", pCxCmd->pField);
-	else {
+	while (pChan != NULL) {
+	    pChanNext = isPat ? cauChanMatchNext(pCauDesc, &pat) : NULL;
 	    if (cauChanDel(pCxCmd, pCauDesc, pChan) != OK) {
-		(void)printf("error deleting %s \n", pCxCmd->pField);
+		(void)printf("error deleting %s \n", pChan->name);
 	    }
+	    pChan = pChanNext;
 	}
 	pCxCmd->fldLen =
 	    nextChanNameField(&pCxCmd->pLine, &pCxCmd->pField, &pCxCmd->delim);
@@ -914,6 +1979,8 @@ CX_CMD	*pCxCmd;	/* IO pointer to command context */
 CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 {
     CAU_CHAN	*pChan;		/* temp for channel pointer */
+    CAU_PATTERN	pat;		/* compiled pattern */
+    int		isPat;		/* 1 says name is a pattern */
     int		count=-1;
 
     if (pCxCmd->delim == ',') {
@@ -930,7 +1997,9 @@ CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 	    (void)printf("no channels selected\n");
 	    return;
 	}
+	cauChanGRAll(pCauDesc, CAU_GR_NEED_PRINT);
 	while (pChan != NULL) {
+	    CauChanLock(pChan);		/* a shard may be reading these */
 	    pChan->dbrType = dbf_type_to_DBR_TIME(pChan->dbfType);
 	    if (count > 0) {
 		if (count <= (int)pChan->elCount)
@@ -938,18 +2007,27 @@ CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 		else
 		    pChan->reqCount = pChan->elCount;
 	    }
-	    cauGetAndPrint(pCxCmd, pCauDesc, pChan, 1, 0, 0);
+	    CauChanUnlock(pChan);
+	    if (cauGetQueue(pCauDesc, pChan) != OK)
+		break;
 	    pChan = pChan->pNext;
 	}
+	cauGetAndPrint(pCxCmd, pCauDesc, 1, 0, 0);
 	return;
     }
+    cauChanAddList(pCxCmd, pCauDesc, CAU_GR_NEED_PRINT);
     while (pCxCmd->fldLen > 1) {
-	if ((pChan = cauChanFind(pCauDesc, pCxCmd->pField)) == NULL) {
+	if ((isPat = cauPatternCompile(&pat, pCxCmd->pField)) != 0) {
+	    if ((pChan = cauChanMatchFirst(pCauDesc, &pat)) == NULL)
+		(void)printf("no channels match %s\n", pCxCmd->pField);
+	}
+	else if ((pChan = cauChanFind(pCauDesc, pCxCmd->pField)) == NULL) {
 	    pChan = cauChanAdd(pCxCmd, pCauDesc, pCxCmd->pField);
 	    if (pChan == NULL)
 		(void)printf("couldn't open %s \n", pCxCmd->pField);
 	}
-	if (pChan != NULL) {
+	while (pChan != NULL) {
+	    CauChanLock(pChan);		/* a shard may be reading these */
 	    pChan->dbrType = dbf_type_to_DBR_TIME(pChan->dbfType);
 	    if (count > 0) {
 		if (count <= (int)pChan->elCount)
@@ -957,13 +2035,51 @@ CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 		else
 		    pChan->reqCount = pChan->elCount;
 	    }
-	    cauGetAndPrint(pCxCmd, pCauDesc, pChan, 1, 0, 0);
+	    CauChanUnlock(pChan);
+	    if (cauGetQueue(pCauDesc, pChan) != OK)
+		break;
+	    pChan = isPat ? cauChanMatchNext(pCauDesc, &pat) : NULL;
 	}
 	pCxCmd->fldLen =
 	    nextChanNameField(&pCxCmd->pLine, &pCxCmd->pField, &pCxCmd->delim);
     }
+    cauGetAndPrint(pCxCmd, pCauDesc, 1, 0, 0);
 }
 
+/*+/subr**********************************************************************
+* NAME	cau_getMode - select how the get command waits for values
+*
+* DESCRIPTION
+*	pend, the default, sends all the gets and then waits for all of
+*	them before printing.  stream and ordered send the gets and return
+*	at once, without blocking cau; with stream, each value is printed
+*	when it arrives, and with ordered, values are printed as they
+*	arrive, but held back if needed so that they come out in the
+*	order the channels were given.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cau_getMode(pCxCmd, pCauDesc)
+CX_CMD	*pCxCmd;	/* IO pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    char	*opt;
+
+    if (nextNonSpaceField(&pCxCmd->pLine, &opt, &pCxCmd->delim) <= 1)
+	opt = "";
+    if (strcmp(opt, "pend") == 0)
+	pCauDesc->getMode = CAU_GET_MODE_PEND;
+    else if (strcmp(opt, "stream") == 0)
+	pCauDesc->getMode = CAU_GET_MODE_STREAM;
+    else if (strcmp(opt, "ordered") == 0)
+	pCauDesc->getMode = CAU_GET_MODE_ORDERED;
+    else
+	(void)printf("you must specify pend, stream, or ordered\n");
+}
+
 /*+/subr**********************************************************************
 * NAME	cau_info
 *-*/
@@ -981,12 +2097,14 @@ CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 	    (void)printf("no channels selected\n");
 	    return;
 	}
+	cauChanGRAll(pCauDesc, CAU_GR_NEED_ALL);
 	while (pChan != NULL) {
 	    cauPrintInfo(pCxCmd, pChan);
 	    pChan = pChan->pNext;
 	}
 	return;
     }
+    cauChanAddList(pCxCmd, pCauDesc, CAU_GR_NEED_ALL);
     while (pCxCmd->fldLen > 1) {
 	if ((pChan = cauChanFind(pCauDesc, pCxCmd->pField)) == NULL) {
 	    pChan = cauChanAdd(pCxCmd, pCauDesc, pCxCmd->pField);
@@ -994,8 +2112,10 @@ CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 		(void)printf("couldn't open %s \n", pCxCmd->pField);
 	    }
 	}
-	if (pChan != NULL)
+	if (pChan != NULL) {
+	    (void)cauChanGRFetch(pCauDesc, pChan, CAU_GR_NEED_ALL);
 	    cauPrintInfo(pCxCmd, pChan);
+	}
 	pCxCmd->fldLen =
 	    nextChanNameField(&pCxCmd->pLine, &pCxCmd->pField, &pCxCmd->delim);
     }
@@ -1010,17 +2130,12 @@ cau_interval(pCxCmd, pCauDesc)
 CX_CMD	*pCxCmd;	/* IO pointer to command context */
 CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 {
-    long	stat;
     CAU_CHAN	*pChan;		/* temp for channel pointer */
+    CAU_PATTERN	pat;		/* compiled pattern */
+    int		isPat;		/* 1 says name is a pattern */
     int		stopFlag;	/* 1 indicates to stop an activity */
     double	interval;	/* desired interval between samples, or 0. */
     double	jitter;		/* allowed jitter in interval */
-    char	*msg;
-
-    if (glCauDeadband & DBE_VALUE)
-	msg = glCauMDEL_msg;
-    else
-	msg = glCauADEL_msg;
 
     if (pCxCmd->delim == '-')
 	stopFlag = 1;
@@ -1054,41 +2169,29 @@ CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 	    return;
 	}
 	while (pChan != NULL) {
+	    cauMonitorClear(pCauDesc, pChan);
 	    pChan->dbrType = dbf_type_to_DBR_TIME(pChan->dbfType);
 	    pChan->interval = 0.;
 	    pChan->jitter = 0.;
-	    if (pChan->pEv != NULL) {
-		cauCaDebugName("prior to ca_clear_event", pChan->name, 0);
-		stat = ca_clear_event(pChan->pEv);
-		cauCaDebugStat("back from ca_clear_event", stat, 0);
-		if (stat != ECA_NORMAL) {
-		    (void)printf("ca_clear_event error: %s\n", pCxCmd->pField);
-		}
-		pChan->pEv = NULL;
-	    }
 	    if (!stopFlag) {
 		pChan->interval = interval;
 		pChan->jitter = jitter;
 		pChan->lastMonTime.secPastEpoch = 0;
 		pChan->lastMonErr = 0;
-		if (pChan->pEv == NULL) {
-		    cauCaDebugDbrAndName(msg, pChan->dbrType, pChan->name, 0);
-		    stat = ca_add_masked_array_event(pChan->dbrType,
-				pChan->reqCount, pChan->pCh, cauMonitor, pChan,
-				0., 0., 0., &pChan->pEv, glCauDeadband);
-		    cauCaDebugStat("back from ca_add_array_event", stat, 0);
-		    if (stat != ECA_NORMAL) {
-			(void)printf("ca_add_event error:%s\n",pCxCmd->pField);
-			pChan->pEv = NULL;
-		    }
-		}
+		(void)cauMonitorAdd(pCxCmd, pCauDesc, pChan);
 	    }
 	    pChan = pChan->pNext;
 	}
 	return;
     }
+    if (!stopFlag)
+	cauChanAddList(pCxCmd, pCauDesc, CAU_GR_NEED_NONE);
     while (pCxCmd->fldLen > 1) {
-	if ((pChan = cauChanFind(pCauDesc, pCxCmd->pField)) == NULL) {
+	if ((isPat = cauPatternCompile(&pat, pCxCmd->pField)) != 0) {
+	    if ((pChan = cauChanMatchFirst(pCauDesc, &pat)) == NULL)
+		(void)printf("no channels match %s\n", pCxCmd->pField);
+	}
+	else if ((pChan = cauChanFind(pCauDesc, pCxCmd->pField)) == NULL) {
 	    if (stopFlag)
 		(void)printf("couldn't find %s \n", pCxCmd->pField);
 	    else {
@@ -1098,36 +2201,19 @@ CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 		}
 	    }
 	}
-	if (pChan != NULL) {
+	while (pChan != NULL) {
+	    cauMonitorClear(pCauDesc, pChan);
 	    pChan->interval = 0.;
 	    pChan->jitter = 0.;
-	    if (pChan->pEv != NULL) {
-		cauCaDebugName("prior to ca_clear_event", pChan->name, 0);
-		stat = ca_clear_event(pChan->pEv);
-		cauCaDebugStat("back from ca_clear_event", stat, 0);
-		if (stat != ECA_NORMAL) {
-		    (void)printf("ca_clear_event error: %s\n", pCxCmd->pField);
-		}
-		pChan->pEv = NULL;
-	    }
 	    if (!stopFlag) {
 		pChan->dbrType = dbf_type_to_DBR_TIME(pChan->dbfType);
 		pChan->interval = interval;
 		pChan->jitter = jitter;
 		pChan->lastMonTime.secPastEpoch = 0;
 		pChan->lastMonErr = 0;
-		if (pChan->pEv == NULL) {
-		    cauCaDebugDbrAndName(msg, pChan->dbrType, pChan->name, 0);
-		    stat = ca_add_masked_array_event(pChan->dbrType,
-				pChan->reqCount, pChan->pCh, cauMonitor, pChan,
-				0., 0., 0., &pChan->pEv, glCauDeadband);
-		    cauCaDebugStat("back from ca_add_array_event", stat, 0);
-		    if (stat != ECA_NORMAL) {
-			(void)printf("ca_add_event error:%s\n",pCxCmd->pField);
-			pChan->pEv = NULL;
-		    }
-		}
+		(void)cauMonitorAdd(pCxCmd, pCauDesc, pChan);
 	    }
+	    pChan = isPat ? cauChanMatchNext(pCauDesc, &pat) : NULL;
 	}
 	pCxCmd->fldLen =
 	    nextChanNameField(&pCxCmd->pLine, &pCxCmd->pField, &pCxCmd->delim);
@@ -1135,51 +2221,197 @@ CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 }
 /*+/subr**********************************************************************
 * NAME	cau_interval_deadTime_test
+*
+* DESCRIPTION
+*	Reports a deadTime violation for each channel whose deadTime
+*	timer has come due--i.e., for which no value has been received
+*	for (1 second + interval).  The timers are taken off the heap;
+*	cauMonitor re-arms a channel's timer when data resumes.  Channels
+*	which are still sending data aren't looked at.
+*
+*	For a shard's heap, the caller must hold the shard's lock.
+*
+* RETURNS
+*	void
+*
 *-*/
 static void
-cau_interval_deadTime_test(pCauDesc)
-CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+cau_interval_deadTime_test(pHeap, out)
+CAU_TMR_HEAP *pHeap;	/* IO pointer to heap of deadTime timers */
+FILE	*out;		/* I stream for printing */
 {
     epicsTimeStamp	now;
     char	nowText[28];
     char	lastMonText[28];
     char	chanTsText[28];
     CAU_CHAN	*pChan;
-    double	deadTime;
 
     (void)epicsTimeGetCurrent(&now);
-    (void)epicsTimeToStrftime(nowText,28,"%m-%d-%y %H:%M:%S.%09f",&now);
-    pChan = pglCauDesc->pChanHead;
-    while (pChan != NULL) {
-	if (pChan->interval > 0. && pChan->lastMonErr == 0 &&
-		    			pChan->lastMonTime.secPastEpoch > 0) {
-	    deadTime = epicsTimeDiffInSeconds(&now, &pChan->lastMonTime);  /* left - right */
-	    if (deadTime > pChan->interval + 1.) {
-		pChan->lastMonErr = 1;
-		(void)fprintf(pCauDesc->pCxCmd->dataOut,
-				"deadTime viol. %s at %s (local)\n",
-				pChan->name, nowText);
-
-		(void)epicsTimeToStrftime(lastMonText,28,"%m-%d-%y %H:%M:%S.%09f",
-                                                &pChan->lastMonTime);
-		(void)epicsTimeToStrftime(chanTsText,28,"%m-%d-%y %H:%M:%S.%09f",
-                                                &pChan->pBuf->tstrval.stamp);
-		(void)fprintf(pCauDesc->pCxCmd->dataOut,
-		    "last mon at %s (local) or %s (ioc)\n", lastMonText, chanTsText);
-		if (pCauDesc->pCxCmd->dataOut != pCauDesc->pCxCmd->dataOut) {
-		    (void)fprintf(pCauDesc->pCxCmd->dataOut,
-				"deadTime viol. %s at %s (local)\n",
-				pChan->name, nowText);
-		    (void)fprintf(pCauDesc->pCxCmd->dataOut,
-			"last mon at %s (local) or %s (ioc)\n",
+    nowText[0] = '\0';
+    while (cauTmrDue(pHeap, &now)) {
+	pChan = (CAU_CHAN *)pHeap->ppTmr[0]->pArg;
+	cauTmrCancel(pHeap, &pChan->deadTime);
+	pChan->lastMonErr = 1;
+	if (nowText[0] == '\0') {
+	    (void)epicsTimeToStrftime(nowText,28,"%m-%d-%y %H:%M:%S.%09f",
+									&now);
+	}
+	(void)fprintf(out, "deadTime viol. %s at %s (local)\n",
+						pChan->name, nowText);
+	(void)epicsTimeToStrftime(lastMonText,28,"%m-%d-%y %H:%M:%S.%09f",
+						&pChan->lastMonTime);
+	(void)epicsTimeToStrftime(chanTsText,28,"%m-%d-%y %H:%M:%S.%09f",
+						&pChan->pBuf->tstrval.stamp);
+	(void)fprintf(out, "last mon at %s (local) or %s (ioc)\n",
 						lastMonText, chanTsText);
-		}
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cau_load
+*	load[,batch[,sec]] filePath
+*
+* DESCRIPTION
+*	Reads channel names from a file, a line at a time, and starts
+*	searches for them in batches.  After each batch, Channel Access
+*	events are handled until sec seconds have passed since the batch
+*	was started, so that searches go out at a steady rate no matter
+*	how long the file is.  All the channels are counted in a single
+*	connect batch, so nConnWait is the number not yet connected.
+*
+*-*/
+static void
+cau_load(pCxCmd, pCauDesc)
+CX_CMD	*pCxCmd;	/* IO pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    FILE	*pFile;		/* file of channel names */
+    char	line[CAU_LOAD_LINE_DIM];/* line from file */
+    char	*pLine;		/* pointer into line */
+    char	*pName;		/* pointer to a name */
+    char	delim;
+    int		batch=CAU_LOAD_BATCH;/* searches per batch */
+    double	pace=CAU_LOAD_PACE;/* seconds per batch */
+    int		nInBatch=0;	/* searches started in present batch */
+    long	nName=0;	/* names read from file */
+    long	nStart=0;	/* searches started */
+    long	nConn;		/* channels connected */
+    long	lineNum=0;	/* line number in file */
+    TS_STAMP	startTime;	/* time load started */
+    TS_STAMP	batchTime;	/* time present batch was started */
+    TS_STAMP	reportTime;	/* time of next progress report */
+    TS_STAMP	lastConnTime;	/* time a channel last connected */
+    TS_STAMP	now;		/* present time */
+    double	elapsed;	/* seconds since load started */
+
+    if (pCxCmd->delim == ',') {
+	if (nextIntFieldAsInt(&pCxCmd->pLine, &batch, &pCxCmd->delim) > 1 &&
+								batch < 1) {
+	    (void)printf("illegal batch\n");
+	    return;
+	}
+	if (pCxCmd->delim == ',') {
+	    if (nextFltFieldAsDbl(&pCxCmd->pLine, &pace, &pCxCmd->delim) > 1 &&
+								pace < 0.) {
+		(void)printf("illegal seconds per batch\n");
+		return;
+	    }
+	}
+    }
+    if (nextNonSpaceField(&pCxCmd->pLine, &pCxCmd->pField,
+						&pCxCmd->delim) <= 1) {
+	(void)printf("you must specify a file\n");
+	return;
+    }
+    if ((pFile = fopen(pCxCmd->pField, "r")) == NULL) {
+	(void)printf("couldn't open %s\n", pCxCmd->pField);
+	return;
+    }
+
+    pCauDesc->connBatch++;
+    pCauDesc->nConnWait = 0;
+    (void)epicsTimeGetCurrent(&startTime);
+    batchTime = reportTime = lastConnTime = startTime;
+    epicsTimeAddSeconds(&reportTime, 1.);
+    while (fgets(line, sizeof(line), pFile) != NULL) {
+	lineNum++;
+	if (strchr(line, '\n') == NULL && !feof(pFile)) {
+	    (void)printf("line %ld too long; ignored\n",
+								lineNum);
+	    while (fgets(line+1, sizeof(line)-1, pFile) != NULL &&
+					strchr(line+1, '\n') == NULL)
+		;
+	    line[0] = '\0';
+	}
+	pLine = line;
+	while (nextChanNameField(&pLine, &pName, &delim) > 1) {
+	    if (pName[0] == '#')
+		break;
+	    nName++;
+	    if (cauChanLookup(pCauDesc, pName) != NULL)
+		continue;
+	    if (cauChanAddStart(pCxCmd, pCauDesc, pName) == NULL)
+		continue;
+	    nStart++;
+	    if (++nInBatch < batch)
+		continue;
+
+/*-----------------------------------------------------------------------------
+*    the batch is full.  Send the searches and handle connections until
+*    it's time for the next batch.
+*----------------------------------------------------------------------------*/
+	    (void)ca_flush_io();
+	    epicsTimeAddSeconds(&batchTime, pace);
+	    do {
+		nConn = nStart - pCauDesc->nConnWait;
+		(void)ca_pend_event(CAU_CONN_POLL);
+		(void)epicsTimeGetCurrent(&now);
+		if (nStart - pCauDesc->nConnWait != nConn)
+		    lastConnTime = now;
+	    } while (epicsTimeLessThan(&now, &batchTime));
+	    if (pace > 0. && epicsTimeLessThan(&batchTime, &now))
+		batchTime = now;
+	    nInBatch = 0;
+	    if (epicsTimeGreaterThanEqual(&now, &reportTime)) {
+		elapsed = epicsTimeDiffInSeconds(&now, &startTime);
+		nConn = nStart - pCauDesc->nConnWait;
+		(void)printf("load: %ld searched, %ld connected, %.0f/sec\n",
+				nStart, nConn, nConn / elapsed);
+		reportTime = now;
+		epicsTimeAddSeconds(&reportTime, 1.);
 	    }
 	}
-	pChan = pChan->pNext;
+    }
+    (void)fclose(pFile);
+
+/*-----------------------------------------------------------------------------
+*    wait for the rest of the channels, as long as they keep connecting
+*----------------------------------------------------------------------------*/
+    (void)ca_flush_io();
+    (void)epicsTimeGetCurrent(&now);
+    lastConnTime = now;
+    while (pCauDesc->nConnWait > 0 &&
+		epicsTimeDiffInSeconds(&now, &lastConnTime) < CAU_LOAD_WAIT) {
+	nConn = nStart - pCauDesc->nConnWait;
+	(void)ca_pend_event(CAU_CONN_POLL);
+	(void)epicsTimeGetCurrent(&now);
+	if (nStart - pCauDesc->nConnWait != nConn)
+	    lastConnTime = now;
+    }
+
+    nConn = nStart - pCauDesc->nConnWait;
+    elapsed = epicsTimeDiffInSeconds(&lastConnTime, &startTime);
+    (void)printf("load: %ld names, %ld new channels, %ld connected",
+						nName, nStart, nConn);
+    if (nConn > 0 && elapsed > 0.)
+	(void)printf(" in %.2f sec (%.0f/sec)", elapsed, nConn / elapsed);
+    (void)printf("\n");
+    if (pCauDesc->nConnWait > 0) {
+	(void)printf("load: %d channels not connected yet\n",
+						pCauDesc->nConnWait);
     }
 }
-
+
 /*+/subr**********************************************************************
 * NAME	cau_monitor
 *-*/
@@ -1188,15 +2420,15 @@ cau_monitor(pCxCmd, pCauDesc)
 CX_CMD	*pCxCmd;	/* IO pointer to command context */
 CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 {
-    long	stat;
     CAU_CHAN	*pChan;		/* temp for channel pointer */
+    CAU_PATTERN	pat;		/* compiled pattern */
+    int		isPat;		/* 1 says name is a pattern */
     int		stopFlag;	/* 1 indicates to stop an activity */
     int		count=-1;
-    char	*msg;
 
     if (pCxCmd->delim == ',') {
 	nextIntFieldAsInt(&pCxCmd->pLine, &count, &pCxCmd->delim);
-	if (count <= 0) {
+	if (count < 0) {
 	    (void)printf("error in count field\n");
 	    return;
 	}
@@ -1207,11 +2439,6 @@ CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
     else
 	stopFlag = 0;
 
-    if (glCauDeadband & DBE_VALUE)
-	msg = glCauMDEL_msg;
-    else
-	msg = glCauADEL_msg;
-
     pCxCmd->fldLen =
 	    nextChanNameField(&pCxCmd->pLine, &pCxCmd->pField, &pCxCmd->delim);
     if (pCxCmd->fldLen <= 1 || strcmp(pCxCmd->pField, "all") == 0) {
@@ -1220,8 +2447,9 @@ CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 	    return;
 	}
 	while (pChan != NULL) {
+	    cauMonitorClear(pCauDesc, pChan);
 	    pChan->dbrType = dbf_type_to_DBR_TIME(pChan->dbfType);
-	    if (count > 0) {
+	    if (count >= 0) {
 		if (count <= (int)pChan->elCount)
 		    pChan->reqCount = count;
 		else
@@ -1229,32 +2457,20 @@ CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 	    }
 	    pChan->interval = 0.;
 	    pChan->lastMonErr = 0;
-	    if (pChan->pEv != NULL) {
-		cauCaDebugName("prior to ca_clear_event", pChan->name, 0);
-		stat = ca_clear_event(pChan->pEv);
-		cauCaDebugStat("back from ca_clear_event", stat, 0);
-		if (stat != ECA_NORMAL) {
-		    (void)printf("ca_clear_event error: %s \n", pCxCmd->pField);
-		}
-		pChan->pEv = NULL;
-	    }
-	    if (!stopFlag) {
-		cauCaDebugDbrAndName(msg, pChan->dbrType, pChan->name, 0);
-		stat = ca_add_masked_array_event(pChan->dbrType,
-				pChan->reqCount, pChan->pCh, cauMonitor, pChan,
-				0., 0., 0., &pChan->pEv, glCauDeadband);
-		cauCaDebugStat("back from ca_add_array_event", stat, 0);
-		if (stat != ECA_NORMAL) {
-		    (void)printf("ca_add_event error:%s\n",pCxCmd->pField);
-		    pChan->pEv = NULL;
-		}
-	    }
+	    if (!stopFlag)
+		(void)cauMonitorAdd(pCxCmd, pCauDesc, pChan);
 	    pChan = pChan->pNext;
 	}
 	return;
     }
+    if (!stopFlag)
+	cauChanAddList(pCxCmd, pCauDesc, CAU_GR_NEED_NONE);
     while (pCxCmd->fldLen > 1) {
-	if ((pChan = cauChanFind(pCauDesc, pCxCmd->pField)) == NULL) {
+	if ((isPat = cauPatternCompile(&pat, pCxCmd->pField)) != 0) {
+	    if ((pChan = cauChanMatchFirst(pCauDesc, &pat)) == NULL)
+		(void)printf("no channels match %s\n", pCxCmd->pField);
+	}
+	else if ((pChan = cauChanFind(pCauDesc, pCxCmd->pField)) == NULL) {
 	    if (stopFlag) {
 		(void)printf("couldn't find %s \n", pCxCmd->pField);
 	    }
@@ -1265,36 +2481,21 @@ CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 		}
 	    }
 	}
-	if (pChan != NULL) {
-	    if (pChan->pEv != NULL) {
-		cauCaDebugName("prior to ca_clear_event", pChan->name, 0);
-		stat = ca_clear_event(pChan->pEv);
-		cauCaDebugStat("back from ca_clear_event", stat, 0);
-		if (stat != ECA_NORMAL) {
-		    (void)printf("ca_clear_event error: %s \n", pCxCmd->pField);
-		}
-		pChan->pEv = NULL;
-	    }
+	while (pChan != NULL) {
+	    cauMonitorClear(pCauDesc, pChan);
 	    if (!stopFlag) {
 		pChan->interval = 0.;
 		pChan->lastMonErr = 0;
 		pChan->dbrType = dbf_type_to_DBR_TIME(pChan->dbfType);
-		if (count > 0) {
+		if (count >= 0) {
 		    if (count <= (int)pChan->elCount)
 			pChan->reqCount = count;
 		    else
 			pChan->reqCount = pChan->elCount;
 		}
-		cauCaDebugDbrAndName(msg, pChan->dbrType, pChan->name, 0);
-		stat = ca_add_masked_array_event(pChan->dbrType,
-				pChan->reqCount, pChan->pCh, cauMonitor, pChan,
-				0., 0., 0., &pChan->pEv, glCauDeadband);
-		cauCaDebugStat("back from ca_add_array_event", stat, 0);
-		if (stat != ECA_NORMAL) {
-		    (void)printf("ca_add_event error: %s \n", pCxCmd->pField);
-		    pChan->pEv = NULL;
-		}
+		(void)cauMonitorAdd(pCxCmd, pCauDesc, pChan);
 	    }
+	    pChan = isPat ? cauChanMatchNext(pCauDesc, &pat) : NULL;
 	}
 	pCxCmd->fldLen =
 	    nextChanNameField(&pCxCmd->pLine, &pCxCmd->pField, &pCxCmd->delim);
@@ -1302,568 +2503,4120 @@ CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 }
 
 /*+/subr**********************************************************************
-* NAME	cau_put
-*	put chanName value
+* NAME	cau_ping
+*	ping[,count[,rate]] chanName
+*	ping-
+*
+* DESCRIPTION
+*	Measures the round trip latency from a put to the resulting
+*	monitor update, for one channel.  count puts (default 100) of a
+*	sequence of values are sent, rate per second (default 10), and
+*	cauMonitor matches each update to its put by value (see
+*	CAU_PING).  The channel is monitored for the ping if it isn't
+*	already; its updates aren't printed while the ping runs.
+*
+*	When every put has had its update, or CAU_PING_TMO seconds after
+*	the last put, cauPingDone prints the minimum, median, 99th
+*	percentile, and maximum latencies, and the number of puts lost.
+*	ping- stops the ping and prints the results so far.
+*
+*	The channel must be numeric, and not ENUM.  A put whose value the
+*	record changes (e.g., by clipping to DRVL and DRVH) or doesn't
+*	post a monitor for is counted as lost.
+*
 *-*/
 static void
-cau_put(pCxCmd, pCauDesc)
+cau_ping(pCxCmd, pCauDesc)
 CX_CMD	*pCxCmd;	/* IO pointer to command context */
 CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 {
-    long	stat;
-    CAU_CHAN	*pChan;		/* temp for channel pointer */
-    char	*pValue;	/* temp for value pointer */
-    int		i;
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    CAU_PING	*pPing;		/* pointer to ping */
+    int		count=CAU_PING_COUNT;/* number of puts */
+    double	rate=CAU_PING_RATE;/* puts per second */
+    long	modulus;	/* number of distinct values */
+    long	i;
 
-    if ((pCxCmd->fldLen = nextChanNameField(&pCxCmd->pLine, &pCxCmd->pField,
-							&pCxCmd->delim)) <= 1)
-	goto putError;
-    if ((pCxCmd->fldLen = nextNonSpaceField(&pCxCmd->pLine, &pValue,
-							&pCxCmd->delim)) <= 1)
-	goto putError;
-    if ((pChan = cauChanFind(pCauDesc, pCxCmd->pField)) == NULL) {
-	pChan = cauChanAdd(pCxCmd, pCauDesc, pCxCmd->pField);
-	if (pChan == NULL) {
-	    (void)printf("couldn't open %s \n", pCxCmd->pField);
-	    return;
-	}
+    if (pCxCmd->delim == '-') {
+	if (pCauDesc->pPing == NULL)
+	    (void)printf("no ping is running\n");
+	else
+	    cauPingDone(pCauDesc);
+	return;
     }
-#if 0
-    if (pChan->elCount != 1) {
-	(void)printf("can't put for arrays or waveforms\n");
+    if (pCauDesc->pPing != NULL) {
+	(void)printf("ping of %s is already running\n",
+					pCauDesc->pPing->pChan->name);
 	return;
     }
-#endif
-    if (pChan->dbfType == DBF_ENUM) {
-	if (pChan->pGRBuf->genmval.status == -2) {
-	    (void)printf("can't do put--no graphics info for channel\n");
+    if (pCxCmd->delim == ',') {
+	if (nextIntFieldAsInt(&pCxCmd->pLine, &count, &pCxCmd->delim) <= 1 ||
+								count <= 0) {
+	    (void)printf("illegal count\n");
 	    return;
 	}
-	i = 0;
-	while (1) {
-	    if (strcmp(pValue, pChan->pGRBuf->genmval.strs[i]) == 0)
-		break;
-	    i++;
-	    if (i >= pChan->pGRBuf->genmval.no_str) {
-		(void)printf("bad state string; legal state strings are:\n");
-		for (i=0; i<pChan->pGRBuf->genmval.no_str; i++)
-	            (void)printf("\"%s\"  ", pChan->pGRBuf->genmval.strs[i]);
-		(void)printf("\n");
-		(void)printf(
-"(It is necessary to use \" only if string contains blanks.)\n");
-		return;
-	    }
+    }
+    if (pCxCmd->delim == ',') {
+	if (nextFltFieldAsDbl(&pCxCmd->pLine, &rate, &pCxCmd->delim) <= 1 ||
+								rate <= 0.) {
+	    (void)printf("illegal rate\n");
+	    return;
 	}
     }
-    cauCaDebug("prior to ca_put (DBR_STRING)", 0);
-    stat = ca_put(DBR_STRING, pChan->pCh, pValue);
-    cauCaDebugStat("back from ca_put", stat, 0);
-    if (stat != ECA_NORMAL) {
-	(void)printf("error on ca_put\n");
+    if ((pCxCmd->fldLen = nextChanNameField(&pCxCmd->pLine,
+				&pCxCmd->pField, &pCxCmd->delim)) <= 1) {
+	(void)printf("you must specify a channel\n");
 	return;
     }
-    cauCaDebug("prior to ca_pend_io(1.0)", 0);
-    stat = ca_pend_io(1.0);
-    cauCaDebugStat("back from ca_pend_io(1.0)", stat, 0);
-    if (stat != ECA_NORMAL) {
-	(void)printf("error on ca_put\n");
+    if ((pChan = cauChanFind(pCauDesc, pCxCmd->pField)) == NULL)
+	pChan = cauChanAdd(pCxCmd, pCauDesc, pCxCmd->pField);
+    if (pChan == NULL || pChan->connState != CAU_CONN_OK) {
+	(void)printf("couldn't open %s \n", pCxCmd->pField);
 	return;
     }
-    return;
-putError:
-	(void)printf("you must specify a channel and a value\n");
+    if (pChan->dbfType == DBF_CHAR)
+	modulus = 100;
+    else if (pChan->dbfType == DBF_SHORT)
+	modulus = 10000;
+    else if (pChan->dbfType == DBF_FLOAT)
+	modulus = 1000000;		/* stay exact as a float */
+    else if (pChan->dbfType == DBF_LONG || pChan->dbfType == DBF_DOUBLE)
+	modulus = 0;
+    else {
+	(void)printf("%s must be numeric, and not ENUM\n", pChan->name);
+	return;
+    }
+
+    if ((pPing = (CAU_PING *)malloc(sizeof(CAU_PING))) == NULL) {
+	(void)printf("malloc error\n");
+	return;
+    }
+    pPing->pSendTime = (TS_STAMP *)malloc(count * sizeof(TS_STAMP));
+    pPing->pLatency = (double *)malloc(count * sizeof(double));
+    if (pPing->pSendTime == NULL || pPing->pLatency == NULL) {
+	(void)printf("malloc error\n");
+	if (pPing->pSendTime != NULL)
+	    free((char *)pPing->pSendTime);
+	if (pPing->pLatency != NULL)
+	    free((char *)pPing->pLatency);
+	free((char *)pPing);
+	return;
+    }
+    for (i=0; i<count; i++)
+	pPing->pLatency[i] = -1.;
+    pPing->pChan = pChan;
+    pPing->pCxCmd = pCxCmd->pCxCmdRoot;
+    pPing->next.heapIx = -1;
+    pPing->next.pArg = pPing;
+    pPing->period = 1. / rate;
+    pPing->count = count;
+    pPing->nSent = 0;
+    pPing->nRecv = 0;
+    pPing->modulus = modulus;
+    pPing->monAdded = 0;
+    if (!CauChanMonitored(pChan)) {
+	if (cauMonitorAdd(pCxCmd, pCauDesc, pChan) != OK) {
+	    free((char *)pPing->pSendTime);
+	    free((char *)pPing->pLatency);
+	    free((char *)pPing);
+	    return;
+	}
+	pPing->monAdded = 1;
+    }
+    CauChanLock(pChan);
+    pChan->pPing = pPing;
+    CauChanUnlock(pChan);
+    pCauDesc->pPing = pPing;
+/*-----------------------------------------------------------------------------
+*    the first put waits a period, so the monitor's first update (of the
+*    present value) comes before there is a put it could be matched to
+*----------------------------------------------------------------------------*/
+    (void)epicsTimeGetCurrent(&pPing->next.time);
+    epicsTimeAddSeconds(&pPing->next.time, pPing->period);
+    (void)cauTmrArm(&pCauDesc->pingHeap, &pPing->next);
 }
-
+
 /*+/subr**********************************************************************
-* NAME	cau_ramp
-*	ramp[,[secPerStep],[nSteps],[begVal],[endVal]] chanName [chanName ...]
+* NAME	cau_poll
+*	poll,rate [chanName [chanName ...]]
+*	poll- [chanName [chanName ...]]
+*	poll
+*
+* DESCRIPTION
+*	Starts (or, with poll-, stops) polling the channels, or all the
+*	channels in the list if none are named, at rate samples per
+*	second.  A channel which is already being polled is moved to the
+*	new rate.  With no rate and no names, the statistics for each
+*	poll group are printed.
+*
 *-*/
 static void
-cau_ramp(pCxCmd, pCauDesc)
+cau_poll(pCxCmd, pCauDesc)
 CX_CMD	*pCxCmd;	/* IO pointer to command context */
 CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 {
     CAU_CHAN	*pChan;		/* temp for channel pointer */
-    int		stopFlag;	/* 1 indicates to stop an activity */
+    CAU_POLL	*pPoll=NULL;	/* poll group for channels */
+    CAU_POLL	**ppPoll;	/* pointer to link to poll group */
+    CAU_CHAN	**ppNew;	/* pointer to expanded channel list */
+    int		newDim;		/* dimension of expanded channel list */
+    CAU_PATTERN	pat;		/* compiled pattern */
+    int		isPat;		/* 1 says name is a pattern */
+    int		all;		/* 1 says apply to all channels */
+    int		stopFlag;	/* 1 indicates to stop polling */
+    double	rate=0.;	/* samples per second */
 
-    if (pCxCmd->delim == '-')
-	stopFlag = 1;
-    else {
-	stopFlag = 0;
-	if (cauSigGenGetParams(pCxCmd, pCauDesc) != OK)
+    if (pCxCmd->delim == ',') {
+	if (nextFltFieldAsDbl(&pCxCmd->pLine, &rate, &pCxCmd->delim) <= 1 ||
+								rate <= 0.) {
+	    (void)printf("illegal rate\n");
 	    return;
+	}
     }
-
+    stopFlag = pCxCmd->delim == '-';
     pCxCmd->fldLen =
 	    nextChanNameField(&pCxCmd->pLine, &pCxCmd->pField, &pCxCmd->delim);
-    if (pCxCmd->fldLen <= 1 || strcmp(pCxCmd->pField, "all") == 0) {
-	if ((pChan = pCauDesc->pChanHead) == NULL) {
-	    (void)printf("no channels selected\n");
+    all = pCxCmd->fldLen <= 1 || strcmp(pCxCmd->pField, "all") == 0;
+    if (!stopFlag && rate <= 0.) {
+	if (!all) {
+	    (void)printf("you must specify a rate\n");
 	    return;
 	}
-	while (pChan != NULL) {
-	    if (stopFlag) {
-		if (pChan->pFn == cauSigGenRamp)
-		    pChan->pFn = NULL;
-	    }
-	    else
-		cauSigGenRampAdd(pCxCmd, pCauDesc, pChan);
-	    pChan = pChan->pNext;
+	if (pCauDesc->pPollHead == NULL)
+	    (void)printf("no channels are being polled\n");
+	else
+	    (void)printf("%10s %6s %10s %8s %8s %12s %12s\n", "period",
+			"nChan", "cycles", "missed", "skipped",
+			"jitterAvg", "jitterMax");
+	for (pPoll=pCauDesc->pPollHead; pPoll!=NULL; pPoll=pPoll->pNext) {
+	    (void)printf("%10.4f %6d %10ld %8ld %8ld %12.6f %12.6f\n",
+		    pPoll->period, pPoll->nChan, pPoll->nCycle, pPoll->nMissed,
+		    pPoll->nSkipped,
+		    pPoll->nCycle > 0 ? pPoll->jitterSum / pPoll->nCycle : 0.,
+		    pPoll->jitterMax);
 	}
 	return;
     }
-    while (pCxCmd->fldLen > 1) {
-	if ((pChan = cauChanFind(pCauDesc, pCxCmd->pField)) == NULL) {
-	    if (stopFlag) {
-		(void)printf("couldn't find %s \n", pCxCmd->pField);
+
+    if (!stopFlag) {
+	for (pPoll=pCauDesc->pPollHead; pPoll!=NULL; pPoll=pPoll->pNext) {
+	    if (pPoll->period == 1. / rate)
+		break;
+	}
+	if (pPoll == NULL) {
+	    if ((pPoll = (CAU_POLL *)malloc(sizeof(CAU_POLL))) == NULL) {
+		(void)printf("malloc error\n");
+		return;
 	    }
-	    else
-		pChan = cauChanAdd(pCxCmd, pCauDesc, pCxCmd->pField);
-	    if (pChan == NULL)
-		(void)printf("couldn't open %s \n",pCxCmd->pField);
+	    pPoll->period = 1. / rate;
+	    pPoll->pCxCmd = pCxCmd->pCxCmdRoot;
+	    pPoll->ppChan = NULL;
+	    pPoll->chanDim = pPoll->nChan = 0;
+	    pPoll->nCycle = pPoll->nMissed = pPoll->nSkipped = 0;
+	    pPoll->jitterSum = pPoll->jitterMax = 0.;
+	    pPoll->next.heapIx = -1;
+	    pPoll->next.pArg = pPoll;
+	    pPoll->pNext = pCauDesc->pPollHead;
+	    pCauDesc->pPollHead = pPoll;
 	}
-	if (pChan != NULL) {
-	    if (stopFlag) {
-		if (pChan->pFn == cauSigGenRamp)
-		    pChan->pFn = NULL;
-		else {
-		    (void)printf("%s not in ramp mode\n", pCxCmd->pField);
-		}
+	if (!all)
+	    cauChanAddList(pCxCmd, pCauDesc, CAU_GR_NEED_PRINT);
+	else
+	    cauChanGRAll(pCauDesc, CAU_GR_NEED_PRINT);
+    }
+
+    pChan = all ? pCauDesc->pChanHead : NULL;
+    isPat = 0;
+    while (all ? pChan != NULL : pCxCmd->fldLen > 1) {
+	if (!all) {
+	    if ((isPat = cauPatternCompile(&pat, pCxCmd->pField)) != 0) {
+		if ((pChan = cauChanMatchFirst(pCauDesc, &pat)) == NULL)
+		    (void)printf("no channels match %s\n", pCxCmd->pField);
 	    }
-	    else if (pChan->pFn == cauSigGenRamp) {
-		(void)printf("%s already in ramp mode\n", pCxCmd->pField);
+	    else if ((pChan = cauChanFind(pCauDesc, pCxCmd->pField)) == NULL)
+		(void)printf("couldn't find %s \n", pCxCmd->pField);
+	}
+	while (pChan != NULL) {
+	    if (stopFlag)
+		cauPollChanDel(pCauDesc, pChan);
+	    else if (pChan->pPoll != pPoll) {
+		if (pPoll->nChan >= pPoll->chanDim) {
+		    newDim = pPoll->chanDim > 0 ?
+					2 * pPoll->chanDim : CAU_HASH_DIM;
+		    ppNew = (CAU_CHAN **)realloc((char *)pPoll->ppChan,
+					newDim * sizeof(CAU_CHAN *));
+		    if (ppNew == NULL) {
+			(void)printf("malloc error\n");
+			goto pollWrapup;
+		    }
+		    pPoll->ppChan = ppNew;
+		    pPoll->chanDim = newDim;
+		}
+		cauPollChanDel(pCauDesc, pChan);
+		CauChanLock(pChan);		/* a shard may be reading it */
+		pChan->dbrType = dbf_type_to_DBR_TIME(pChan->dbfType);
+		CauChanUnlock(pChan);
+		pChan->pPoll = pPoll;
+		pPoll->ppChan[pPoll->nChan++] = pChan;
 	    }
+	    if (all)
+		pChan = pChan->pNext;
 	    else
-		cauSigGenRampAdd(pCxCmd, pCauDesc, pChan);
+		pChan = isPat ? cauChanMatchNext(pCauDesc, &pat) : NULL;
 	}
-	pCxCmd->fldLen =
-	    nextChanNameField(&pCxCmd->pLine, &pCxCmd->pField, &pCxCmd->delim);
+	if (!all) {
+	    pCxCmd->fldLen = nextChanNameField(&pCxCmd->pLine,
+					&pCxCmd->pField, &pCxCmd->delim);
+	}
+    }
+pollWrapup:
+    if (pPoll == NULL)
+	return;
+    if (pPoll->nChan == 0) {			/* new group, still empty */
+	for (ppPoll=&pCauDesc->pPollHead; *ppPoll!=NULL;
+						ppPoll=&(*ppPoll)->pNext) {
+	    if (*ppPoll == pPoll) {
+		*ppPoll = pPoll->pNext;
+		break;
+	    }
+	}
+	if (pPoll->ppChan != NULL)
+	    free((char *)pPoll->ppChan);
+	free((char *)pPoll);
+    }
+    else if (pPoll->next.heapIx < 0) {
+	(void)epicsTimeGetCurrent(&pPoll->next.time);
+	(void)cauTmrArm(&pCauDesc->pollHeap, &pPoll->next);
     }
 }
-
+
 /*+/subr**********************************************************************
-* NAME	cauChanAdd - add a channel to a cau descriptor
+* NAME	cau_pools
+*	pools
+*-*/
+static void
+cau_pools(pCxCmd, pCauDesc)
+CX_CMD	*pCxCmd;	/* IO pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    int		i;
+
+    (void)printf("%-12s %8s %8s %8s %8s %10s\n",
+			"pool", "itemSize", "slabs", "inUse", "maxUse", "gets");
+    cauPoolShow("channels", &pCauDesc->chanPool);
+    cauPoolShow("sig gen", &pCauDesc->sigGenPool);
+    cauPoolShow("put", &pCauDesc->putPool);
+    for (i=0; i<CAU_BUF_CLASS_DIM; i++) {
+	if (pCauDesc->bufPool[i].nGet > 0)
+	    cauPoolShow("buffers", &pCauDesc->bufPool[i]);
+    }
+    if (pCauDesc->nBufLargeGet > 0) {
+	(void)printf("%-12s %8s %8s %8ld %8s %10lu\n", "large bufs",
+		"-", "-", pCauDesc->nBufLarge, "-", pCauDesc->nBufLargeGet);
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cau_put
+*	put chanName value [chanName value ...]
 *
 * DESCRIPTION
-*	This routine adds a channel to a cau descriptor.  When complete,
-*	the channel descriptor will contain the graphics information for
-*	the channel.
+*	Stores the values into the channels.  Channels which aren't in
+*	the list are connected first, in one batch, and then their
+*	graphics information is fetched, in one batch.  Each value is
+*	converted to the channel's native type (see cauPutConvert) and
+*	all the puts are sent before waiting.
 *
-* RETURNS
-*	pointer to CAU_CHAN structure, or
-*	NULL
+*	A value which starts with [ or @ is an array (see cauArrayLoad),
+*	for a channel which isn't STRING.  The whole array is sent with a
+*	single ca_array_put.
 *
-* BUGS
-* o	doesn't check for duplication of channels already added
+*	If putRate is limiting, a single value (in putMode pend) may be
+*	held and sent later (see cauPutLimit).  Arrays, and puts with
+*	putMode callback, are always sent at once, but count against the
+*	rate.
+*
+*	With putMode pend (the default), there is a single ca_pend_io
+*	for all the puts.  With putMode callback, each put is sent with
+*	ca_put_callback and the command returns at once; as each put
+*	completes (that is, when the record has finished processing),
+*	cauPutDone prints how long it took.
 *
 *-*/
-static CAU_CHAN *
-cauChanAdd(pCxCmd, pCauDesc, chanName)
-CX_CMD	*pCxCmd;	/* I pointer to command context */
+static void
+cau_put(pCxCmd, pCauDesc)
+CX_CMD	*pCxCmd;	/* IO pointer to command context */
 CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
-char	*chanName;	/* I channel name (.VAL assumed of field omitted) */
 {
-    long	stat;           /* status return from calls */
-    CAU_CHAN	*pCauChan;	/* pointer to cau channel descriptor */
-    char	message [80];
-    chtype	getType;
-
-    assert(pCauDesc != NULL);
-    assert(chanName != NULL);
-    assert(strlen(chanName) > 0);
-    assert(strlen(chanName) < db_name_dim);
+    long	stat;
+    CAU_CHAN	*pChan;		/* temp for channel pointer */
+    char	*pValue;	/* temp for value pointer */
+    char	pairs[sizeof(pCxCmd->line)];/* copy of rest of line */
+    char	*pPairs;	/* pointer into pairs */
+    char	*pName;		/* pointer to a name */
+    char	delim;
+    int		nPut=0;		/* number of puts sent */
+    CAU_VALUE	value;		/* value, as channel's native type */
+    CAU_ARRAY	array;		/* array value, as channel's native type */
+    void	*pData;		/* pointer to value or array to put */
+    unsigned long count;	/* number of elements to put */
+    chtype	type;		/* DBR_xxx type of value */
+    TS_STAMP	now;		/* present time */
 
-    if ((pCauChan = (CAU_CHAN *)malloc(sizeof(CAU_CHAN))) == NULL) {
-	(void)printf("malloc error\n");
-	return NULL;
-    }
-    pCauChan->pCxCmd = pCxCmd->pCxCmdRoot;
-    pCauChan->pCh = NULL;
-    pCauChan->pEv = NULL;
-    pCauChan->pBuf = NULL;
-    pCauChan->pGRBuf = NULL;
-    pCauChan->pFn = NULL;
-    pCauChan->interval = 0.;
-    pCauChan->lastMonErr = 0;
-    cauCaDebugName("prior to ca_search", chanName, 0);
-    stat = ca_search(chanName, &pCauChan->pCh);
-    cauCaDebugStat("back from ca_search", stat, 0);
-    if (stat != ECA_NORMAL) {
-	(void)printf("error on search for %s\n", chanName);
-	goto addError;
-    }
-    cauCaDebug("prior to ca_pend_io(1.0)", 0);
-    stat = ca_pend_io(1.0);
-    cauCaDebugStat("back from ca_pend_io(1.0)", stat, 0);
-    if (stat != ECA_NORMAL) {
-	(void)printf("error on search for %s\n", chanName);
-	goto addError;
+/*-----------------------------------------------------------------------------
+*    start connecting any channels which aren't in the list
+*----------------------------------------------------------------------------*/
+    (void)strcpy(pairs, pCxCmd->pLine);
+    pPairs = pairs;
+    pCauDesc->connBatch++;
+    pCauDesc->nConnWait = 0;
+    while (nextChanNameField(&pPairs, &pName, &delim) > 1) {
+	if (nextNonSpaceField(&pPairs, &pValue, &delim) <= 1)
+	    goto putError;
+	if (cauChanLookup(pCauDesc, pName) == NULL)
+	    (void)cauChanAddStart(pCxCmd, pCauDesc, pName);
+	nPut++;
     }
-    strcpy(pCauChan->name, chanName);
-    pCauChan->dbfType = ca_field_type(pCauChan->pCh);
-    pCauChan->dbrType = dbf_type_to_DBR(ca_field_type(pCauChan->pCh));
-    pCauChan->elCount = ca_element_count(pCauChan->pCh);
-    if (pCauChan->elCount == 1)
-	pCauChan->reqCount = 1;
-    else if (pCauChan->elCount <= 512)
-	pCauChan->reqCount = pCauChan->elCount;
-    else
-	pCauChan->reqCount = 512;
-    pCauChan->units = NULL;
+    if (nPut == 0)
+	goto putError;
+    if (pCauDesc->nConnWait > 0)
+	cauChanConnWait(pCauDesc);
 
-    pCauChan->pBuf = (union db_access_val *)malloc(
-		sizeof(union db_access_val) + 
-		dbr_value_size[pCauChan->dbfType] * pCauChan->elCount);
-    if (pCauChan->pBuf == NULL) {
-	(void)printf("malloc error\n");
-	goto addError;
+/*-----------------------------------------------------------------------------
+*    get the graphics information (for control limits and enum strings)
+*    for all the channels at once
+*----------------------------------------------------------------------------*/
+    pPairs = pairs;
+    pCauDesc->grBatch++;
+    pCauDesc->nGRWait = 0;
+    while (nextChanNameField(&pPairs, &pName, &delim) > 1) {
+	(void)nextNonSpaceField(&pPairs, &pValue, &delim);
+	if ((pChan = cauChanFind(pCauDesc, pName)) != NULL &&
+				cauChanGRNeeded(pChan, CAU_GR_NEED_ALL))
+	    cauChanGRRequest(pCauDesc, pChan);
     }
-    pCauChan->pBuf->tstrval.status = -2;
-    pCauChan->pGRBuf =
-		(union db_access_val *)malloc( sizeof(union db_access_val));
-    if (pCauChan->pGRBuf == NULL) {
-	(void)printf("malloc error\n");
-	goto addError;
+    if (pCauDesc->nGRWait > 0)
+	cauChanGRWait(pCauDesc);
+
+    nPut = 0;
+    while ((pCxCmd->fldLen = nextChanNameField(&pCxCmd->pLine,
+				&pCxCmd->pField, &pCxCmd->delim)) > 1) {
+	(void)nextNonSpaceField(&pCxCmd->pLine, &pValue, &pCxCmd->delim);
+	if ((pChan = cauChanFind(pCauDesc, pCxCmd->pField)) == NULL ||
+				pChan->connState != CAU_CONN_OK) {
+	    (void)printf("couldn't open %s \n", pCxCmd->pField);
+	    continue;
+	}
+	array.pBuf = NULL;
+	array.pFile = NULL;
+	if (pChan->dbfType != DBF_STRING &&
+				(*pValue == '[' || *pValue == '@')) {
+	    if (cauArrayLoad(pCauDesc, pChan, pValue, &array) != OK)
+		continue;
+	    type = dbf_type_to_DBR(pChan->dbfType);
+	    pData = array.pData;
+	    count = array.count;
+	}
+	else {
+	    if (cauPutConvert(pCauDesc, pChan, pValue, &value, &type) != OK)
+		continue;
+	    pData = (void *)&value;
+	    count = 1;
+	}
+	(void)epicsTimeGetCurrent(&now);
+	if (pCauDesc->putMode == CAU_PUT_MODE_CALLBACK) {
+	    if (cauPutStart(pCxCmd, pCauDesc, pChan,
+					type, count, pData) == OK) {
+		cauPutCharge(pCauDesc, pChan, &now);
+		nPut++;
+	    }
+	}
+	else if (pData == (void *)&value)
+	    nPut += cauPutLimit(pCauDesc, pChan, type, pData);
+	else {
+	    cauCaDebugDbrAndName("prior to ca_array_put",
+						type, pChan->name, 0);
+	    stat = ca_array_put(type, count, pChan->pCh, pData);
+	    cauCaDebugStat("back from ca_array_put", stat, 0);
+	    if (stat != ECA_NORMAL)
+		(void)printf("error on ca_put for %s\n", pChan->name);
+	    else {
+		cauPutCharge(pCauDesc, pChan, &now);
+		nPut++;
+	    }
+	}
+	cauArrayRelease(pCauDesc, &array);
     }
-    pCauChan->pGRBuf->gstrval.status = -2;
-    getType = dbf_type_to_DBR_GR(pCauChan->dbfType);
-    sprintf(message, "prior to ca_array_get (%s)", dbr_type_to_text(getType));
-    cauCaDebug(message, 0);
-    stat = ca_array_get(getType, 1, pCauChan->pCh, pCauChan->pGRBuf);
-    cauCaDebugStat("back from ca_array_get", stat, 0);
-    if (stat != ECA_NORMAL) {
-	(void)printf("error getting graphics info for %s\n", chanName);
-	goto addError;
+    if (nPut == 0)
+	return;
+    if (pCauDesc->putMode == CAU_PUT_MODE_CALLBACK) {
+	cauCaDebug("prior to ca_flush_io", 0);
+	stat = ca_flush_io();
+	cauCaDebugStat("back from ca_flush_io", stat, 0);
+	return;
     }
     cauCaDebug("prior to ca_pend_io(1.0)", 0);
     stat = ca_pend_io(1.0);
-    cauCaDebugStat("back from ca_pend_io", stat, 0);
+    cauCaDebugStat("back from ca_pend_io(1.0)", stat, 0);
     if (stat != ECA_NORMAL) {
-	(void)printf("error getting graphics info for %s\n", chanName);
-	goto addError;
-    }
-    if (pCauChan->dbfType == DBF_CHAR)
-	pCauChan->units = pCauChan->pGRBuf->gchrval.units;
-    else if (pCauChan->dbfType == DBF_SHORT)
-	pCauChan->units = pCauChan->pGRBuf->gshrtval.units;
-    else if (pCauChan->dbfType == DBF_LONG)
-	pCauChan->units = pCauChan->pGRBuf->glngval.units;
-    else if (pCauChan->dbfType == DBF_FLOAT)
-	pCauChan->units = pCauChan->pGRBuf->gfltval.units;
-    else if (pCauChan->dbfType == DBF_DOUBLE)
-	pCauChan->units = pCauChan->pGRBuf->gdblval.units;
-
-#ifdef vxWorks
-    CauLock;
-#endif
-    DoubleListAppend(pCauChan, pCauDesc->pChanHead, pCauDesc->pChanTail);
-#ifdef vxWorks
-    CauUnlock;
-#endif
-
-    return pCauChan;
-addError:
-    if (pCauChan->pCh != NULL) {
-	cauCaDebugName("prior to ca_clear_channel", pCauChan->name, 0);
-	stat = ca_clear_channel(pCauChan->pCh);
-	cauCaDebugStat("back from ca_clear_channel", stat, 0);
+	(void)printf("error on ca_put\n");
+	return;
     }
-    if (pCauChan->pBuf != NULL)
-	free((char *)pCauChan->pBuf);
-    if (pCauChan->pGRBuf != NULL)
-	free((char *)pCauChan->pGRBuf);
-    return NULL;
+    return;
+putError:
+	(void)printf("you must specify a channel and a value\n");
 }
-
+
 /*+/subr**********************************************************************
-* NAME	cauChanDel - delete a channel from a cau descriptor
+* NAME	cau_putMode - select how the put command waits for completion
 *
 * DESCRIPTION
-*	This routine deletes a channel from a cau descriptor.
+*	pend, the default, waits (with ca_pend_io) until the puts have
+*	been accepted.  callback uses ca_put_callback, and reports the
+*	completion of each put, and its latency, as it happens.  With no
+*	option, the completion statistics are printed.
 *
 * RETURNS
-*	OK
+*	void
 *
 *-*/
-static long
-cauChanDel(pCxCmd, pCauDesc, pCauChan)
-CX_CMD	*pCxCmd;	/* I pointer to command context */
+static void
+cau_putMode(pCxCmd, pCauDesc)
+CX_CMD	*pCxCmd;	/* IO pointer to command context */
 CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
-CAU_CHAN *pCauChan;	/* IO pointer to cau channel descriptor */
 {
-    long	stat;           /* status return from calls */
-
-    assert(pCauDesc != NULL);
-    assert(pCauChan != NULL);
-
-#ifdef vxWorks
-    CauLock;
-#endif
-    DoubleListRemove(pCauChan, pCauDesc->pChanHead, pCauDesc->pChanTail);
-#ifdef vxWorks
-    CauUnlock;
-#endif
+    char	*opt;
 
-    if (pCauChan->pCh != NULL) {
-	cauCaDebugName("prior to cau_clear_channel", pCauChan->name, 0);
-	stat = ca_clear_channel(pCauChan->pCh);
-	cauCaDebugStat("back from ca_clear_channel", stat, 0);
-	if (stat != ECA_NORMAL) {
-	    (void)printf("error closing pCh for: %s\n",
-					    pCauChan->name);
-	}
+    if (nextNonSpaceField(&pCxCmd->pLine, &opt, &pCxCmd->delim) <= 1) {
+	(void)printf("%ld puts outstanding; %ld done, latency avg %.3f max %.3f ms\n",
+		pCauDesc->nPutOut, pCauDesc->nPutDone,
+		pCauDesc->nPutDone > 0 ?
+			1000. * pCauDesc->putLatSum / pCauDesc->nPutDone : 0.,
+		1000. * pCauDesc->putLatMax);
     }
-    if (pCauChan->pBuf != NULL)
-	free((char *)pCauChan->pBuf);
-    free((char *)pCauChan);
-
-    return OK;
+    else if (strcmp(opt, "pend") == 0)
+	pCauDesc->putMode = CAU_PUT_MODE_PEND;
+    else if (strcmp(opt, "callback") == 0)
+	pCauDesc->putMode = CAU_PUT_MODE_CALLBACK;
+    else
+	(void)printf("you must specify either pend or callback\n");
 }
-
+
 /*+/subr**********************************************************************
-* NAME	cauChanFind - find a channel in a cau descriptor
+* NAME	cau_putRate - limit the rate of puts
+*	putRate [chanRate [hostRate]]
 *
 * DESCRIPTION
-*	This routine finds a channel in a cau descriptor.
+*	Sets the most puts per second which will be sent to any one
+*	channel, and to all the channels on any one IOC host; 0 (the
+*	default) is no limit.  When values for a channel come faster than
+*	that, from put or from the signal generators, only the latest is
+*	sent (see cauPutLimit).  With no rates, the numbers of puts sent,
+*	coalesced, and dropped are printed, in total, for each host, and
+*	for each channel which has had puts coalesced.
 *
 * RETURNS
-*	CAU_CHAN * for channel, if found, or
-*	NULL
+*	void
 *
 *-*/
-static CAU_CHAN *
-cauChanFind(pCauDesc, chanName)
-CAU_DESC *pCauDesc;	/* I pointer to cau descriptor */
-char	*chanName;	/* I channel name to find in cau */
+static void
+cau_putRate(pCxCmd, pCauDesc)
+CX_CMD	*pCxCmd;	/* IO pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 {
+    double	chanRate;	/* max puts/sec per channel */
+    double	hostRate;	/* max puts/sec per IOC host */
+    CAU_HOST	*pHost;		/* pointer to host descriptor */
     CAU_CHAN	*pChan;		/* pointer to channel descriptor */
 
-    assert(pCauDesc != NULL);
-    assert(chanName != NULL);
-
-    pChan = pCauDesc->pChanHead;
-    while (pChan != NULL) {
-        if (strcmp(pChan->name, chanName) == 0)
-	    break;
-	pChan = pChan->pNext;
+    if (nextFltFieldAsDbl(&pCxCmd->pLine, &chanRate, &pCxCmd->delim) > 1) {
+	if (nextFltFieldAsDbl(&pCxCmd->pLine, &hostRate,
+						&pCxCmd->delim) <= 1)
+	    hostRate = 0.;
+	if (chanRate < 0. || hostRate < 0.) {
+	    (void)printf("rates must be 0 (no limit) or more\n");
+	    return;
+	}
+	pCauDesc->putChanRate = chanRate;
+	pCauDesc->putHostRate = hostRate;
+	return;
+    }
+    (void)printf(
+		"putRate %g/sec per channel, %g/sec per host (0 is no limit)\n",
+		pCauDesc->putChanRate, pCauDesc->putHostRate);
+    (void)printf("%ld sent, %ld coalesced, %ld dropped, %d held\n",
+			pCauDesc->nPutSent, pCauDesc->nPutCoalesced,
+			pCauDesc->nPutDropped, pCauDesc->putHeap.nTmr);
+    for (pHost=pCauDesc->pHostHead; pHost!=NULL; pHost=pHost->pNext) {
+	if (pHost->nPutSent > 0 || pHost->nPutCoalesced > 0) {
+	    (void)printf("  host %-30s %8ld sent %8ld coalesced\n",
+			pHost->name, pHost->nPutSent, pHost->nPutCoalesced);
+	}
+    }
+    for (pChan=pCauDesc->pChanHead; pChan!=NULL; pChan=pChan->pNext) {
+	if (pChan->nPutCoalesced > 0) {
+	    (void)printf("  %-35s %8ld coalesced\n",
+			pChan->name, pChan->nPutCoalesced);
+	}
     }
-
-    return pChan;
 }
-
+
 /*+/subr**********************************************************************
-* NAME	cauFree - free a cau descriptor, after cleaning up
-*
-* DESCRIPTION
-*	This routine cleans up a cau descriptor, closing channels, etc.,
-*	and then free()'s the data structures.
-*
-* RETURNS
-*	OK
-*
+* NAME	cau_ramp
+*	ramp[,[secPerStep],[nSteps],[begVal],[endVal]] chanName [chanName ...]
 *-*/
-static long
-cauFree(pCxCmd, pCauDesc)
-CX_CMD	*pCxCmd;	/* I pointer to command context */
+static void
+cau_ramp(pCxCmd, pCauDesc)
+CX_CMD	*pCxCmd;	/* IO pointer to command context */
 CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 {
-    long	retStat=OK;/* return status to caller */
-
-    assert(pCauDesc != NULL);
+    CAU_CHAN	*pChan;		/* temp for channel pointer */
+    CAU_PATTERN	pat;		/* compiled pattern */
+    int		isPat;		/* 1 says name is a pattern */
+    int		stopFlag;	/* 1 indicates to stop an activity */
+    int		grNeed;		/* CAU_GR_NEED_xxx for ramp limits */
 
-    while (pCauDesc->pChanHead != NULL) {
-	if (cauChanDel(pCxCmd, pCauDesc, pCauDesc->pChanHead) != OK)
-	    (void)printf("cauFree: error deleting channel\n");
-    }
-    while (pCauDesc->pChanConnHead != NULL) {
-	if (cauChanDel(pCxCmd, pCauDesc, pCauDesc->pChanConnHead) != OK)
-	    (void)printf("cauFree: error deleting channel\n");
+    if (pCxCmd->delim == '-')
+	stopFlag = 1;
+    else {
+	stopFlag = 0;
+	if (cauSigGenGetParams(pCxCmd, pCauDesc) != OK)
+	    return;
     }
+    if (pCauDesc->endVal == pCauDesc->begVal)
+	grNeed = CAU_GR_NEED_ALL;
+    else
+	grNeed = CAU_GR_NEED_NONE;
 
-    return retStat;
+    pCxCmd->fldLen =
+	    nextChanNameField(&pCxCmd->pLine, &pCxCmd->pField, &pCxCmd->delim);
+    if (pCxCmd->fldLen <= 1 || strcmp(pCxCmd->pField, "all") == 0) {
+	if ((pChan = pCauDesc->pChanHead) == NULL) {
+	    (void)printf("no channels selected\n");
+	    return;
+	}
+	if (!stopFlag)
+	    cauChanGRAll(pCauDesc, grNeed);
+	while (pChan != NULL) {
+	    if (stopFlag) {
+		if (CauSigGenFn(pChan) == cauSigGenRamp)
+		    cauSigGenStop(pCauDesc, pChan);
+	    }
+	    else
+		cauSigGenRampAdd(pCxCmd, pCauDesc, pChan);
+	    pChan = pChan->pNext;
+	}
+	return;
+    }
+    if (!stopFlag)
+	cauChanAddList(pCxCmd, pCauDesc, grNeed);
+    while (pCxCmd->fldLen > 1) {
+	if ((isPat = cauPatternCompile(&pat, pCxCmd->pField)) != 0) {
+	    if ((pChan = cauChanMatchFirst(pCauDesc, &pat)) == NULL)
+		(void)printf("no channels match %s\n", pCxCmd->pField);
+	}
+	else if ((pChan = cauChanFind(pCauDesc, pCxCmd->pField)) == NULL) {
+	    if (stopFlag) {
+		(void)printf("couldn't find %s \n", pCxCmd->pField);
+	    }
+	    else
+		pChan = cauChanAdd(pCxCmd, pCauDesc, pCxCmd->pField);
+	    if (pChan == NULL)
+		(void)printf("couldn't open %s \n",pCxCmd->pField);
+	}
+	while (pChan != NULL) {
+	    if (stopFlag) {
+		if (CauSigGenFn(pChan) == cauSigGenRamp)
+		    cauSigGenStop(pCauDesc, pChan);
+		else if (!isPat) {
+		    (void)printf("%s not in ramp mode\n", pChan->name);
+		}
+	    }
+	    else if (CauSigGenFn(pChan) == cauSigGenRamp) {
+		(void)printf("%s already in ramp mode\n", pChan->name);
+	    }
+	    else
+		cauSigGenRampAdd(pCxCmd, pCauDesc, pChan);
+	    pChan = isPat ? cauChanMatchNext(pCauDesc, &pat) : NULL;
+	}
+	pCxCmd->fldLen =
+	    nextChanNameField(&pCxCmd->pLine, &pCxCmd->pField, &pCxCmd->delim);
+    }
 }
 
 /*+/subr**********************************************************************
-* NAME	cauGetAndPrint - get and print the value for a channel
+* NAME	cau_restore
+*	restore filePath
 *
 * DESCRIPTION
-*	This routine gets the current value for the channel and prints it
+*	Reads a snapshot file written by the snapshot command and puts the
+*	values back, as their native type.  Channels which aren't in the
+*	list are connected first, in one batch.  All the puts are sent
+*	with a single flush.
 *
-* RETURNS
-*	void
+*	The whole file is read and checked before anything is connected
+*	or put; if any of it is damaged, nothing is restored.
+*
+*	Channels which don't connect, or whose native type has changed
+*	since the snapshot, aren't restored.  If a channel's element
+*	count has changed, the smaller count is put.  Each such mismatch
+*	is reported.
 *
 *-*/
 static void
-cauGetAndPrint(pCxCmd,
-		pCauDesc, pChan, printTime, printDBRType, printENUMAsShort)
+cau_restore(pCxCmd, pCauDesc)
 CX_CMD	*pCxCmd;	/* IO pointer to command context */
 CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
-CAU_CHAN *pChan;	/* I channel pointer */
-int	printTime;	/* I 1 if time is to be printed */
-int	printDBRType;	/* I 1 if DBR_type of channel is to be printed */
-int	printENUMAsShort;/* I 1 if DBR_ENUM is to be printed as short */
 {
     long	stat;
-    cauCaDebugDbrAndName("prior to ca_array_get",pChan->dbrType,pChan->name,0);
-    stat = ca_array_get(pChan->dbrType, pChan->reqCount,pChan->pCh,pChan->pBuf);
-    cauCaDebugStat("back from ca_array_get", stat, 0);
-    if (stat != ECA_NORMAL)
-	(void)printf("error on ca_array_get for %s \n", pChan->name);
-    else {
-	cauCaDebug("prior to ca_pend_io(1.0)", 0);
-	stat = ca_pend_io(1.0);
-	cauCaDebugStat("back from ca_pend_io(1.0)", stat, 0);
-	if (stat != ECA_NORMAL)
-	    (void)printf("error on ca_array_get for %s \n", pChan->name);
-	else {
-	    cauPrintBuf(pCxCmd,
-		    pChan, 1, printTime, printDBRType, printENUMAsShort, 0);
+    FILE	*pFile;		/* snapshot file */
+    CAU_SNAP_HDR hdr;		/* header from file */
+    CAU_SNAP_ITEM *pItem=NULL;	/* channels from file */
+    CAU_SNAP_ITEM *pIt;		/* pointer to a channel's item */
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    long	nItem=0;	/* number of items read */
+    long	count;		/* number of elements to put */
+    long	nPut=0;		/* number of channels put */
+    long	nMismatch=0;	/* number of mismatches */
+    long	i;
+
+    if (nextNonSpaceField(&pCxCmd->pLine, &pCxCmd->pField,
+						&pCxCmd->delim) <= 1) {
+	(void)printf("you must specify a file\n");
+	return;
+    }
+    if ((pFile = fopen(pCxCmd->pField, "rb")) == NULL) {
+	(void)printf("couldn't open %s\n", pCxCmd->pField);
+	return;
+    }
+    if (fread((char *)&hdr, sizeof(hdr), 1, pFile) != 1 ||
+			hdr.magic != CAU_SNAP_MAGIC ||
+			hdr.version != CAU_SNAP_VERSION || hdr.nEntry < 0 ||
+			hdr.nEntry > CAU_SNAP_ENTRY_MAX) {
+	(void)printf("%s isn't a cau snapshot file\n", pCxCmd->pField);
+	(void)fclose(pFile);
+	return;
+    }
+    if (hdr.nEntry > 0 && (pItem = (CAU_SNAP_ITEM *)calloc(
+			(size_t)hdr.nEntry, sizeof(CAU_SNAP_ITEM))) == NULL) {
+	(void)printf("malloc error\n");
+	(void)fclose(pFile);
+	return;
+    }
+
+/*-----------------------------------------------------------------------------
+*    read and check all the channels
+*----------------------------------------------------------------------------*/
+    for (nItem=0; nItem<hdr.nEntry; nItem++) {
+	pIt = &pItem[nItem];
+	if (fread((char *)&pIt->entry, sizeof(pIt->entry), 1, pFile) != 1 ||
+		    pIt->entry.nameLen <= 0 ||
+		    pIt->entry.nameLen >= db_name_dim ||
+		    !dbf_type_is_valid(pIt->entry.dbfType) ||
+		    pIt->entry.count <= 0 ||
+		    pIt->entry.nBytes <= 0 ||
+		    pIt->entry.nBytes > CAU_SNAP_BYTES_MAX ||
+		    pIt->entry.count > pIt->entry.nBytes ||
+		    (unsigned long)pIt->entry.nBytes != dbr_size_n(
+			dbf_type_to_DBR_TIME(pIt->entry.dbfType),
+			pIt->entry.count) ||
+		    fread(pIt->name, (size_t)pIt->entry.nameLen, 1, pFile) != 1) {
+	    (void)printf("%s is damaged after %ld channels\n",
+						pCxCmd->pField, nItem);
+	    break;
+	}
+	pIt->name[pIt->entry.nameLen] = '\0';
+	pIt->bufSize = (size_t)pIt->entry.nBytes;
+	pIt->pBuf = (union db_access_val *)cauBufGet(pCauDesc, pIt->bufSize);
+	if (pIt->pBuf == NULL) {
+	    (void)printf("malloc error\n");
+	    break;
+	}
+	if (fread((char *)pIt->pBuf, pIt->bufSize, 1, pFile) != 1) {
+	    (void)printf("%s is damaged after %ld channels\n",
+						pCxCmd->pField, nItem);
+	    cauBufPut(pCauDesc, pIt->pBuf, pIt->bufSize);
+	    break;
+	}
+    }
+    (void)fclose(pFile);
+    if (nItem < hdr.nEntry) {
+	(void)printf("no channels restored\n");
+	goto restoreDone;
+    }
+
+/*-----------------------------------------------------------------------------
+*    start the searches for channels which aren't in the list
+*----------------------------------------------------------------------------*/
+    pCauDesc->connBatch++;
+    pCauDesc->nConnWait = 0;
+    for (i=0; i<nItem; i++) {
+	if (cauChanLookup(pCauDesc, pItem[i].name) == NULL)
+	    (void)cauChanAddStart(pCxCmd, pCauDesc, pItem[i].name);
+    }
+    if (pCauDesc->nConnWait > 0)
+	cauChanConnWait(pCauDesc);
+
+/*-----------------------------------------------------------------------------
+*    check each channel against the snapshot and send the puts
+*----------------------------------------------------------------------------*/
+    for (i=0; i<nItem; i++) {
+	pIt = &pItem[i];
+	if ((pChan = cauChanFind(pCauDesc, pIt->name)) == NULL ||
+				pChan->connState != CAU_CONN_OK) {
+	    (void)printf("%s not connected; not restored\n", pIt->name);
+	    nMismatch++;
+	    continue;
+	}
+	if (ca_field_type(pChan->pCh) != pIt->entry.dbfType) {
+	    (void)printf("%s type is %s, was %s; not restored\n", pIt->name,
+			dbf_type_to_text(ca_field_type(pChan->pCh)),
+			dbf_type_to_text(pIt->entry.dbfType));
+	    nMismatch++;
+	    continue;
+	}
+	count = pIt->entry.count;
+	if (count != (long)ca_element_count(pChan->pCh)) {
+	    (void)printf("%s count is %ld, was %ld\n", pIt->name,
+			(long)ca_element_count(pChan->pCh), pIt->entry.count);
+	    nMismatch++;
+	    if (count > (long)ca_element_count(pChan->pCh))
+		count = ca_element_count(pChan->pCh);
+	}
+	cauCaDebugDbrAndName("prior to ca_array_put",
+		dbf_type_to_DBR(pIt->entry.dbfType), pIt->name, 0);
+	stat = ca_array_put(dbf_type_to_DBR(pIt->entry.dbfType), count,
+		pChan->pCh, dbr_value_ptr(pIt->pBuf,
+		dbf_type_to_DBR_TIME(pIt->entry.dbfType)));
+	cauCaDebugStat("back from ca_array_put", stat, 0);
+	if (stat != ECA_NORMAL) {
+	    (void)printf("error on ca_array_put for %s\n", pIt->name);
+	    continue;
 	}
+	nPut++;
     }
+    cauCaDebug("prior to ca_flush_io", 0);
+    stat = ca_flush_io();
+    cauCaDebugStat("back from ca_flush_io", stat, 0);
+    (void)printf("%ld of %ld channels restored, %ld mismatches\n",
+						nPut, hdr.nEntry, nMismatch);
+
+restoreDone:
+    for (i=0; i<nItem; i++)
+	cauBufPut(pCauDesc, pItem[i].pBuf, pItem[i].bufSize);
+    if (pItem != NULL)
+	free((char *)pItem);
 }
-
+
 /*+/subr**********************************************************************
-* NAME	cauInitAtStartup - initialization for cau
+* NAME	cau_shards
+*	shards [n]
+*-*/
+static void
+cau_shards(pCxCmd, pCauDesc)
+CX_CMD	*pCxCmd;	/* IO pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+#ifdef CAU_SHARDS
+    CAU_SHARD	*pShard;	/* pointer to shard */
+    int		nShard;		/* number of shards */
+    int		nChan;		/* number of channels in shard */
+    unsigned long nMon;		/* number of monitors handled by shard */
+    unsigned long nDrop;	/* number of updates dropped by shard */
+    int		i;
+
+    if (nextIntFieldAsInt(&pCxCmd->pLine, &nShard, &pCxCmd->delim) > 1) {
+	if (nShard < 0 || nShard > CAU_SHARD_DIM) {
+	    (void)printf("number of shards must be 0 to %d\n", CAU_SHARD_DIM);
+	    return;
+	}
+	if (cauShardsSet(pCxCmd, pCauDesc, nShard) != OK)
+	    (void)printf("couldn't start %d shards\n", nShard);
+	return;
+    }
+    if (pCauDesc->nShard == 0) {
+	(void)printf("monitors are handled by cauTask (no shards)\n");
+	return;
+    }
+    for (i=0; i<pCauDesc->nShard; i++) {
+	pShard = &pCauDesc->pShard[i];
+	epicsMutexMustLock(pShard->lock);
+	nChan = pShard->nChan;
+	nMon = pShard->nMon;
+	nDrop = pShard->nDrop;
+	epicsMutexUnlock(pShard->lock);
+	(void)printf("shard %2d: %6d channels, %10lu monitors, %lu dropped\n",
+							i, nChan, nMon, nDrop);
+    }
+#else
+    (void)printf("shards aren't available on this system\n");
+#endif
+}
+
+/*+/subr**********************************************************************
+* NAME	cau_snapshot
+*	snapshot filePath [chanName [chanName ...]]
 *
 * DESCRIPTION
-*	Perform several initialization duties:
-*	o   initialize an empty cau descriptor.  In order to
-*	    use the CAU_DESC, channels must be specified.
-*	o   initialize the command context block
-*	o   initialize the help information
-*
-* RETURNS
-*	void
+*	Gets the values of the channels (or of all connected channels, if
+*	none are named) and writes them to a snapshot file, with their
+*	time stamps, as their native type and with all their elements.
+*	Names may be patterns.  All the gets are sent before waiting, with
+*	a single ca_pend_io; channels which don't answer are reported and
+*	left out of the file.
 *
 *-*/
 static void
-cauInitAtStartup(pCauDesc, pCxCmd)
-CAU_DESC *pCauDesc;	/* O pointer to cau descriptor */
-CX_CMD	*pCxCmd;	/* I pointer to command context */
+cau_snapshot(pCxCmd, pCauDesc)
+CX_CMD	*pCxCmd;	/* IO pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 {
-    pCauDesc->pCxCmd = pCxCmd;
-    pCauDesc->pChanHead = NULL;
-    pCauDesc->pChanTail = NULL;
-    pCauDesc->pChanConnHead = NULL;
-    pCauDesc->pChanConnTail = NULL;
-    pCauDesc->secPerStep = .5;
-    pCauDesc->nSteps = 10;
-    pCauDesc->begVal = 0.;
-    pCauDesc->endVal = 0.;
+    long	stat;
+    FILE	*pFile;		/* snapshot file */
+    char	*path;		/* path for snapshot file */
+    CAU_SNAP_HDR hdr;		/* header for file */
+    CAU_SNAP_ITEM *pItem=NULL;	/* channels for snapshot */
+    CAU_SNAP_ITEM *pIt;		/* pointer to a channel's item */
+    CAU_SNAP_ITEM *pNew;	/* pointer to expanded items */
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    CAU_PATTERN	pat;		/* compiled pattern */
+    int		isPat;		/* 1 says name is a pattern */
+    int		all;		/* 1 says snapshot all channels */
+    long	nItem=0;	/* number of items */
+    long	itemDim=0;	/* dimension of pItem */
+    chtype	type;		/* DBR_TIME_xxx type for channel */
+    long	i;
 
-    cmdInitContext(pCxCmd, "  cau:  ");
+    if (nextNonSpaceField(&pCxCmd->pLine, &path, &pCxCmd->delim) <= 1) {
+	(void)printf("you must specify a file\n");
+	return;
+    }
+    pCxCmd->fldLen =
+	    nextChanNameField(&pCxCmd->pLine, &pCxCmd->pField, &pCxCmd->delim);
+    if ((all = pCxCmd->fldLen <= 1) == 0)
+	cauChanAddList(pCxCmd, pCauDesc, CAU_GR_NEED_NONE);
 
 /*-----------------------------------------------------------------------------
-* help information initialization
-*----------------------------------------------------------------------------*/
-    helpInit(&pCxCmd->helpList);
-/*-----------------------------------------------------------------------------
-* help info--generic commands
-*----------------------------------------------------------------------------*/
-    helpTopicAdd(&pCxCmd->helpList, &pCxCmd->helpCmds, "commands", "\n\
-Generic commands are:\n\
-   dataOut    [filePath]     (default is to normal output)\n\
-   bg\n\
-   help       [topic]\n\
-   quit (or ^D)\n\
-   source     filePath\n\
-");
-/*-----------------------------------------------------------------------------
-* help info--cau-specific commands
-*----------------------------------------------------------------------------*/
-    helpTopicAdd(&pCxCmd->helpList, &pCxCmd->helpCmdsSpec, "commands", "\n\
-cau-specific commands are (the * isn't part of the command):\n\
-   deadband      opt  (where opt is either MDEL or ADEL)\n\
-   debug         [n]  (where n can be 0, 1, 2, or 3; if n omitted, level++)\n\
-   debug-\n\
-   delete        chanName [chanName ...]  (or  all )\n\
-   get[,count]   [chanName [chanName ...]]\n\
-  *info          [chanName [chanName ...]]\n\
-  *interval,sec[,jitter]  [chanName [chanName ...]]\n\
-   interval-     [chanName [chanName ...]]\n\
-  *monitor[,count] [chanName [chanName ...]]\n\
-   monitor-      [chanName [chanName ...]]\n\
-   put           chanName value               (or \"value\")\n\
-   ramp[,params] chanName [chanName ...]]  (use help ramp for more info)\n\
-   ramp-         [chanName [chanName ...]]\n\
-\n\
-Output from commands flagged with * can be routed to a file by using the\n\
-\"dataOut filePath\" command.  The present contents of the file are\n\
-preserved, with new output being written at the end.\n\
-");
-/*-----------------------------------------------------------------------------
-* help info--debug command
-*----------------------------------------------------------------------------*/
-    helpTopicAdd(&pCxCmd->helpList, &helpDebug, "debug", "\n\
-   debug      [n]  (where n can be 0, 1, 2, or 3; if n omitted, level++)\n\
-   debug-\n\
-\n\
-The debug command sets a `debug level' which is used to control the\n\
-printing of debug information from Channel Access.  The debug command\n\
-without a value increments the debug level; the debug- command decrements\n\
-the debug level.  A specific level can be set by specifying a number\n\
-following the debug command.  The levels and their result are:\n\
-	0	don't print debug information\n\
-	1	print message before and after most ca_xxx calls\n\
-	2	print message at entry and exit to monitor handler\n\
-	3	print message before and after ca_pend_event in main loop\n\
-");
-/*-----------------------------------------------------------------------------
-* help info--bg command
+*    collect the channels
 *----------------------------------------------------------------------------*/
-    helpTopicAdd(&pCxCmd->helpList, &pCxCmd->helpBg, "bg", "\n\
-The bg command under vxWorks allows the cau process to continue\n\
-running without accepting commands from the keyboard.  This allows the\n\
-vxWorks shell to be used for other purposes without the need to\n\
-terminate cau.\n\
-\n\
-Under SunOS, no bg command is directly available.  Instead, if cau\n\
-is being run from the C shell (csh), it can be detached using several\n\
-steps from the keyboard (with the first % on each line being the prompt\n\
-from csh):\n\
-	type ^Z, then type\n\
-	% bg %cau\n\
-\n\
-To move cau to the foreground, type\n\
-	% fg % cau\n\
-");
+    pChan = all ? pCauDesc->pChanHead : NULL;
+    isPat = 0;
+    while (all ? pChan != NULL : pCxCmd->fldLen > 1) {
+	if (!all) {
+	    if ((isPat = cauPatternCompile(&pat, pCxCmd->pField)) != 0)
+		pChan = cauChanMatchFirst(pCauDesc, &pat);
+	    else
+		pChan = cauChanFind(pCauDesc, pCxCmd->pField);
+	    if (pChan == NULL)
+		(void)printf("no channels match %s\n", pCxCmd->pField);
+	}
+	while (pChan != NULL) {
+	    if (pChan->connState != CAU_CONN_OK)
+		(void)printf("%s not connected\n", pChan->name);
+	    else {
+		if (nItem >= itemDim) {
+		    itemDim = itemDim > 0 ? 2 * itemDim : CAU_HASH_DIM;
+		    pNew = (CAU_SNAP_ITEM *)realloc((char *)pItem,
+					itemDim * sizeof(CAU_SNAP_ITEM));
+		    if (pNew == NULL) {
+			(void)printf("malloc error\n");
+			goto snapDone;
+		    }
+		    pItem = pNew;
+		}
+		pIt = &pItem[nItem];
+		pIt->pChan = pChan;
+		pIt->entry.dbfType = pChan->dbfType;
+		pIt->entry.count = pChan->elCount;
+		pIt->entry.nameLen = strlen(pChan->name);
+		type = dbf_type_to_DBR_TIME(pChan->dbfType);
+		pIt->bufSize = dbr_size_n(type, pChan->elCount);
+		pIt->entry.nBytes = (long)pIt->bufSize;
+		pIt->pBuf = (union db_access_val *)cauBufGet(pCauDesc,
+								pIt->bufSize);
+		if (pIt->pBuf == NULL) {
+		    (void)printf("malloc error\n");
+		    goto snapDone;
+		}
+		nItem++;
+	    }
+	    if (all)
+		pChan = pChan->pNext;
+	    else
+		pChan = isPat ? cauChanMatchNext(pCauDesc, &pat) : NULL;
+	}
+	if (!all) {
+	    pCxCmd->fldLen = nextChanNameField(&pCxCmd->pLine,
+					&pCxCmd->pField, &pCxCmd->delim);
+	}
+    }
+    if (nItem == 0) {
+	(void)printf("no channels selected\n");
+	goto snapDone;
+    }
+
 /*-----------------------------------------------------------------------------
-* help info--interval command
+*    send all the gets, then wait once
 *----------------------------------------------------------------------------*/
-    helpTopicAdd(&pCxCmd->helpList, &helpInterval, "interval", "\n\
-The interval command provides for testing the interval between\n\
-successive samples on a channel (or on several channels).  A Channel\n\
-Access monitor is placed on the channel.  Each time a value is received,\n\
-the difference between its time stamp and the time stamp of the prior\n\
-value is computed.  If the difference is outside the specified tolerance,\n\
-then a message is printed.  The two valid forms of the command are:\n\
-\n\
-  *interval,sec[,jitter]  [chanName [chanName ...]]\n\
-   interval-  [chanName [chanName ...]]\n\
-\n\
-The allowable intervals are  \"sec - jitter\" to \"sec + jitter\", inclusive.\n\
-Because of rounding errors, some leeway should be implicit in the\n\
-specification of jitter.  For example, to test BSD_21N:00:00 for a 1\n\
-second interval, plus or minus 4 milli-seconds, use:\n\
-\n\
-   interval,1,.0041 BSD_21N:00:00\n\
-\n\
-Several interval tests can be operating simultaneously on different sets\n\
-of channels; a particular channel can't processed by two different interval\n\
-commands at once.\n\
-\n\
-In addition to the functionality just described, each channel is checked\n\
-periodically to see that it is still sending data.  If no value has been\n\
-received for (1 second + intervalTime) then an error message is printed\n\
-for the channel.\n\
-");
+    for (i=0; i<nItem; i++) {
+	pIt = &pItem[i];
+	pIt->pBuf->tstrval.status = CAU_GET_PEND;
+	type = dbf_type_to_DBR_TIME(pIt->entry.dbfType);
+	cauCaDebugDbrAndName("prior to ca_array_get", type,
+						pIt->pChan->name, 0);
+	stat = ca_array_get(type, pIt->entry.count, pIt->pChan->pCh,
+								pIt->pBuf);
+	cauCaDebugStat("back from ca_array_get", stat, 0);
+	if (stat != ECA_NORMAL) {
+	    (void)printf("error on ca_array_get for %s \n",
+							pIt->pChan->name);
+	}
+    }
+    cauCaDebug("prior to ca_pend_io", 0);
+    stat = ca_pend_io(CAU_GET_TMO);
+    cauCaDebugStat("back from ca_pend_io", stat, 0);
+
 /*-----------------------------------------------------------------------------
-* help info--ramp command information
+*    write the file
 *----------------------------------------------------------------------------*/
-    helpTopicAdd(&pCxCmd->helpList, &helpRamp, "ramp", "\n\
-The ramp command can be used for numeric, enumerated, or string channels.\n\
-Optional parameters specify the delay time between steps in a cycle,\n\
-the number of steps per cycle, the beginning value, and the ending value.\n\
+    if ((pFile = fopen(path, "wb")) == NULL) {
+	(void)printf("couldn't open %s\n", path);
+	goto snapDone;
+    }
+    hdr.magic = CAU_SNAP_MAGIC;
+    hdr.version = CAU_SNAP_VERSION;
+    hdr.nEntry = 0;
+    (void)fwrite((char *)&hdr, sizeof(hdr), 1, pFile);
+    for (i=0; i<nItem; i++) {
+	pIt = &pItem[i];
+	if (pIt->pBuf->tstrval.status == CAU_GET_PEND) {
+	    (void)printf("timeout on ca_array_get for %s; not saved\n",
+							pIt->pChan->name);
+	    continue;
+	}
+	(void)fwrite((char *)&pIt->entry, sizeof(pIt->entry), 1, pFile);
+	(void)fwrite(pIt->pChan->name, (size_t)pIt->entry.nameLen, 1, pFile);
+	(void)fwrite((char *)pIt->pBuf, pIt->bufSize, 1, pFile);
+	hdr.nEntry++;
+    }
+    rewind(pFile);
+    (void)fwrite((char *)&hdr, sizeof(hdr), 1, pFile);
+    if (ferror(pFile) || fclose(pFile) != 0)
+	(void)printf("error writing %s\n", path);
+    else {
+	(void)printf("%ld of %ld channels saved in %s\n",
+						hdr.nEntry, nItem, path);
+    }
+
+snapDone:
+    for (i=0; i<nItem; i++)
+	cauBufPut(pCauDesc, pItem[i].pBuf, pItem[i].bufSize);
+    if (pItem != NULL)
+	free((char *)pItem);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauArrayFile - get the contents of an array file
+*
+* DESCRIPTION
+*	Maps the file into memory (read only, and private), or, where
+*	files can't be mapped, reads it into a malloc'd buffer.
+*
+* RETURNS
+*	OK, or
+*	ERROR
+*
+*-*/
+static long
+cauArrayFile(path, pArray)
+char	*path;		/* I path of file */
+CAU_ARRAY *pArray;	/* IO array; pFile, fileSize, fileMapped are set */
+{
+#ifdef CAU_MMAP_ARRAY
+    int		fd;		/* file descriptor */
+    struct stat	st;		/* file status */
+    void	*pMap;		/* pointer to mapping */
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+	(void)printf("couldn't open %s\n", path);
+	return ERROR;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+	(void)printf("%s is empty\n", path);
+	(void)close(fd);
+	return ERROR;
+    }
+    pMap = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    (void)close(fd);
+    if (pMap == MAP_FAILED) {
+	(void)printf("can't map %s\n", path);
+	return ERROR;
+    }
+    pArray->pFile = (char *)pMap;
+    pArray->fileSize = (size_t)st.st_size;
+    pArray->fileMapped = 1;
+    return OK;
+#else
+    FILE	*pFile;		/* array file */
+    long	size;		/* size of file, in bytes */
+
+    if ((pFile = fopen(path, "rb")) == NULL) {
+	(void)printf("couldn't open %s\n", path);
+	return ERROR;
+    }
+    if (fseek(pFile, 0L, SEEK_END) != 0 || (size = ftell(pFile)) <= 0) {
+	(void)printf("%s is empty\n", path);
+	(void)fclose(pFile);
+	return ERROR;
+    }
+    rewind(pFile);
+    if ((pArray->pFile = (char *)malloc((size_t)size)) == NULL) {
+	(void)printf("malloc error\n");
+	(void)fclose(pFile);
+	return ERROR;
+    }
+    if (fread(pArray->pFile, 1, (size_t)size, pFile) != (size_t)size) {
+	(void)printf("error reading %s\n", path);
+	free(pArray->pFile);
+	pArray->pFile = NULL;
+	(void)fclose(pFile);
+	return ERROR;
+    }
+    (void)fclose(pFile);
+    pArray->fileSize = (size_t)size;
+    pArray->fileMapped = 0;
+    return OK;
+#endif
+}
+
+/*+/subr**********************************************************************
+* NAME	cauArrayLoad - get an array value for put
+*
+* DESCRIPTION
+*	Gets the array, as the channel's native type, from one of:
+*	o  [v1,v2,...]  inline values, separated by commas or (if the
+*	   value is quoted) blanks
+*	o  @filePath    a text file, holding numbers separated by commas
+*	   or white space
+*	o  @@filePath   a binary file, holding elements of the channel's
+*	   native type, in this host's byte order
+*
+*	Inline values and text files are converted in a single pass (see
+*	cauArrayParse).  A binary file is checked only for its size; its
+*	elements are put as they are, straight from the file's mapping.
+*	The number of elements must not be more than the channel's
+*	element count; if it is less, only that many are put.
+*
+*	When the put has been sent, the caller must call cauArrayRelease.
+*
+* RETURNS
+*	OK, or
+*	ERROR if the array can't be put
+*
+*-*/
+static long
+cauArrayLoad(pCauDesc, pChan, pText, pArray)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+char	*pText;		/* I array value, as text */
+CAU_ARRAY *pArray;	/* O array, as native type */
+{
+    char	*pEnd;		/* end of inline values */
+    char	*pPath;		/* path of array file */
+    int		binary=0;	/* 1 says file is binary */
+    size_t	elSize;		/* size of an element, in bytes */
+    long	stat;
+
+    pArray->pData = NULL;
+    pArray->count = 0;
+    pArray->pBuf = NULL;
+    pArray->bufSize = 0;
+    pArray->pFile = NULL;
+    pArray->fileSize = 0;
+    pArray->fileMapped = 0;
+    if (*pText == '[') {
+	if ((pEnd = strchr(pText, ']')) == NULL) {
+	    (void)printf("missing ] in array value for %s\n", pChan->name);
+	    return ERROR;
+	}
+	return cauArrayParse(pCauDesc, pChan, pText+1, pEnd, pArray);
+    }
+    pPath = pText + 1;
+    if (*pPath == '@') {
+	binary = 1;
+	pPath++;
+    }
+    if (*pPath == '\0') {
+	(void)printf("you must specify a file for %s\n", pChan->name);
+	return ERROR;
+    }
+    if (cauArrayFile(pPath, pArray) != OK)
+	return ERROR;
+    if (!binary) {
+	stat = cauArrayParse(pCauDesc, pChan, pArray->pFile,
+				pArray->pFile + pArray->fileSize, pArray);
+	if (stat != OK)
+	    cauArrayRelease(pCauDesc, pArray);
+	return stat;
+    }
+    elSize = dbr_value_size[dbf_type_to_DBR(pChan->dbfType)];
+    if (pArray->fileSize % elSize != 0) {
+	(void)printf("size of %s isn't a multiple of %s's %d byte elements\n",
+				pPath, pChan->name, (int)elSize);
+	cauArrayRelease(pCauDesc, pArray);
+	return ERROR;
+    }
+    pArray->count = pArray->fileSize / elSize;
+    if (pArray->count > pChan->elCount) {
+	(void)printf("%s has %lu elements; %s only has %lu\n",
+			pPath, pArray->count, pChan->name, pChan->elCount);
+	cauArrayRelease(pCauDesc, pArray);
+	return ERROR;
+    }
+    pArray->pData = (void *)pArray->pFile;
+    return OK;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauArrayParse - convert array text to the native type
+*
+* DESCRIPTION
+*	Converts the numbers in the text, which are separated by commas
+*	or white space, into a buffer of the channel's native type.  The
+*	buffer is sized for the channel's element count.  Each number is
+*	checked against the range of the native type and, if the channel
+*	has them, its control limits.  For CHAR, SHORT, LONG, and ENUM
+*	channels, each number must be a whole number (for ENUM channels,
+*	a state number); as with cauPutConvert, nothing is rounded.
+*
+*	The text needn't be terminated by '\0', so it can be a file's
+*	mapping; it is never read beyond pEnd.
+*
+* RETURNS
+*	OK, or
+*	ERROR
+*
+*-*/
+static long
+cauArrayParse(pCauDesc, pChan, pBeg, pEnd, pArray)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+char	*pBeg;		/* I first character of text */
+char	*pEnd;		/* I end of text (character after last) */
+CAU_ARRAY *pArray;	/* IO array; pBuf, pData, and count are set */
+{
+    union db_access_val *pGR;	/* pointer to graphics info, or NULL */
+    char	num[CAU_ARRAY_NUM_DIM];/* one number, as text */
+    char	*pNumEnd;	/* end of converted number */
+    double	dbl;		/* value, as double */
+    double	lo, hi;		/* control limits */
+    double	min, max;	/* range of native type */
+    unsigned long n=0;		/* number of elements converted */
+    int		len;		/* length of number */
+
+    pGR = cauChanGRFetch(pCauDesc, pChan, CAU_GR_NEED_ALL);
+    cauPutRange(pChan, pGR, &min, &max, &lo, &hi);
+    pArray->bufSize = pChan->elCount *
+			dbr_value_size[dbf_type_to_DBR(pChan->dbfType)];
+    if ((pArray->pBuf = cauBufGet(pCauDesc, pArray->bufSize)) == NULL) {
+	(void)printf("malloc error\n");
+	return ERROR;
+    }
+    pArray->pData = pArray->pBuf;
+    while (1) {
+	while (pBeg < pEnd && (isspace((unsigned char)*pBeg) || *pBeg == ','))
+	    pBeg++;
+	if (pBeg >= pEnd)
+	    break;
+	for (len=0; pBeg+len < pEnd; len++) {
+	    if (isspace((unsigned char)pBeg[len]) || pBeg[len] == ',')
+		break;
+	}
+	if (len >= CAU_ARRAY_NUM_DIM) {
+	    (void)printf("%.20s... isn't a number\n", pBeg);
+	    goto parseError;
+	}
+	(void)memcpy(num, pBeg, len);
+	num[len] = '\0';
+	pBeg += len;
+	if (n >= pChan->elCount) {
+	    (void)printf("too many elements for %s (it has %lu)\n",
+					pChan->name, pChan->elCount);
+	    goto parseError;
+	}
+	dbl = strtod(num, &pNumEnd);
+	if (pNumEnd == num || *pNumEnd != '\0') {
+	    (void)printf("%s isn't a number\n", num);
+	    goto parseError;
+	}
+	if (dbl < min || dbl > max) {
+	    (void)printf("%s is out of range for %s\n", num, pChan->name);
+	    goto parseError;
+	}
+	if (pChan->dbfType != DBF_FLOAT && pChan->dbfType != DBF_DOUBLE &&
+							dbl != floor(dbl)) {
+	    (void)printf("%s isn't a whole number, as %s needs\n",
+							num, pChan->name);
+	    goto parseError;
+	}
+	if (lo < hi && (dbl < lo || dbl > hi)) {
+	    (void)printf("%s is outside the control limits (%g to %g) for %s\n",
+						num, lo, hi, pChan->name);
+	    goto parseError;
+	}
+	if (pChan->dbfType == DBF_CHAR)
+	    ((dbr_char_t *)pArray->pBuf)[n] = (dbr_char_t)(int)dbl;
+	else if (pChan->dbfType == DBF_SHORT)
+	    ((dbr_short_t *)pArray->pBuf)[n] = (dbr_short_t)dbl;
+	else if (pChan->dbfType == DBF_ENUM)
+	    ((dbr_enum_t *)pArray->pBuf)[n] = (dbr_enum_t)dbl;
+	else if (pChan->dbfType == DBF_LONG)
+	    ((dbr_long_t *)pArray->pBuf)[n] = (dbr_long_t)dbl;
+	else if (pChan->dbfType == DBF_FLOAT)
+	    ((dbr_float_t *)pArray->pBuf)[n] = (dbr_float_t)dbl;
+	else
+	    ((dbr_double_t *)pArray->pBuf)[n] = dbl;
+	n++;
+    }
+    if (n == 0) {
+	(void)printf("no elements in array value for %s\n", pChan->name);
+	goto parseError;
+    }
+    pArray->count = n;
+    return OK;
+parseError:
+    cauBufPut(pCauDesc, pArray->pBuf, pArray->bufSize);
+    pArray->pBuf = NULL;
+    pArray->pData = NULL;
+    return ERROR;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauArrayRelease - free an array value
+*
+* DESCRIPTION
+*	Frees the buffer and unmaps (or frees) the file contents, if the
+*	array has them.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauArrayRelease(pCauDesc, pArray)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_ARRAY *pArray;	/* IO array */
+{
+    if (pArray->pBuf != NULL) {
+	cauBufPut(pCauDesc, pArray->pBuf, pArray->bufSize);
+	pArray->pBuf = NULL;
+    }
+    if (pArray->pFile != NULL) {
+#ifdef CAU_MMAP_ARRAY
+	if (pArray->fileMapped)
+	    (void)munmap((void *)pArray->pFile, pArray->fileSize);
+	else
+#endif
+	    free(pArray->pFile);
+	pArray->pFile = NULL;
+    }
+    pArray->pData = NULL;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauBufGet - get a value buffer
+*
+* DESCRIPTION
+*	Gets a buffer of at least nBytes bytes from the smallest buffer
+*	pool which is big enough.  If nBytes is too big for any of the
+*	pools, the buffer is obtained with malloc.  The caller must keep
+*	nBytes, to give back to cauBufPut.
+*
+* RETURNS
+*	pointer to buffer, or
+*	NULL
+*
+*-*/
+static void *
+cauBufGet(pCauDesc, nBytes)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+size_t	nBytes;		/* I size of buffer, in bytes */
+{
+    void	*pBuf;
+    int		i;
+    size_t	classSize=CAU_BUF_MIN;
+
+    for (i=0; i<CAU_BUF_CLASS_DIM; i++, classSize*=2) {
+	if (nBytes <= classSize)
+	    return cauPoolGet(&pCauDesc->bufPool[i]);
+    }
+    if ((pBuf = malloc(nBytes)) != NULL) {
+	pCauDesc->nBufLarge++;
+	pCauDesc->nBufLargeGet++;
+    }
+    return pBuf;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauBufPut - give back a value buffer
+*
+* DESCRIPTION
+*	Gives a buffer obtained from cauBufGet back to its pool (or frees
+*	it, if it was too big for the pools).  nBytes must be the same
+*	as was given to cauBufGet.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauBufPut(pCauDesc, pBuf, nBytes)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+void	*pBuf;		/* I pointer to buffer, or NULL */
+size_t	nBytes;		/* I size of buffer, in bytes */
+{
+    int		i;
+    size_t	classSize=CAU_BUF_MIN;
+
+    if (pBuf == NULL)
+	return;
+    for (i=0; i<CAU_BUF_CLASS_DIM; i++, classSize*=2) {
+	if (nBytes <= classSize) {
+	    cauPoolPut(&pCauDesc->bufPool[i], pBuf);
+	    return;
+	}
+    }
+    free(pBuf);
+    pCauDesc->nBufLarge--;
+}
+
+#ifdef CAU_MMAP_CACHE
+/*+/subr**********************************************************************
+* NAME	cauCacheClose - close the metadata cache
+*
+* DESCRIPTION
+*	Unmaps and closes the cache file.  The system writes back the
+*	changes which have been made to the mapped entries.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauCacheClose(pCache)
+CAU_CACHE *pCache;	/* IO pointer to cache */
+{
+    if (pCache->pHdr != NULL)
+	(void)munmap((void *)pCache->pHdr, pCache->mapSize);
+    if (pCache->fd >= 0)
+	(void)close(pCache->fd);
+    if (pCache->pHash != NULL)
+	free((char *)pCache->pHash);
+    pCache->fd = -1;
+    pCache->pHdr = NULL;
+    pCache->pEntry = NULL;
+    pCache->mapSize = 0;
+    pCache->dim = 0;
+    pCache->pHash = NULL;
+    pCache->hashDim = 0;
+    pCache->nHit = pCache->nMiss = pCache->nStale = pCache->nChanged = 0;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauCacheFind - find a channel's entry in the metadata cache
+*
+* DESCRIPTION
+*	Looks up a channel name in the cache's hash table.  As for the
+*	channel hash table, a trailing .VAL on the name is ignored.
+*
+* RETURNS
+*	CAU_CACHE_ENTRY * for the entry, if found, or
+*	NULL
+*
+*-*/
+static CAU_CACHE_ENTRY *
+cauCacheFind(pCache, name)
+CAU_CACHE *pCache;	/* I pointer to cache */
+char	*name;		/* I channel name */
+{
+    CAU_CACHE_ENTRY *pEntry;	/* pointer to entry */
+    int		len;		/* length of name, without .VAL */
+    long	mask;		/* mask for hash table index */
+    long	ix;		/* hash table index */
+
+    if (pCache->pHash == NULL)
+	return NULL;
+    len = cauNameLen(name);
+    mask = pCache->hashDim - 1;
+    for (ix=cauNameHash(name, len)&mask; pCache->pHash[ix]!=0;
+							ix=(ix+1)&mask) {
+	pEntry = &pCache->pEntry[pCache->pHash[ix] - 1];
+	if (cauNameLen(pEntry->name) == len &&
+				strncmp(pEntry->name, name, len) == 0)
+	    return pEntry;
+    }
+    return NULL;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauCacheGet - get a channel's graphics info from the cache
+*
+* DESCRIPTION
+*	If the cache has an entry for the channel, with the same native
+*	type and count as the channel has now, the cached DBR_CTRL_xxx
+*	information is copied into the channel's graphics buffer.
+*
+* RETURNS
+*	OK, or
+*	ERROR if the cache has no usable entry for the channel
+*
+*-*/
+static long
+cauCacheGet(pCache, pChan)
+CAU_CACHE *pCache;	/* IO pointer to cache */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+{
+    CAU_CACHE_ENTRY *pEntry;	/* pointer to entry */
+
+    if ((pEntry = cauCacheFind(pCache, pChan->name)) == NULL) {
+	pCache->nMiss++;
+	return ERROR;
+    }
+    if (pEntry->dbfType != pChan->dbfType ||
+				pEntry->elCount != pChan->elCount) {
+	pCache->nStale++;
+	return ERROR;
+    }
+    (void)memcpy((char *)pChan->pGRBuf, (char *)&pEntry->gr,
+					sizeof(union db_access_val));
+    pCache->nHit++;
+    return OK;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauCacheIndex - add an entry to the cache's hash table
+*
+* DESCRIPTION
+*	Adds entry ix to the hash table.  Entries 0 to ix-1 must already
+*	be in the table.  If the table is getting full, it is replaced
+*	with a bigger one.
+*
+* RETURNS
+*	OK, or
+*	ERROR if the table can't be expanded
+*
+*-*/
+static long
+cauCacheIndex(pCache, ix)
+CAU_CACHE *pCache;	/* IO pointer to cache */
+long	ix;		/* I index of entry to add */
+{
+    long	*pNew;		/* pointer to new hash table */
+    long	dim;		/* dimension of new hash table */
+    long	mask;		/* mask for hash table index */
+    long	h;		/* hash table index */
+    long	i;
+    char	*name;		/* name of entry */
+
+    if (2 * (ix + 1) > pCache->hashDim) {
+	dim = pCache->hashDim > 0 ? 2 * pCache->hashDim : CAU_HASH_DIM;
+	while (2 * (ix + 1) > dim)
+	    dim *= 2;
+	if ((pNew = (long *)calloc(dim, sizeof(long))) == NULL) {
+	    (void)printf("malloc error\n");
+	    return ERROR;
+	}
+	if (pCache->pHash != NULL)
+	    free((char *)pCache->pHash);
+	pCache->pHash = pNew;
+	pCache->hashDim = dim;
+	i = 0;
+    }
+    else
+	i = ix;
+    mask = pCache->hashDim - 1;
+    for ( ; i<=ix; i++) {
+	name = pCache->pEntry[i].name;
+	for (h=cauNameHash(name, cauNameLen(name))&mask;
+				pCache->pHash[h]!=0; h=(h+1)&mask)
+	    ;
+	pCache->pHash[h] = i + 1;
+    }
+    return OK;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauCacheMap - map the cache file, with room for dim entries
+*
+* DESCRIPTION
+*	Extends the file if it is shorter than dim entries need, and maps
+*	it (again) into memory.
+*
+* RETURNS
+*	OK, or
+*	ERROR
+*
+*-*/
+static long
+cauCacheMap(pCache, dim)
+CAU_CACHE *pCache;	/* IO pointer to cache */
+long	dim;		/* I number of entries needed */
+{
+    size_t	size;		/* size of file, in bytes */
+    void	*pMap;		/* pointer to mapping */
+
+    size = sizeof(CAU_CACHE_HDR) + dim * sizeof(CAU_CACHE_ENTRY);
+    if (pCache->pHdr != NULL) {
+	(void)munmap((void *)pCache->pHdr, pCache->mapSize);
+	pCache->pHdr = NULL;
+	pCache->pEntry = NULL;
+    }
+    if (size > pCache->mapSize && ftruncate(pCache->fd, (off_t)size) != 0) {
+	(void)printf("can't extend cache file %s\n", pCache->path);
+	return ERROR;
+    }
+    pMap = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, pCache->fd, 0);
+    if (pMap == MAP_FAILED) {
+	(void)printf("can't map cache file %s\n", pCache->path);
+	return ERROR;
+    }
+    pCache->pHdr = (CAU_CACHE_HDR *)pMap;
+    pCache->pEntry = (CAU_CACHE_ENTRY *)(pCache->pHdr + 1);
+    pCache->mapSize = size;
+    pCache->dim = dim;
+    return OK;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauCacheOpen - open the metadata cache
+*
+* DESCRIPTION
+*	Opens, and maps, the cache file, creating it if it doesn't exist,
+*	and builds the hash table for its entries.
+*
+* RETURNS
+*	OK, or
+*	ERROR
+*
+*-*/
+static long
+cauCacheOpen(pCache, path)
+CAU_CACHE *pCache;	/* IO pointer to cache */
+char	*path;		/* I path of cache file */
+{
+    struct stat	fileStat;	/* status of cache file */
+    long	dim;		/* number of entries file has room for */
+    long	i;
+
+    if (strlen(path) >= sizeof(pCache->path)) {
+	(void)printf("path too long: %s\n", path);
+	return ERROR;
+    }
+    strcpy(pCache->path, path);
+    if ((pCache->fd = open(path, O_RDWR|O_CREAT, 0666)) < 0)
+	return ERROR;
+    if (fstat(pCache->fd, &fileStat) != 0)
+	goto openError;
+    pCache->mapSize = fileStat.st_size;
+    if (fileStat.st_size == 0) {
+	if (cauCacheMap(pCache, (long)CAU_CACHE_GROW) != OK)
+	    goto openError;
+	pCache->pHdr->magic = CAU_CACHE_MAGIC;
+	pCache->pHdr->version = CAU_CACHE_VERSION;
+	pCache->pHdr->entrySize = sizeof(CAU_CACHE_ENTRY);
+	pCache->pHdr->nEntry = 0;
+	return OK;
+    }
+    if (fileStat.st_size < sizeof(CAU_CACHE_HDR)) {
+	(void)printf("%s isn't a cau cache file\n", path);
+	goto openError;
+    }
+    dim = (fileStat.st_size - sizeof(CAU_CACHE_HDR)) / sizeof(CAU_CACHE_ENTRY);
+    if (cauCacheMap(pCache, dim) != OK)
+	goto openError;
+    if (pCache->pHdr->magic != CAU_CACHE_MAGIC ||
+		pCache->pHdr->version != CAU_CACHE_VERSION ||
+		pCache->pHdr->entrySize != sizeof(CAU_CACHE_ENTRY) ||
+		pCache->pHdr->nEntry < 0 || pCache->pHdr->nEntry > dim) {
+	(void)printf("%s isn't a cau cache file for this version\n", path);
+	goto openError;
+    }
+    for (i=0; i<pCache->pHdr->nEntry; i++) {
+	pCache->pEntry[i].name[db_name_dim-1] = '\0';
+	if (cauCacheIndex(pCache, i) != OK)
+	    goto openError;
+    }
+    return OK;
+
+openError:
+    cauCacheClose(pCache);
+    return ERROR;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauCachePut - store a channel's graphics info in the cache
+*
+* DESCRIPTION
+*	Brings the channel's cache entry up to date with the channel's
+*	native type, count, and graphics buffer, adding an entry (and
+*	growing the file) if the channel isn't in the cache yet.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauCachePut(pCache, pChan)
+CAU_CACHE *pCache;	/* IO pointer to cache */
+CAU_CHAN *pChan;	/* I pointer to channel descriptor */
+{
+    CAU_CACHE_ENTRY *pEntry;	/* pointer to entry */
+    size_t	skip;		/* bytes of status and severity */
+
+    if ((pEntry = cauCacheFind(pCache, pChan->name)) == NULL) {
+	if (pCache->pHdr->nEntry >= pCache->dim &&
+		cauCacheMap(pCache, pCache->dim + CAU_CACHE_GROW) != OK) {
+	    cauCacheClose(pCache);
+	    return;
+	}
+	pEntry = &pCache->pEntry[pCache->pHdr->nEntry];
+	(void)memset((char *)pEntry, 0, sizeof(CAU_CACHE_ENTRY));
+	strcpy(pEntry->name, pChan->name);
+	if (cauCacheIndex(pCache, pCache->pHdr->nEntry) != OK)
+	    return;
+	pCache->pHdr->nEntry++;
+    }
+    else if (pEntry->dbfType == pChan->dbfType &&
+				pEntry->elCount == pChan->elCount) {
+	skip = 2 * sizeof(dbr_short_t);
+	if (memcmp((char *)&pEntry->gr + skip, (char *)pChan->pGRBuf + skip,
+				sizeof(union db_access_val) - skip) == 0)
+	    return;
+	pCache->nChanged++;
+    }
+    pEntry->dbfType = pChan->dbfType;
+    pEntry->elCount = pChan->elCount;
+    (void)memcpy((char *)&pEntry->gr, (char *)pChan->pGRBuf,
+					sizeof(union db_access_val));
+}
+#endif
+
+/*+/subr**********************************************************************
+* NAME	cauChanAdd - add a channel to a cau descriptor
+*
+* DESCRIPTION
+*	This routine adds a channel to a cau descriptor and waits (for
+*	up to 1 second) for it to connect.  When complete, the channel
+*	descriptor will contain the graphics information for the channel.
+*
+*	A channel which has already been added (with or without .VAL)
+*	isn't added again.  If the channel is still waiting to connect
+*	(from an earlier command), NULL is returned without waiting.
+*
+*	Commands which name several channels call cauChanAddList first,
+*	so that all the channels are searched for at once.
+*
+* RETURNS
+*	pointer to CAU_CHAN structure, or
+*	NULL
+*
+*-*/
+static CAU_CHAN *
+cauChanAdd(pCxCmd, pCauDesc, chanName)
+CX_CMD	*pCxCmd;	/* I pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+char	*chanName;	/* I channel name (.VAL assumed of field omitted) */
+{
+    CAU_CHAN	*pCauChan;	/* pointer to cau channel descriptor */
+
+    if ((pCauChan = cauChanLookup(pCauDesc, chanName)) != NULL) {
+	if (pCauChan->connState != CAU_CONN_SEARCH)
+	    (void)printf("%s has already been added\n", chanName);
+	return NULL;
+    }
+    pCauDesc->connBatch++;
+    pCauDesc->nConnWait = 0;
+    if ((pCauChan = cauChanAddStart(pCxCmd, pCauDesc, chanName)) == NULL)
+	return NULL;
+    cauChanConnWait(pCauDesc);
+    if (pCauChan->connState == CAU_CONN_SEARCH)
+	return NULL;
+    return pCauChan;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanAddList - add the channels named on a command line
+*
+* DESCRIPTION
+*	Starts a search for each channel named in the present field and
+*	the rest of the command line which hasn't already been added,
+*	and then waits (for up to 1 second, in total) for them to connect
+*	and for their graphics information to arrive.  Channels which
+*	don't connect in time are left on the connect list; they are
+*	moved to the channel list whenever they do connect.
+*
+*	If the command will need graphics information for the channels
+*	(as indicated by grNeed), it is then requested for all the named
+*	channels which need it, again with a single wait.
+*
+*	The command line itself isn't changed, so that the command can
+*	then process the names in the usual way.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauChanAddList(pCxCmd, pCauDesc, grNeed)
+CX_CMD	*pCxCmd;	/* I pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+int	grNeed;		/* I CAU_GR_NEED_xxx */
+{
+    char	names[sizeof(pCxCmd->line)];/* copy of rest of line */
+    char	*pNames;	/* pointer into names */
+    char	*pName;		/* pointer to a name */
+    char	delim;
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    CAU_PATTERN	pat;		/* compiled pattern */
+    int		isPat;		/* 1 says name is a pattern */
+
+    pCauDesc->connBatch++;
+    pCauDesc->nConnWait = 0;
+    if (!cauPatternCompile(&pat, pCxCmd->pField) &&
+			cauChanLookup(pCauDesc, pCxCmd->pField) == NULL)
+	(void)cauChanAddStart(pCxCmd, pCauDesc, pCxCmd->pField);
+    (void)strcpy(names, pCxCmd->pLine);
+    pNames = names;
+    while (nextChanNameField(&pNames, &pName, &delim) > 1) {
+	if (!cauPatternCompile(&pat, pName) &&
+			cauChanLookup(pCauDesc, pName) == NULL)
+	    (void)cauChanAddStart(pCxCmd, pCauDesc, pName);
+    }
+    if (pCauDesc->nConnWait > 0)
+	cauChanConnWait(pCauDesc);
+    if (grNeed == CAU_GR_NEED_NONE)
+	return;
+
+    pCauDesc->grBatch++;
+    pCauDesc->nGRWait = 0;
+    (void)strcpy(names, pCxCmd->pLine);
+    pNames = names;
+    pName = pCxCmd->pField;
+    do {
+	if ((isPat = cauPatternCompile(&pat, pName)) != 0)
+	    pChan = cauChanMatchFirst(pCauDesc, &pat);
+	else
+	    pChan = cauChanFind(pCauDesc, pName);
+	while (pChan != NULL) {
+	    if (cauChanGRNeeded(pChan, grNeed))
+		cauChanGRRequest(pCauDesc, pChan);
+	    pChan = isPat ? cauChanMatchNext(pCauDesc, &pat) : NULL;
+	}
+    } while (nextChanNameField(&pNames, &pName, &delim) > 1);
+    if (pCauDesc->nGRWait > 0)
+	cauChanGRWait(pCauDesc);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanAddStart - start adding a channel
+*
+* DESCRIPTION
+*	Creates a channel descriptor and starts the search for the
+*	channel, with cauChanConn as the connection handler.  The channel
+*	is put on the connect list, and is counted as part of the present
+*	connect batch.  The caller must already have made sure that the
+*	channel hasn't been added.
+*
+* RETURNS
+*	pointer to CAU_CHAN structure, or
+*	NULL
+*
+*-*/
+static CAU_CHAN *
+cauChanAddStart(pCxCmd, pCauDesc, chanName)
+CX_CMD	*pCxCmd;	/* I pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+char	*chanName;	/* I channel name (.VAL assumed of field omitted) */
+{
+    long	stat;           /* status return from calls */
+    CAU_CHAN	*pCauChan;	/* pointer to cau channel descriptor */
+
+    assert(pCauDesc != NULL);
+    assert(chanName != NULL);
+    assert(strlen(chanName) > 0);
+
+    if (strlen(chanName) >= db_name_dim) {
+	(void)printf("name too long: %s\n", chanName);
+	return NULL;
+    }
+    if ((pCauChan = (CAU_CHAN *)cauPoolGet(&pCauDesc->chanPool)) == NULL) {
+	(void)printf("malloc error\n");
+	return NULL;
+    }
+    pCauChan->pCxCmd = pCxCmd->pCxCmdRoot;
+    pCauChan->pCh = NULL;
+    pCauChan->pEv = NULL;
+    pCauChan->pBuf = NULL;
+    pCauChan->bufSize = 0;
+    pCauChan->pGRBuf = NULL;
+    pCauChan->pEnumHash = NULL;
+    pCauChan->pSigGen = NULL;
+    pCauChan->deadTime.heapIx = -1;
+    pCauChan->deadTime.pArg = pCauChan;
+    pCauChan->interval = 0.;
+    pCauChan->lastMonErr = 0;
+#ifdef CAU_SHARDS
+    pCauChan->pShard = NULL;
+    pCauChan->pBufBack = NULL;
+    pCauChan->bufBackSize = 0;
+    pCauChan->bufBackNeed = 0;
+    pCauChan->bufBackBusy = 0;
+    pCauChan->nShardDrop = 0;
+    pCauChan->pShardCh = NULL;
+    pCauChan->pShardEv = NULL;
+    pCauChan->pShardPrev = pCauChan->pShardNext = NULL;
+#endif
+    strcpy(pCauChan->name, chanName);
+    pCauChan->nameLen = cauNameLen(chanName);
+    pCauChan->nameHash = cauNameHash(chanName, pCauChan->nameLen);
+    pCauChan->units = NULL;
+    pCauChan->connState = CAU_CONN_SEARCH;
+    pCauChan->nDisconn = 0;
+    pCauChan->pHost = NULL;
+    pCauChan->pRearmNext = NULL;
+    pCauChan->pPoll = NULL;
+    pCauChan->pollPend = 0;
+    pCauChan->pollSent = pCauChan->pollRecv = 0;
+    pCauChan->pPing = NULL;
+    pCauChan->putHeld.heapIx = -1;
+    pCauChan->putHeld.pArg = pCauChan;
+    pCauChan->putNext.secPastEpoch = 0;
+    pCauChan->putNext.nsec = 0;
+    pCauChan->pPutValue = NULL;
+    pCauChan->pPutHost = NULL;
+    pCauChan->nPutCoalesced = 0;
+    pCauChan->connBatch = pCauDesc->connBatch;
+    pCauChan->grState = CAU_GR_NONE;
+    pCauChan->grCached = 0;
+    pCauChan->grBatch = 0;
+
+#ifdef vxWorks
+    CauLock;
+#endif
+    stat = cauChanHashAdd(pCauDesc, pCauChan);
+    if (stat == OK) {
+	DoubleListAppend(pCauChan,
+			pCauDesc->pChanConnHead, pCauDesc->pChanConnTail);
+    }
+#ifdef vxWorks
+    CauUnlock;
+#endif
+    if (stat != OK) {
+	cauPoolPut(&pCauDesc->chanPool, pCauChan);
+	return NULL;
+    }
+
+    pCauDesc->nConnWait++;
+    cauCaDebugName("prior to ca_search_and_connect", chanName, 0);
+    stat = ca_search_and_connect(chanName, &pCauChan->pCh,
+						cauChanConn, pCauChan);
+    cauCaDebugStat("back from ca_search_and_connect", stat, 0);
+    if (stat != ECA_NORMAL) {
+	(void)printf("error on search for %s\n", chanName);
+	pCauChan->pCh = NULL;
+	(void)cauChanDel(pCxCmd, pCauDesc, pCauChan);
+	pCauDesc->nConnWait--;
+	return NULL;
+    }
+
+    return pCauChan;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanBufNeed - make sure a channel's buffer is big enough
+*
+* DESCRIPTION
+*	If the channel's buffer is smaller than nBytes, a bigger one is
+*	obtained and the old contents (in particular, the status and
+*	time stamp used by interval checking) are copied into it.
+*	Buffers are only grown as big as the values which are actually
+*	requested or received, rather than always to the channel's
+*	native count.
+*
+*	Buffers come from the cau descriptor's pools, so this routine
+*	must be called from the cau task, not from a shard.  If the
+*	channel is monitored by a shard, the caller must hold the
+*	shard's lock.
+*
+* RETURNS
+*	OK, or
+*	ERROR if a bigger buffer can't be obtained
+*
+*-*/
+static long
+cauChanBufNeed(pCauDesc, pChan, nBytes)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+size_t	nBytes;		/* I size needed, in bytes */
+{
+    union db_access_val *pBuf;	/* pointer to new buffer */
+
+    if (pChan->pBuf != NULL && nBytes <= pChan->bufSize)
+	return OK;
+    if ((pBuf = (union db_access_val *)cauBufGet(pCauDesc, nBytes)) == NULL) {
+	(void)printf("malloc error\n");
+	return ERROR;
+    }
+    if (pChan->pBuf != NULL) {
+	(void)memcpy((char *)pBuf, (char *)pChan->pBuf, pChan->bufSize);
+	cauBufPut(pCauDesc, pChan->pBuf, pChan->bufSize);
+    }
+    else
+	pBuf->tstrval.status = -2;
+    pChan->pBuf = pBuf;
+    pChan->bufSize = nBytes;
+    return OK;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanConn - connection handler for channels
+*
+* DESCRIPTION
+*	When a channel on the connect list connects for the first time,
+*	its type and count are obtained and its value buffer is created.
+*	The channel is then moved to the channel list.  (Its graphics
+*	information is left until something needs it.)
+*
+*	After that, the channel goes from CAU_CONN_OK to CAU_CONN_DOWN
+*	when its connection is lost, and back when it is regained:
+*	o  cauChanConnDown marks the value as not received, drops a put
+*	   held by putRate, ends a ping of the channel, and prints
+*	   "<name> disconnected at <time> (local)"
+*	o  cauChanConnUp prints "<name> reconnected at <time> (local)
+*	   after <n> sec", marks graphics information to be fetched
+*	   again, and, if the native type or count has changed, puts the
+*	   channel on its host's re-arm list (see cauChanRearm)
+*
+*	Monitors are kept by Channel Access across the disconnect and
+*	resume by themselves.  Polls skip the channel while it is down;
+*	a poll get outstanding when the connection is lost is answered
+*	with an error by Channel Access.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauChanConn(arg)
+struct connection_handler_args arg;
+{
+    CAU_CHAN	*pCauChan;	/* pointer to cau channel descriptor */
+    CAU_DESC	*pCauDesc=pglCauDesc;
+
+    pCauChan = (CAU_CHAN *)ca_puser(arg.chid);
+    if (arg.op != CA_OP_CONN_UP) {
+	if (pCauChan->connState == CAU_CONN_OK)
+	    cauChanConnDown(pCauDesc, pCauChan);
+	return;
+    }
+    if (pCauChan->connState == CAU_CONN_DOWN) {
+	cauChanConnUp(pCauDesc, pCauChan);
+	return;
+    }
+    if (pCauChan->connState != CAU_CONN_SEARCH)
+	return;
+
+    pCauChan->dbfType = ca_field_type(pCauChan->pCh);
+    pCauChan->dbrType = dbf_type_to_DBR(ca_field_type(pCauChan->pCh));
+    pCauChan->elCount = ca_element_count(pCauChan->pCh);
+    pCauChan->reqCount = pCauChan->elCount;
+    pCauChan->nEl = 1;
+
+    if (cauChanBufNeed(pCauDesc, pCauChan,
+		dbr_size_n(dbf_type_to_DBR_TIME(pCauChan->dbfType), 1)) != OK) {
+	if (pCauChan->connBatch == pCauDesc->connBatch)
+	    pCauDesc->nConnWait--;
+	pCauChan->connBatch = 0;
+	return;
+    }
+    pCauChan->pBuf->tstrval.status = -2;
+
+#ifdef vxWorks
+    CauLock;
+#endif
+    DoubleListRemove(pCauChan,
+			pCauDesc->pChanConnHead, pCauDesc->pChanConnTail);
+    DoubleListAppend(pCauChan, pCauDesc->pChanHead, pCauDesc->pChanTail);
+    pCauDesc->chanSortValid = 0;
+#ifdef vxWorks
+    CauUnlock;
+#endif
+    pCauChan->connState = CAU_CONN_OK;
+    (void)epicsTimeGetCurrent(&pCauChan->connTime);
+    if (pCauChan->connBatch == pCauDesc->connBatch)
+	pCauDesc->nConnWait--;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanConnDown - handle loss of a channel's connection
+*
+* DESCRIPTION
+*	Called from cauChanConn.  Marks the channel as disconnected, marks
+*	its value as not received (so the interval test starts over when
+*	values resume), and prints the time of the disconnect.  A put
+*	which is being held by putRate is dropped; its buffer is kept
+*	for the channel's next held put.  If the channel is being pinged,
+*	the ping is ended, since its puts can't be sent.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauChanConnDown(pCauDesc, pChan)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+{
+    char	nowText[28];
+
+    pChan->connState = CAU_CONN_DOWN;
+    pChan->nDisconn++;
+    pChan->pPutHost = NULL;		/* may come back on another host */
+    if (pChan->putHeld.heapIx >= 0) {
+	cauTmrCancel(&pCauDesc->putHeap, &pChan->putHeld);
+	pCauDesc->nPutDropped++;
+    }
+    (void)epicsTimeGetCurrent(&pChan->connTime);
+    CauChanLock(pChan);
+    pChan->pBuf->tstrval.status = -2;
+    CauChanUnlock(pChan);
+    (void)epicsTimeToStrftime(nowText, 28, "%m-%d-%y %H:%M:%S.%09f",
+							&pChan->connTime);
+    (void)fprintf(pChan->pCxCmd->dataOut, "%s disconnected at %s (local)\n",
+							pChan->name, nowText);
+    if (pChan->pPing != NULL)
+	cauPingDone(pCauDesc);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanConnUp - handle reconnection of a channel
+*
+* DESCRIPTION
+*	Called from cauChanConn when a channel which had lost its
+*	connection is connected again.  The time of the reconnect, and
+*	how long the channel was disconnected, are printed.  Graphics
+*	information will be fetched again when it is next needed.  If
+*	the native type or count has changed, the channel is put on its
+*	host's re-arm list.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauChanConnUp(pCauDesc, pChan)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+{
+    TS_STAMP	now;		/* present time */
+    char	nowText[28];
+    CAU_HOST	*pHost;		/* pointer to channel's host */
+
+    (void)epicsTimeGetCurrent(&now);
+    (void)epicsTimeToStrftime(nowText, 28, "%m-%d-%y %H:%M:%S.%09f", &now);
+    (void)fprintf(pChan->pCxCmd->dataOut,
+		"%s reconnected at %s (local) after %.3f sec\n", pChan->name,
+		nowText, epicsTimeDiffInSeconds(&now, &pChan->connTime));
+    pChan->connTime = now;
+    pChan->connState = CAU_CONN_OK;
+    if (pChan->grState == CAU_GR_OK)
+	pChan->grState = CAU_GR_NONE;
+
+    if (ca_field_type(pChan->pCh) == pChan->dbfType &&
+		ca_element_count(pChan->pCh) == pChan->elCount)
+	return;
+    if (pChan->pHost != NULL)
+	return;				/* already waiting for re-arm */
+    if ((pHost = cauHostFind(pCauDesc, ca_host_name(pChan->pCh))) == NULL) {
+	(void)printf("can't re-arm %s\n", pChan->name);
+	return;
+    }
+    pChan->pHost = pHost;
+    pChan->pRearmNext = pHost->pRearmHead;
+    pHost->pRearmHead = pChan;
+    if (pHost->retry.heapIx < 0) {
+	pHost->retry.time = now;
+	epicsTimeAddSeconds(&pHost->retry.time, pHost->backoff);
+	(void)cauTmrArm(&pCauDesc->rearmHeap, &pHost->retry);
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanConnWait - wait for the present connect batch
+*
+* DESCRIPTION
+*	Flushes the searches for the present connect batch and then
+*	handles Channel Access events until all the channels in the
+*	batch have connected, or until 1 second has passed.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauChanConnWait(pCauDesc)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    long	stat;           /* status return from calls */
+    TS_STAMP	deadline;	/* time at which to quit waiting */
+    TS_STAMP	now;		/* present time */
+
+    (void)epicsTimeGetCurrent(&deadline);
+    epicsTimeAddSeconds(&deadline, 1.);
+    cauCaDebug("prior to ca_flush_io", 0);
+    stat = ca_flush_io();
+    cauCaDebugStat("back from ca_flush_io", stat, 0);
+    while (pCauDesc->nConnWait > 0) {
+	(void)epicsTimeGetCurrent(&now);
+	if (epicsTimeGreaterThanEqual(&now, &deadline))
+	    break;
+	(void)ca_pend_event(CAU_CONN_POLL);
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanDel - delete a channel from a cau descriptor
+*
+* DESCRIPTION
+*	This routine deletes a channel from a cau descriptor.  The
+*	channel may be on either the channel list or the connect list.
+*
+* RETURNS
+*	OK
+*
+*-*/
+static long
+cauChanDel(pCxCmd, pCauDesc, pCauChan)
+CX_CMD	*pCxCmd;	/* I pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pCauChan;	/* IO pointer to cau channel descriptor */
+{
+    long	stat;           /* status return from calls */
+
+    assert(pCauDesc != NULL);
+    assert(pCauChan != NULL);
+
+#ifdef vxWorks
+    CauLock;
+#endif
+    if (pCauChan->connState == CAU_CONN_SEARCH) {
+	DoubleListRemove(pCauChan,
+			pCauDesc->pChanConnHead, pCauDesc->pChanConnTail);
+    }
+    else
+	DoubleListRemove(pCauChan, pCauDesc->pChanHead, pCauDesc->pChanTail);
+    cauChanHashDel(pCauDesc, pCauChan);
+    pCauDesc->chanSortValid = 0;
+#ifdef vxWorks
+    CauUnlock;
+#endif
+    if (pCauChan->grState == CAU_GR_PEND &&
+				pCauChan->grBatch == pCauDesc->grBatch)
+	pCauDesc->nGRWait--;
+    cauSigGenStop(pCauDesc, pCauChan);
+    if (pCauChan->pPing != NULL)
+	cauPingDone(pCauDesc);
+    cauMonitorClear(pCauDesc, pCauChan);
+    cauHostRearmDel(pCauChan);
+    cauGetChanDel(pCauDesc, pCauChan);
+    cauPollChanDel(pCauDesc, pCauChan);
+    cauPutChanDel(pCauDesc, pCauChan);
+
+    if (pCauChan->pCh != NULL) {
+	cauCaDebugName("prior to cau_clear_channel", pCauChan->name, 0);
+	stat = ca_clear_channel(pCauChan->pCh);
+	cauCaDebugStat("back from ca_clear_channel", stat, 0);
+	if (stat != ECA_NORMAL) {
+	    (void)printf("error closing pCh for: %s\n",
+					    pCauChan->name);
+	}
+    }
+    cauBufPut(pCauDesc, pCauChan->pBuf, pCauChan->bufSize);
+    cauBufPut(pCauDesc, pCauChan->pGRBuf, sizeof(union db_access_val));
+    cauBufPut(pCauDesc, pCauChan->pEnumHash, CAU_ENUM_HASH_DIM);
+    cauPoolPut(&pCauDesc->chanPool, pCauChan);
+
+    return OK;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanEnumHash - build the hash of an ENUM channel's state strings
+*
+* DESCRIPTION
+*	The hash is an open addressing table of CAU_ENUM_HASH_DIM slots,
+*	each holding a state index + 1 (or 0 for an empty slot).  It is
+*	built when the graphics information arrives, so that put can find
+*	a state string without comparing it to each of the strings.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauChanEnumHash(pCauDesc, pChan)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+{
+    struct dbr_gr_enum *pEnm;	/* pointer to enum information */
+    int		ix;		/* hash table index */
+    int		i;
+
+    if (pChan->dbfType != DBF_ENUM)
+	return;
+    if (pChan->pEnumHash == NULL) {
+	pChan->pEnumHash = (unsigned char *)cauBufGet(pCauDesc,
+							CAU_ENUM_HASH_DIM);
+	if (pChan->pEnumHash == NULL)
+	    return;
+    }
+    (void)memset((char *)pChan->pEnumHash, 0, CAU_ENUM_HASH_DIM);
+    pEnm = &pChan->pGRBuf->genmval;
+    for (i=0; i<pEnm->no_str && i<MAX_ENUM_STATES; i++) {
+	ix = cauNameHash(pEnm->strs[i], (int)strlen(pEnm->strs[i])) &
+						(CAU_ENUM_HASH_DIM - 1);
+	while (pChan->pEnumHash[ix] != 0)
+	    ix = (ix + 1) & (CAU_ENUM_HASH_DIM - 1);
+	pChan->pEnumHash[ix] = i + 1;
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanEnumLookup - find an ENUM channel's state string
+*
+* RETURNS
+*	index of state string, or
+*	-1 if the string isn't one of the channel's states
+*
+*-*/
+static int
+cauChanEnumLookup(pChan, text)
+CAU_CHAN *pChan;	/* I pointer to channel descriptor */
+char	*text;		/* I state string to find */
+{
+    struct dbr_gr_enum *pEnm;	/* pointer to enum information */
+    int		ix;		/* hash table index */
+    int		i;
+
+    if (pChan->pEnumHash == NULL || CauChanGR(pChan) == NULL)
+	return -1;
+    pEnm = &pChan->pGRBuf->genmval;
+    ix = cauNameHash(text, (int)strlen(text)) & (CAU_ENUM_HASH_DIM - 1);
+    while ((i = pChan->pEnumHash[ix]) != 0) {
+	if (strncmp(pEnm->strs[i-1], text, MAX_ENUM_STRING_SIZE) == 0)
+	    return i - 1;
+	ix = (ix + 1) & (CAU_ENUM_HASH_DIM - 1);
+    }
+    return -1;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanFind - find a channel in a cau descriptor
+*
+* DESCRIPTION
+*	This routine finds a channel in a cau descriptor.  Channels
+*	which haven't connected yet aren't found.
+*
+* RETURNS
+*	CAU_CHAN * for channel, if found, or
+*	NULL
+*
+*-*/
+static CAU_CHAN *
+cauChanFind(pCauDesc, chanName)
+CAU_DESC *pCauDesc;	/* I pointer to cau descriptor */
+char	*chanName;	/* I channel name to find in cau */
+{
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+
+    pChan = cauChanLookup(pCauDesc, chanName);
+    if (pChan != NULL && pChan->connState == CAU_CONN_SEARCH)
+	pChan = NULL;
+
+    return pChan;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanGR - receive graphics information for a channel
+*
+* DESCRIPTION
+*	Copies the DBR_CTRL_xxx information into the channel's graphics
+*	buffer and sets the channel's units (and, for ENUM channels,
+*	builds the enum string hash).  If the request failed, the
+*	channel goes back to CAU_GR_NONE, so that the next thing which
+*	needs the information asks for it again.
+*
+*	The shard lock is held while the buffer is changed, since a
+*	shard's monitor callback may be printing the channel's value.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauChanGR(arg)
+struct event_handler_args arg;
+{
+    CAU_CHAN	*pCauChan;	/* pointer to cau channel descriptor */
+
+    pCauChan = (CAU_CHAN *)arg.usr;
+    if (pCauChan->grBatch == pglCauDesc->grBatch)
+	pglCauDesc->nGRWait--;
+    if (arg.status != ECA_NORMAL) {
+	(void)printf("error getting graphics info for %s\n", pCauChan->name);
+	if (!pCauChan->grCached)
+	    pCauChan->grState = CAU_GR_NONE;
+	pCauChan->grCached = 0;
+	return;
+    }
+    CauChanLock(pCauChan);
+    (void)memcpy((char *)pCauChan->pGRBuf, (char *)arg.dbr,
+					dbr_size_n(arg.type, arg.count));
+    cauChanGRUnits(pCauChan);
+    pCauChan->grState = CAU_GR_OK;
+    pCauChan->grCached = 0;
+    CauChanUnlock(pCauChan);
+    cauChanEnumHash(pglCauDesc, pCauChan);
+#ifdef CAU_MMAP_CACHE
+    if (pglCauDesc->cache.fd >= 0)
+	cauCachePut(&pglCauDesc->cache, pCauChan);
+#endif
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanGRAll - get graphics information for all channels
+*
+* DESCRIPTION
+*	Requests graphics information for each channel on the channel
+*	list which needs it (as indicated by grNeed) and doesn't already
+*	have it, and then waits (for up to 1 second, in total) for the
+*	information to arrive.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauChanGRAll(pCauDesc, grNeed)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+int	grNeed;		/* I CAU_GR_NEED_xxx */
+{
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+
+    if (grNeed == CAU_GR_NEED_NONE)
+	return;
+    pCauDesc->grBatch++;
+    pCauDesc->nGRWait = 0;
+    for (pChan=pCauDesc->pChanHead; pChan!=NULL; pChan=pChan->pNext) {
+	if (cauChanGRNeeded(pChan, grNeed))
+	    cauChanGRRequest(pCauDesc, pChan);
+    }
+    if (pCauDesc->nGRWait > 0)
+	cauChanGRWait(pCauDesc);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanGRFetch - get graphics information for a channel
+*
+* DESCRIPTION
+*	If the channel needs graphics information (as indicated by grNeed)
+*	and doesn't have it yet, the information is requested and this
+*	routine waits (for up to 1 second) for it to arrive.
+*
+*	Commands which handle several channels usually get the information
+*	for all of them at once, with cauChanAddList or cauChanGRAll, so
+*	that this routine doesn't need to wait.
+*
+* RETURNS
+*	pointer to the channel's graphics information, or
+*	NULL if it isn't available
+*
+*-*/
+static union db_access_val *
+cauChanGRFetch(pCauDesc, pChan, grNeed)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+int	grNeed;		/* I CAU_GR_NEED_xxx */
+{
+    if (pChan->grState != CAU_GR_OK && cauChanGRNeeded(pChan, grNeed)) {
+	pCauDesc->grBatch++;
+	pCauDesc->nGRWait = 0;
+	cauChanGRRequest(pCauDesc, pChan);
+	if (pCauDesc->nGRWait > 0)
+	    cauChanGRWait(pCauDesc);
+    }
+    return CauChanGR(pChan);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanGRNeeded - check whether a channel needs graphics information
+*
+* DESCRIPTION
+*	For printing values, only FLOAT and DOUBLE channels (for the
+*	precision) and ENUM channels (for the state strings) need the
+*	graphics information.  For units and display limits, all but
+*	STRING channels need it.
+*
+* RETURNS
+*	1 if the channel needs graphics information, or
+*	0
+*
+*-*/
+static int
+cauChanGRNeeded(pChan, grNeed)
+CAU_CHAN *pChan;	/* I pointer to channel descriptor */
+int	grNeed;		/* I CAU_GR_NEED_xxx */
+{
+    if (pChan->connState != CAU_CONN_OK || grNeed == CAU_GR_NEED_NONE)
+	return 0;
+    if (pChan->dbfType == DBF_FLOAT || pChan->dbfType == DBF_DOUBLE ||
+					pChan->dbfType == DBF_ENUM)
+	return 1;
+    if (grNeed == CAU_GR_NEED_ALL && pChan->dbfType != DBF_STRING)
+	return 1;
+    return 0;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanGRRequest - request graphics information for a channel
+*
+* DESCRIPTION
+*	Sends a request for the channel's DBR_CTRL_xxx information, with
+*	cauChanGR as the handler, and counts it as part of the present
+*	graphics batch.  The graphics buffer is created the first time.
+*	This routine doesn't flush or wait.
+*
+*	If the information has already arrived, nothing is done.  If it
+*	has already been requested, the request is moved into the present
+*	batch, so that cauChanGRWait will wait for it.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauChanGRRequest(pCauDesc, pChan)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+{
+    long	stat;           /* status return from calls */
+    char	message [80];
+    chtype	getType;
+
+    if (pChan->grState == CAU_GR_OK)
+	return;
+    if (pChan->grState == CAU_GR_PEND) {
+	if (pChan->grBatch != pCauDesc->grBatch) {
+	    pChan->grBatch = pCauDesc->grBatch;
+	    pCauDesc->nGRWait++;
+	}
+	return;
+    }
+    if (pChan->pGRBuf == NULL) {
+	pChan->pGRBuf = (union db_access_val *)cauBufGet(pCauDesc,
+						sizeof(union db_access_val));
+	if (pChan->pGRBuf == NULL) {
+	    (void)printf("malloc error\n");
+	    return;
+	}
+	(void)memset((char *)pChan->pGRBuf, 0, sizeof(union db_access_val));
+	pChan->pGRBuf->gstrval.status = -2;
+    }
+#ifdef CAU_MMAP_CACHE
+    if (pCauDesc->cache.fd >= 0 && cauCacheGet(&pCauDesc->cache, pChan) == OK){
+	cauChanGRUnits(pChan);
+	cauChanEnumHash(pCauDesc, pChan);
+	pChan->grState = CAU_GR_OK;
+	pChan->grCached = 1;
+	pChan->grBatch = 0;
+    }
+#endif
+
+    getType = dbf_type_to_DBR_CTRL(pChan->dbfType);
+    sprintf(message, "prior to ca_array_get_callback (%s)",
+						dbr_type_to_text(getType));
+    cauCaDebug(message, 0);
+    stat = ca_array_get_callback(getType, 1, pChan->pCh, cauChanGR, pChan);
+    cauCaDebugStat("back from ca_array_get_callback", stat, 0);
+    if (stat != ECA_NORMAL) {
+	(void)printf("error getting graphics info for %s\n", pChan->name);
+	pChan->grCached = 0;
+	return;
+    }
+    if (pChan->grCached)
+	return;			/* live info just checks the cached info */
+    pChan->grState = CAU_GR_PEND;
+    pChan->grBatch = pCauDesc->grBatch;
+    pCauDesc->nGRWait++;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanGRUnits - set a channel's units from its graphics info
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauChanGRUnits(pChan)
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+{
+    if (pChan->dbfType == DBF_CHAR)
+	pChan->units = pChan->pGRBuf->gchrval.units;
+    else if (pChan->dbfType == DBF_SHORT)
+	pChan->units = pChan->pGRBuf->gshrtval.units;
+    else if (pChan->dbfType == DBF_LONG)
+	pChan->units = pChan->pGRBuf->glngval.units;
+    else if (pChan->dbfType == DBF_FLOAT)
+	pChan->units = pChan->pGRBuf->gfltval.units;
+    else if (pChan->dbfType == DBF_DOUBLE)
+	pChan->units = pChan->pGRBuf->gdblval.units;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanGRWait - wait for the present graphics batch
+*
+* DESCRIPTION
+*	Flushes the requests for the present graphics batch and then
+*	handles Channel Access events until all the information in the
+*	batch has arrived, or until 1 second has passed.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauChanGRWait(pCauDesc)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    long	stat;           /* status return from calls */
+    TS_STAMP	deadline;	/* time at which to quit waiting */
+    TS_STAMP	now;		/* present time */
+
+    (void)epicsTimeGetCurrent(&deadline);
+    epicsTimeAddSeconds(&deadline, 1.);
+    cauCaDebug("prior to ca_flush_io", 0);
+    stat = ca_flush_io();
+    cauCaDebugStat("back from ca_flush_io", stat, 0);
+    while (pCauDesc->nGRWait > 0) {
+	(void)epicsTimeGetCurrent(&now);
+	if (epicsTimeGreaterThanEqual(&now, &deadline))
+	    break;
+	(void)ca_pend_event(CAU_CONN_POLL);
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanHashAdd - add a channel to the channel hash table
+*
+* DESCRIPTION
+*	The hash table uses open addressing with linear probing.  When
+*	the table becomes half full, it is doubled in size.  The caller
+*	must already have made sure that the channel isn't in the table.
+*
+* RETURNS
+*	OK, or
+*	ERROR if the table can't be expanded
+*
+*-*/
+static long
+cauChanHashAdd(pCauDesc, pChan)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* I pointer to channel descriptor */
+{
+    CAU_CHAN	**ppOld;	/* previous hash table */
+    int		oldDim;		/* dimension of previous hash table */
+    int		mask;		/* mask for hash table index */
+    int		i, ix;
+
+    if (2 * (pCauDesc->nChanHash + 1) > pCauDesc->chanHashDim) {
+	ppOld = pCauDesc->ppChanHash;
+	oldDim = pCauDesc->chanHashDim;
+	pCauDesc->chanHashDim = oldDim > 0 ? 2 * oldDim : CAU_HASH_DIM;
+	pCauDesc->ppChanHash = (CAU_CHAN **)calloc(pCauDesc->chanHashDim,
+							sizeof(CAU_CHAN *));
+	if (pCauDesc->ppChanHash == NULL) {
+	    (void)printf("malloc error\n");
+	    pCauDesc->ppChanHash = ppOld;
+	    pCauDesc->chanHashDim = oldDim;
+	    return ERROR;
+	}
+	mask = pCauDesc->chanHashDim - 1;
+	for (i=0; i<oldDim; i++) {
+	    if (ppOld[i] == NULL)
+		continue;
+	    for (ix=ppOld[i]->nameHash&mask; pCauDesc->ppChanHash[ix]!=NULL;
+							ix=(ix+1)&mask)
+		;
+	    pCauDesc->ppChanHash[ix] = ppOld[i];
+	}
+	if (ppOld != NULL)
+	    free((char *)ppOld);
+    }
+
+    mask = pCauDesc->chanHashDim - 1;
+    for (ix=pChan->nameHash&mask; pCauDesc->ppChanHash[ix]!=NULL;
+							ix=(ix+1)&mask)
+	;
+    pCauDesc->ppChanHash[ix] = pChan;
+    pCauDesc->nChanHash++;
+    return OK;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanHashDel - remove a channel from the channel hash table
+*
+* DESCRIPTION
+*	After the channel is removed, the entries which follow it in the
+*	same probe sequence are moved back, so that no `deleted' markers
+*	are needed.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauChanHashDel(pCauDesc, pChan)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* I pointer to channel descriptor */
+{
+    CAU_CHAN	**ppHash=pCauDesc->ppChanHash;
+    int		mask;		/* mask for hash table index */
+    int		ix;		/* index of empty slot */
+    int		next;		/* index of slot being checked */
+    int		home;		/* preferred index for entry at next */
+
+    if (pCauDesc->nChanHash == 0)
+	return;
+    mask = pCauDesc->chanHashDim - 1;
+    for (ix=pChan->nameHash&mask; ppHash[ix]!=pChan; ix=(ix+1)&mask) {
+	if (ppHash[ix] == NULL)
+	    return;
+    }
+    ppHash[ix] = NULL;
+    pCauDesc->nChanHash--;
+
+    for (next=(ix+1)&mask; ppHash[next]!=NULL; next=(next+1)&mask) {
+	home = ppHash[next]->nameHash & mask;
+	if (((next - home) & mask) >= ((next - ix) & mask)) {
+	    ppHash[ix] = ppHash[next];
+	    ppHash[next] = NULL;
+	    ix = next;
+	}
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanLookup - look up a channel in the hash table
+*
+* DESCRIPTION
+*	This routine finds a channel in a cau descriptor, using the
+*	channel hash table.  A trailing .VAL on the name is ignored.
+*	Channels which are still on the connect list are found, too.
+*
+* RETURNS
+*	CAU_CHAN * for channel, if found, or
+*	NULL
+*
+*-*/
+static CAU_CHAN *
+cauChanLookup(pCauDesc, chanName)
+CAU_DESC *pCauDesc;	/* I pointer to cau descriptor */
+char	*chanName;	/* I channel name to find in cau */
+{
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    int		len;		/* length of name, without .VAL */
+    unsigned long hash;		/* hash of name */
+    int		mask;		/* mask for hash table index */
+    int		ix;		/* hash table index */
+
+    assert(pCauDesc != NULL);
+    assert(chanName != NULL);
+
+    if (pCauDesc->nChanHash == 0)
+	return NULL;
+    len = cauNameLen(chanName);
+    hash = cauNameHash(chanName, len);
+    mask = pCauDesc->chanHashDim - 1;
+    for (ix=hash&mask; (pChan=pCauDesc->ppChanHash[ix])!=NULL; ix=(ix+1)&mask) {
+	if (pChan->nameHash == hash && pChan->nameLen == len &&
+				strncmp(pChan->name, chanName, len) == 0)
+	    break;
+    }
+
+    return pChan;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanMatchFirst - find the first channel matching a pattern
+*
+* DESCRIPTION
+*	Finds, in the sorted index of connected channels, the first
+*	channel whose name matches a pattern which has been compiled with
+*	cauPatternCompile.  The index is rebuilt first, if channels have
+*	been added or deleted since it was built.  Further matches are
+*	found with cauChanMatchNext.
+*
+*	The channel which was found may be deleted before calling
+*	cauChanMatchNext, but no channels may be added.
+*
+* RETURNS
+*	CAU_CHAN * for channel, if found, or
+*	NULL
+*
+*-*/
+static CAU_CHAN *
+cauChanMatchFirst(pCauDesc, pPat)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_PATTERN *pPat;	/* IO pointer to compiled pattern */
+{
+    int		lo, hi, mid;	/* for binary search of index */
+
+    pPat->ix = pCauDesc->nChanSort;
+    if (!pCauDesc->chanSortValid && cauChanSort(pCauDesc) != OK)
+	return NULL;
+    lo = 0;
+    hi = pCauDesc->nChanSort;
+    while (lo < hi) {
+	mid = (lo + hi) / 2;
+	if (strncmp(pCauDesc->ppChanSort[mid]->name, pPat->text,
+						pPat->prefixLen) < 0)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    pPat->ix = lo - 1;
+    return cauChanMatchNext(pCauDesc, pPat);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanMatchNext - find the next channel matching a pattern
+*
+* DESCRIPTION
+*	Continues the search started by cauChanMatchFirst.  The search
+*	stops at the first name in the index which doesn't begin with
+*	the pattern's prefix.
+*
+* RETURNS
+*	CAU_CHAN * for channel, if found, or
+*	NULL
+*
+*-*/
+static CAU_CHAN *
+cauChanMatchNext(pCauDesc, pPat)
+CAU_DESC *pCauDesc;	/* I pointer to cau descriptor */
+CAU_PATTERN *pPat;	/* IO pointer to compiled pattern */
+{
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+
+    while (++pPat->ix < pCauDesc->nChanSort) {
+	pChan = pCauDesc->ppChanSort[pPat->ix];
+	if (strncmp(pChan->name, pPat->text, pPat->prefixLen) != 0)
+	    break;
+	if (cauPatternMatch(pPat, pChan->name))
+	    return pChan;
+    }
+    pPat->ix = pCauDesc->nChanSort;
+    return NULL;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanRearm - re-arm a channel whose type or count has changed
+*
+* DESCRIPTION
+*	Takes the channel's new native type and count, makes sure its
+*	buffer can hold a value of the new type, and, if the channel is
+*	being monitored, places the monitor again with the new type and
+*	count.  A requested count which was the whole of the old count
+*	follows the new count.
+*
+*	If a shard is monitoring the channel, its buffer and back buffer
+*	are first grown (with the shard's lock) to hold an update of the
+*	new type and count, since the shard's own connection may deliver
+*	such updates before the monitor is placed again.
+*
+*	If the channel is being pinged and its type has changed, the ping
+*	is ended first, since its values were chosen for the old type.
+*
+* RETURNS
+*	OK, or
+*	ERROR
+*
+*-*/
+static long
+cauChanRearm(pCxCmd, pCauDesc, pChan)
+CX_CMD	*pCxCmd;	/* I pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+{
+    int		monitored;	/* 1 says channel was being monitored */
+    unsigned long oldCount;	/* native count before re-arm */
+#ifdef CAU_SHARDS
+    size_t	nBytes;		/* size of an update of the new type */
+#endif
+
+    if (pChan->pPing != NULL && ca_field_type(pChan->pCh) != pChan->dbfType)
+	cauPingDone(pCauDesc);
+#ifdef CAU_SHARDS
+    if (pChan->pShard != NULL) {
+	nBytes = dbr_size_n(dbf_type_to_DBR_TIME(ca_field_type(pChan->pCh)),
+					ca_element_count(pChan->pCh));
+	CauChanLock(pChan);
+	if (nBytes > pChan->bufBackNeed) {
+	    if (pChan->bufBackNeed == 0)
+		pChan->pShard->nGrow++;
+	    pChan->bufBackNeed = nBytes;
+	}
+	CauChanUnlock(pChan);
+	cauShardGrow(pCauDesc);
+    }
+#endif
+    if ((monitored = CauChanMonitored(pChan)) != 0)
+	cauMonitorClear(pCauDesc, pChan);
+    oldCount = pChan->elCount;
+    pChan->dbfType = ca_field_type(pChan->pCh);
+    pChan->elCount = ca_element_count(pChan->pCh);
+    if (cauChanBufNeed(pCauDesc, pChan,
+		dbr_size_n(dbf_type_to_DBR_TIME(pChan->dbfType), 1)) != OK)
+	return ERROR;
+    pChan->pBuf->tstrval.status = -2;
+    pChan->nEl = 1;
+    pChan->dbrType = dbf_type_to_DBR(pChan->dbfType);
+    if (pChan->reqCount > pChan->elCount || pChan->reqCount == oldCount)
+	pChan->reqCount = pChan->elCount;
+    pChan->grState = CAU_GR_NONE;
+    if (monitored) {
+	pChan->dbrType = dbf_type_to_DBR_TIME(pChan->dbfType);
+	return cauMonitorAdd(pCxCmd, pCauDesc, pChan);
+    }
+    return OK;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauChanSort - build the sorted index of connected channels
+*
+* DESCRIPTION
+*	Fills ppChanSort with the channels on the channel list, sorted
+*	by name, expanding it if necessary.
+*
+* RETURNS
+*	OK, or
+*	ERROR if ppChanSort can't be expanded
+*
+*-*/
+static int
+cauChanSortCmp(pp1, pp2)
+const void *pp1;
+const void *pp2;
+{
+    return strcmp((*(CAU_CHAN **)pp1)->name, (*(CAU_CHAN **)pp2)->name);
+}
+static long
+cauChanSort(pCauDesc)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    CAU_CHAN	**ppNew;	/* pointer to expanded index */
+    int		nChan=0;	/* number of connected channels */
+    int		dim;		/* dimension for expanded index */
+
+    for (pChan=pCauDesc->pChanHead; pChan!=NULL; pChan=pChan->pNext)
+	nChan++;
+    if (nChan > pCauDesc->chanSortDim) {
+	dim = pCauDesc->chanSortDim > 0 ? pCauDesc->chanSortDim : CAU_HASH_DIM;
+	while (dim < nChan)
+	    dim *= 2;
+	ppNew = (CAU_CHAN **)malloc(dim * sizeof(CAU_CHAN *));
+	if (ppNew == NULL) {
+	    (void)printf("malloc error\n");
+	    return ERROR;
+	}
+	if (pCauDesc->ppChanSort != NULL)
+	    free((char *)pCauDesc->ppChanSort);
+	pCauDesc->ppChanSort = ppNew;
+	pCauDesc->chanSortDim = dim;
+    }
+    pCauDesc->nChanSort = 0;
+    for (pChan=pCauDesc->pChanHead; pChan!=NULL; pChan=pChan->pNext)
+	pCauDesc->ppChanSort[pCauDesc->nChanSort++] = pChan;
+    qsort((void *)pCauDesc->ppChanSort, (size_t)pCauDesc->nChanSort,
+				sizeof(CAU_CHAN *), cauChanSortCmp);
+    pCauDesc->chanSortValid = 1;
+
+    return OK;
+}
+
+#ifndef vxWorks
+/*+/subr**********************************************************************
+* NAME	cauCmdQueueInit - create the command queue
+*
+* DESCRIPTION
+*	Creates the queue through which cauInTask passes command lines to
+*	cauTask, along with the events used to pace cauInTask and the
+*	pipe used to wake cauTask from its select.  The queue is a ring
+*	buffer with a single writer and a single reader, so no locking
+*	is needed.
+*
+* RETURNS
+*	OK, or
+*	ERROR
+*
+*-*/
+static long
+cauCmdQueueInit(pCauDesc)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    pCauDesc->cmdQueue =
+		epicsRingBytesCreate(CAU_CMD_Q_DIM * sizeof(CAU_CMD_LINE));
+    pCauDesc->cmdQueueSpace = epicsEventCreate(epicsEventEmpty);
+    pCauDesc->cmdDoneEvent = epicsEventCreate(epicsEventEmpty);
+    if (pCauDesc->cmdQueue == NULL || pCauDesc->cmdQueueSpace == NULL ||
+					pCauDesc->cmdDoneEvent == NULL) {
+	(void)printf("cau: can't create command queue\n");
+	return ERROR;
+    }
+#ifndef _WIN32
+    if (pipe(pCauDesc->cmdWakeFd) != 0) {
+	(void)printf("cau: can't create pipe for command queue\n");
+	pCauDesc->cmdWakeFd[0] = pCauDesc->cmdWakeFd[1] = -1;
+	return ERROR;
+    }
+    (void)fcntl(pCauDesc->cmdWakeFd[0], F_SETFL, O_NONBLOCK);
+    (void)fcntl(pCauDesc->cmdWakeFd[1], F_SETFL, O_NONBLOCK);
+#endif
+    return OK;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauCmdQueueFree - free the command queue
+*
+* DESCRIPTION
+*	Frees the items created by cauCmdQueueInit.  cauInTask must have
+*	stopped before this routine is called.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauCmdQueueFree(pCauDesc)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    if (pCauDesc->cmdQueue != NULL)
+	epicsRingBytesDelete(pCauDesc->cmdQueue);
+    if (pCauDesc->cmdQueueSpace != NULL)
+	epicsEventDestroy(pCauDesc->cmdQueueSpace);
+    if (pCauDesc->cmdDoneEvent != NULL)
+	epicsEventDestroy(pCauDesc->cmdDoneEvent);
+#ifndef _WIN32
+    if (pCauDesc->cmdWakeFd[0] >= 0) {
+	(void)close(pCauDesc->cmdWakeFd[0]);
+	(void)close(pCauDesc->cmdWakeFd[1]);
+    }
+#endif
+    pCauDesc->cmdQueue = NULL;
+    pCauDesc->cmdQueueSpace = pCauDesc->cmdDoneEvent = NULL;
+    pCauDesc->cmdWakeFd[0] = pCauDesc->cmdWakeFd[1] = -1;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauCmdQueueGet - get the next command line from the queue
+*
+* DESCRIPTION
+*	If a command line is waiting in the queue, it is copied into
+*	the command context and the parse pointers (pCommand, pLine,
+*	and delim) are set up just as cmdRead would have left them.
+*
+* RETURNS
+*	pointer to the rest of the line (following the command), or
+*	NULL if the queue is empty
+*
+*-*/
+static char *
+cauCmdQueueGet(pCxCmd, pCauDesc)
+CX_CMD	*pCxCmd;	/* IO pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    CAU_CMD_LINE cmdLine;	/* command line from queue */
+
+    if (epicsRingBytesGet(pCauDesc->cmdQueue, (char *)&cmdLine,
+				sizeof(cmdLine)) != sizeof(cmdLine))
+	return NULL;
+    epicsEventSignal(pCauDesc->cmdQueueSpace);
+
+    (void)memcpy(pCxCmd->line, cmdLine.line, sizeof(pCxCmd->line));
+    pCxCmd->pCommand = pCxCmd->line + cmdLine.commandIx;
+    pCxCmd->pLine = pCxCmd->line + cmdLine.lineIx;
+    pCxCmd->delim = cmdLine.delim;
+    return pCxCmd->pLine;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauCmdQueuePut - put a command line into the queue
+*
+* DESCRIPTION
+*	Copies the command line which cmdRead has just parsed into the
+*	queue and wakes up cauTask.  If the queue is full, this routine
+*	waits for cauTask to make room.
+*
+* RETURNS
+*	OK, or
+*	ERROR if cauInTask has been asked to stop
+*
+*-*/
+static long
+cauCmdQueuePut(pCxCmd, pCauDesc)
+CX_CMD	*pCxCmd;	/* I pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    CAU_CMD_LINE cmdLine;	/* command line for queue */
+
+    (void)memcpy(cmdLine.line, pCxCmd->line, sizeof(cmdLine.line));
+    cmdLine.commandIx = pCxCmd->pCommand - pCxCmd->line;
+    cmdLine.lineIx = pCxCmd->pLine - pCxCmd->line;
+    cmdLine.delim = pCxCmd->delim;
+
+    pCauDesc->nCmdPut++;
+    while (epicsRingBytesPut(pCauDesc->cmdQueue, (char *)&cmdLine,
+				sizeof(cmdLine)) != sizeof(cmdLine)) {
+	if (pCauDesc->cauInTaskInfo.stop) {
+	    pCauDesc->nCmdPut--;
+	    return ERROR;
+	}
+	(void)epicsEventWaitWithTimeout(pCauDesc->cmdQueueSpace, .5);
+    }
+#ifndef _WIN32
+    (void)write(pCauDesc->cmdWakeFd[1], "", 1);
+#endif
+    return OK;
+}
+#endif
+
+/*+/subr**********************************************************************
+* NAME	cauDataOut - handle the dataOut command
+*
+* DESCRIPTION
+*	Sets a new destination for data output, closing the previous
+*	destination, if appropriate, and opening the new destination,
+*	if appropriate.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauDataOut(pCxCmd)
+CX_CMD	*pCxCmd;	/* IO pointer to command context */
+{
+    if (pCxCmd->dataOutRedir)
+	fclose (pCxCmd->dataOut);
+    pCxCmd->dataOutRedir = 0;
+    if (nextNonSpaceField( &pCxCmd->pLine, &pCxCmd->pField,
+						&pCxCmd->delim) < 1)
+	pCxCmd->dataOut = stdout;
+    else {
+	pCxCmd->dataOut = fopen(pCxCmd->pField, "a");
+	if (pCxCmd->dataOut == NULL) {
+	    (void)printf("couldn't open %s\n", pCxCmd->pField);
+	    pCxCmd->dataOut = stdout;
+	}
+	else
+	    pCxCmd->dataOutRedir = 1;
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cauFree - free a cau descriptor, after cleaning up
+*
+* DESCRIPTION
+*	This routine cleans up a cau descriptor, closing channels, etc.,
+*	and then free()'s the data structures.
+*
+* RETURNS
+*	OK
+*
+*-*/
+static long
+cauFree(pCxCmd, pCauDesc)
+CX_CMD	*pCxCmd;	/* I pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    long	retStat=OK;/* return status to caller */
+    CAU_HOST	*pHost;		/* pointer to host descriptor */
+    CAU_POLL	*pPoll;		/* pointer to poll group */
+    int		i;
+
+    assert(pCauDesc != NULL);
+
+    while (pCauDesc->pChanHead != NULL) {
+	if (cauChanDel(pCxCmd, pCauDesc, pCauDesc->pChanHead) != OK)
+	    (void)printf("cauFree: error deleting channel\n");
+    }
+    while (pCauDesc->pChanConnHead != NULL) {
+	if (cauChanDel(pCxCmd, pCauDesc, pCauDesc->pChanConnHead) != OK)
+	    (void)printf("cauFree: error deleting channel\n");
+    }
+#ifdef CAU_SHARDS
+    if (pCauDesc->nShard > 0)
+	(void)cauShardsSet(pCxCmd, pCauDesc, 0);
+#endif
+    if (pCauDesc->ppChanHash != NULL)
+	free((char *)pCauDesc->ppChanHash);
+    pCauDesc->ppChanHash = NULL;
+    pCauDesc->chanHashDim = pCauDesc->nChanHash = 0;
+    if (pCauDesc->ppChanSort != NULL)
+	free((char *)pCauDesc->ppChanSort);
+    pCauDesc->ppChanSort = NULL;
+    pCauDesc->chanSortDim = pCauDesc->nChanSort = 0;
+    pCauDesc->chanSortValid = 0;
+    if (pCauDesc->ppGet != NULL)
+	free((char *)pCauDesc->ppGet);
+    pCauDesc->ppGet = NULL;
+    pCauDesc->getDim = pCauDesc->nGet = pCauDesc->getWaitIx = 0;
+    if (pCauDesc->pGetRing != NULL) {
+	for (i=0; i<CAU_GET_WINDOW; i++) {
+	    if (pCauDesc->pGetRing[i].pBuf != NULL) {
+		cauBufPut(pCauDesc, pCauDesc->pGetRing[i].pBuf,
+					pCauDesc->pGetRing[i].bufSize);
+	    }
+	}
+	free((char *)pCauDesc->pGetRing);
+    }
+    pCauDesc->pGetRing = NULL;
+    pCauDesc->getSeqIn = pCauDesc->getSeqOut = 0;
+    if (pCauDesc->getHeap.ppTmr != NULL)
+	free((char *)pCauDesc->getHeap.ppTmr);
+    pCauDesc->getHeap.ppTmr = NULL;
+    pCauDesc->getHeap.nTmr = pCauDesc->getHeap.dim = 0;
+    if (pCauDesc->sigGenHeap.ppTmr != NULL)
+	free((char *)pCauDesc->sigGenHeap.ppTmr);
+    pCauDesc->sigGenHeap.ppTmr = NULL;
+    pCauDesc->sigGenHeap.nTmr = pCauDesc->sigGenHeap.dim = 0;
+    if (pCauDesc->deadTimeHeap.ppTmr != NULL)
+	free((char *)pCauDesc->deadTimeHeap.ppTmr);
+    pCauDesc->deadTimeHeap.ppTmr = NULL;
+    pCauDesc->deadTimeHeap.nTmr = pCauDesc->deadTimeHeap.dim = 0;
+    while ((pPoll = pCauDesc->pPollHead) != NULL) {
+	pCauDesc->pPollHead = pPoll->pNext;
+	if (pPoll->ppChan != NULL)
+	    free((char *)pPoll->ppChan);
+	free((char *)pPoll);
+    }
+    if (pCauDesc->pollHeap.ppTmr != NULL)
+	free((char *)pCauDesc->pollHeap.ppTmr);
+    pCauDesc->pollHeap.ppTmr = NULL;
+    pCauDesc->pollHeap.nTmr = pCauDesc->pollHeap.dim = 0;
+    if (pCauDesc->pingHeap.ppTmr != NULL)
+	free((char *)pCauDesc->pingHeap.ppTmr);
+    pCauDesc->pingHeap.ppTmr = NULL;
+    pCauDesc->pingHeap.nTmr = pCauDesc->pingHeap.dim = 0;
+    if (pCauDesc->putHeap.ppTmr != NULL)
+	free((char *)pCauDesc->putHeap.ppTmr);
+    pCauDesc->putHeap.ppTmr = NULL;
+    pCauDesc->putHeap.nTmr = pCauDesc->putHeap.dim = 0;
+    while ((pHost = pCauDesc->pHostHead) != NULL) {
+	pCauDesc->pHostHead = pHost->pNext;
+	free((char *)pHost);
+    }
+    if (pCauDesc->rearmHeap.ppTmr != NULL)
+	free((char *)pCauDesc->rearmHeap.ppTmr);
+    pCauDesc->rearmHeap.ppTmr = NULL;
+    pCauDesc->rearmHeap.nTmr = pCauDesc->rearmHeap.dim = 0;
+    cauPoolRelease(&pCauDesc->chanPool);
+    cauPoolRelease(&pCauDesc->sigGenPool);
+    cauPoolRelease(&pCauDesc->putPool);
+    pCauDesc->pPutHead = pCauDesc->pPutTail = NULL;
+    pCauDesc->nPutOut = 0;
+#ifdef CAU_MMAP_CACHE
+    if (pCauDesc->cache.fd >= 0)
+	cauCacheClose(&pCauDesc->cache);
+#endif
+    for (i=0; i<CAU_BUF_CLASS_DIM; i++)
+	cauPoolRelease(&pCauDesc->bufPool[i]);
+
+    return retStat;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauGetAndPrint - get and print the values for the queued channels
+*
+* DESCRIPTION
+*	This routine gets the current values for the channels which have
+*	been queued with cauGetQueue, and prints them, in the order they
+*	were queued.  The queue is then emptied.
+*
+*	All the requests are sent before waiting, and there is a single
+*	ca_pend_io for the whole list, so that getting many channels costs
+*	about one network round trip rather than one per channel.  Each
+*	get is made into a buffer of its own (described by a CAU_GET),
+*	marked with CAU_GET_PEND before the request is sent; a get whose
+*	buffer is still marked after the wait is reported as having timed
+*	out, without holding up the others.
+*
+*	Graphics information needed for printing is requested for all the
+*	channels which don't have it, with a single wait.
+*
+*	For getMode stream and ordered, the gets are instead started with
+*	cauGetSend, and this routine returns without waiting; the values
+*	are printed by cauGetDone and cauGetRelease as they arrive.
+*
+*	After the wait, each value is copied into its channel's buffer and
+*	printed, with the channel locked.  So if there are shards, their
+*	locks are only held for the copy and print, and not while the gets
+*	are outstanding.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauGetAndPrint(pCxCmd,
+		pCauDesc, printTime, printDBRType, printENUMAsShort)
+CX_CMD	*pCxCmd;	/* IO pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+int	printTime;	/* I 1 if time is to be printed */
+int	printDBRType;	/* I 1 if DBR_type of channel is to be printed */
+int	printENUMAsShort;/* I 1 if DBR_ENUM is to be printed as short */
+{
+    long	stat;
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    CAU_GET	*pGet;		/* gets, one per entry in ppGet */
+    CAU_GET	*pG;		/* pointer to a channel's get */
+    int		nPend=0;	/* number of gets sent */
+    int		i;
+
+    if (pCauDesc->nGet <= pCauDesc->getWaitIx)
+	return;
+    pCauDesc->grBatch++;
+    pCauDesc->nGRWait = 0;
+    for (i=pCauDesc->getWaitIx; i<pCauDesc->nGet; i++) {
+	if ((pChan = pCauDesc->ppGet[i]) == NULL)
+	    continue;
+	if (!printENUMAsShort || pChan->dbfType != DBF_ENUM) {
+	    if (cauChanGRNeeded(pChan, CAU_GR_NEED_PRINT))
+		cauChanGRRequest(pCauDesc, pChan);
+	}
+    }
+    if (pCauDesc->nGRWait > 0)
+	cauChanGRWait(pCauDesc);
+    if (pCauDesc->getMode != CAU_GET_MODE_PEND) {
+	pCauDesc->pGetCxCmd = pCxCmd->pCxCmdRoot;
+	cauGetSend(pCauDesc);
+	return;
+    }
+
+    pGet = (CAU_GET *)calloc((size_t)(pCauDesc->nGet - pCauDesc->getWaitIx),
+							sizeof(CAU_GET));
+    if (pGet == NULL) {
+	(void)printf("malloc error\n");
+	pCauDesc->nGet = pCauDesc->getWaitIx = 0;
+	return;
+    }
+    for (i=pCauDesc->getWaitIx; i<pCauDesc->nGet; i++) {
+	pG = &pGet[i - pCauDesc->getWaitIx];
+	pG->tmo.heapIx = -1;
+	pChan = pG->pChan = pCauDesc->ppGet[i];
+	if (pChan == NULL || pChan->connState != CAU_CONN_OK)
+	    continue;
+	pG->type = pChan->dbrType;
+	pG->count = CauChanGetCount(pChan);
+	pG->bufSize = dbr_size_n(pG->type, pG->count);
+	pG->pBuf = (union db_access_val *)cauBufGet(pCauDesc, pG->bufSize);
+	if (pG->pBuf == NULL) {
+	    (void)printf("malloc error\n");
+	    continue;
+	}
+	pG->pBuf->tstrval.status = CAU_GET_PEND;
+	cauCaDebugDbrAndName("prior to ca_array_get",
+					pG->type, pChan->name, 0);
+	stat = ca_array_get(pG->type, pG->count, pChan->pCh, pG->pBuf);
+	cauCaDebugStat("back from ca_array_get", stat, 0);
+	if (stat != ECA_NORMAL) {
+	    (void)printf("error on ca_array_get for %s \n", pChan->name);
+	    pG->pBuf->tstrval.status = -2;
+	}
+	else
+	    nPend++;
+    }
+    if (nPend > 0) {
+	cauCaDebug("prior to ca_pend_io", 0);
+	stat = ca_pend_io(CAU_GET_TMO);
+	cauCaDebugStat("back from ca_pend_io", stat, 0);
+    }
+    for (i=pCauDesc->getWaitIx; i<pCauDesc->nGet; i++) {
+	pG = &pGet[i - pCauDesc->getWaitIx];
+	if ((pChan = pG->pChan) == NULL)
+	    continue;
+	if (pG->pBuf == NULL) {
+	    if (pChan->connState != CAU_CONN_OK)
+		(void)printf("%s not connected\n", pChan->name);
+	    continue;
+	}
+	if (pG->pBuf->tstrval.status == CAU_GET_PEND)
+	    (void)printf("timeout on ca_array_get for %s \n", pChan->name);
+	else if (pG->pBuf->tstrval.status != -2) {
+	    CauChanLock(pChan);
+	    if (cauChanBufNeed(pCauDesc, pChan, pG->bufSize) == OK) {
+		(void)memcpy((char *)pChan->pBuf, (char *)pG->pBuf,
+							pG->bufSize);
+		pChan->nEl = pG->count;
+		cauPrintBuf(pCxCmd->dataOut, pChan,
+			1, printTime, printDBRType, printENUMAsShort, 0);
+	    }
+	    CauChanUnlock(pChan);
+	}
+	cauBufPut(pCauDesc, pG->pBuf, pG->bufSize);
+    }
+    free((char *)pGet);
+    pCauDesc->nGet = pCauDesc->getWaitIx = 0;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauGetChanDel - forget a channel's streamed gets
+*
+* DESCRIPTION
+*	Called when a channel is deleted.  Channels waiting in ppGet are
+*	dropped, and records for gets already sent are marked so that
+*	they're released without being printed.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauGetChanDel(pCauDesc, pChan)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* I pointer to channel descriptor */
+{
+    CAU_GET	*pGet;		/* pointer to get record */
+    long	seq;
+    int		i;
+
+    for (i=pCauDesc->getWaitIx; i<pCauDesc->nGet; i++) {
+	if (pCauDesc->ppGet[i] == pChan)
+	    pCauDesc->ppGet[i] = NULL;
+    }
+    if (pCauDesc->pGetRing == NULL)
+	return;
+    for (seq=pCauDesc->getSeqOut; seq<pCauDesc->getSeqIn; seq++) {
+	pGet = &pCauDesc->pGetRing[seq % CAU_GET_WINDOW];
+	if (pGet->pChan == pChan)
+	    pGet->pChan = NULL;
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cauGetDone - receive the value for a streamed get
+*
+* DESCRIPTION
+*	Handler for ca_array_get_callback.  The value is copied into the
+*	get's record; in stream mode it is printed right away.  Records
+*	which can be are then released.
+*
+*	The sequence number, rather than a pointer to the record, is
+*	passed as the user argument, so that an answer which arrives after
+*	its get has timed out (and the record has been re-used) is ignored.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauGetDone(arg)
+struct event_handler_args arg;
+{
+    CAU_DESC	*pCauDesc=pglCauDesc;
+    CAU_GET	*pGet;		/* pointer to get record */
+    long	seq;		/* sequence number of get */
+    size_t	size;		/* size of value */
+
+    seq = (long)arg.usr;
+    if (pCauDesc->pGetRing == NULL)
+	return;
+    pGet = &pCauDesc->pGetRing[seq % CAU_GET_WINDOW];
+    if (pGet->seq != seq || pGet->state != CAU_GET_SENT)
+	return;
+    cauTmrCancel(&pCauDesc->getHeap, &pGet->tmo);
+    if (arg.status != ECA_NORMAL || arg.dbr == NULL) {
+	pGet->state = CAU_GET_FAIL;
+	if (pGet->pChan != NULL)
+	    (void)printf("error on ca_array_get for %s \n", pGet->pChan->name);
+    }
+    else {
+	size = dbr_size_n(arg.type, arg.count);
+	if (size > pGet->bufSize) {
+	    if (pGet->pBuf != NULL)
+		cauBufPut(pCauDesc, pGet->pBuf, pGet->bufSize);
+	    pGet->pBuf = (union db_access_val *)cauBufGet(pCauDesc, size);
+	    pGet->bufSize = pGet->pBuf != NULL ? size : 0;
+	}
+	if (pGet->pBuf == NULL) {
+	    (void)printf("malloc error\n");
+	    pGet->state = CAU_GET_FAIL;
+	}
+	else {
+	    (void)memcpy((char *)pGet->pBuf, (char *)arg.dbr, size);
+	    pGet->type = arg.type;
+	    pGet->count = arg.count;
+	    pGet->state = CAU_GET_OK;
+	    if (pCauDesc->getMode != CAU_GET_MODE_ORDERED)
+		cauGetEmit(pCauDesc, pGet);
+	}
+    }
+    if (seq == pCauDesc->getSeqOut && cauGetRelease(pCauDesc) > 0 &&
+				pCauDesc->getWaitIx < pCauDesc->nGet)
+	cauGetSend(pCauDesc);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauGetEmit - print the value from a streamed get
+*
+* DESCRIPTION
+*	The value is copied into the channel's buffer (as a get in pend
+*	mode would leave it) and printed.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauGetEmit(pCauDesc, pGet)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_GET	*pGet;		/* I pointer to get record */
+{
+    CAU_CHAN	*pChan=pGet->pChan;
+
+    if (pChan == NULL || pGet->type != pChan->dbrType)
+	return;
+    CauChanLock(pChan);
+    if (cauChanBufNeed(pCauDesc, pChan,
+			dbr_size_n(pGet->type, pGet->count)) == OK) {
+	(void)memcpy((char *)pChan->pBuf, (char *)pGet->pBuf,
+				dbr_size_n(pGet->type, pGet->count));
+	pChan->nEl = pGet->count;
+	cauPrintBuf(pCauDesc->pGetCxCmd->dataOut, pChan, 1, 1, 0, 0, 0);
+    }
+    CauChanUnlock(pChan);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauGetQueue - add a channel to the list for cauGetAndPrint
+*
+* RETURNS
+*	OK, or
+*	ERROR if the list can't be expanded
+*
+*-*/
+static long
+cauGetQueue(pCauDesc, pChan)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* I pointer to channel descriptor */
+{
+    CAU_CHAN	**ppNew;	/* pointer to expanded list */
+    int		dim;		/* dimension for expanded list */
+
+    if (pCauDesc->nGet >= pCauDesc->getDim) {
+	dim = pCauDesc->getDim > 0 ? 2 * pCauDesc->getDim : CAU_HASH_DIM;
+	ppNew = (CAU_CHAN **)malloc(dim * sizeof(CAU_CHAN *));
+	if (ppNew == NULL) {
+	    (void)printf("malloc error\n");
+	    return ERROR;
+	}
+	if (pCauDesc->ppGet != NULL) {
+	    (void)memcpy((char *)ppNew, (char *)pCauDesc->ppGet,
+				pCauDesc->nGet * sizeof(CAU_CHAN *));
+	    free((char *)pCauDesc->ppGet);
+	}
+	pCauDesc->ppGet = ppNew;
+	pCauDesc->getDim = dim;
+    }
+    pCauDesc->ppGet[pCauDesc->nGet++] = pChan;
+    return OK;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauGetRelease - release finished streamed gets, in order
+*
+* DESCRIPTION
+*	Starting with the oldest, releases the records for streamed gets
+*	which have finished; in ordered mode, their values are printed as
+*	they're released.  Releasing stops at the first get which is still
+*	waiting, so that output stays in command line order.
+*
+* RETURNS
+*	number of records released
+*
+*-*/
+static int
+cauGetRelease(pCauDesc)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    CAU_GET	*pGet;		/* pointer to get record */
+    int		nRel=0;		/* number of records released */
+
+    while (pCauDesc->getSeqOut < pCauDesc->getSeqIn) {
+	pGet = &pCauDesc->pGetRing[pCauDesc->getSeqOut % CAU_GET_WINDOW];
+	if (pGet->state == CAU_GET_SENT)
+	    break;
+	if (pGet->state == CAU_GET_OK &&
+				pCauDesc->getMode == CAU_GET_MODE_ORDERED)
+	    cauGetEmit(pCauDesc, pGet);
+	pGet->state = CAU_GET_FREE;
+	pCauDesc->getSeqOut++;
+	nRel++;
+    }
+    return nRel;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauGetSend - send streamed gets for the channels in ppGet
+*
+* DESCRIPTION
+*	Sends a ca_array_get_callback for each channel waiting in ppGet,
+*	as long as there is room in the ring, arming a CAU_GET_TMO timer
+*	for each.  A channel which isn't connected, or whose get can't be
+*	sent, gets a record in CAU_GET_FAIL state, so that it holds its
+*	place in the output order.  Finished records are released as
+*	they're sent, making room for more.  When all the channels have
+*	been sent, ppGet is emptied.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauGetSend(pCauDesc)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    long	stat;
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    CAU_GET	*pGet;		/* pointer to get record */
+    TS_STAMP	now;		/* present time */
+    int		i;
+
+    if (pCauDesc->pGetRing == NULL) {
+	pCauDesc->pGetRing =
+		(CAU_GET *)malloc(CAU_GET_WINDOW * sizeof(CAU_GET));
+	if (pCauDesc->pGetRing == NULL) {
+	    (void)printf("malloc error\n");
+	    pCauDesc->nGet = pCauDesc->getWaitIx = 0;
+	    return;
+	}
+	for (i=0; i<CAU_GET_WINDOW; i++) {
+	    pCauDesc->pGetRing[i].state = CAU_GET_FREE;
+	    pCauDesc->pGetRing[i].seq = -1;
+	    pCauDesc->pGetRing[i].tmo.heapIx = -1;
+	    pCauDesc->pGetRing[i].tmo.pArg = &pCauDesc->pGetRing[i];
+	    pCauDesc->pGetRing[i].pBuf = NULL;
+	    pCauDesc->pGetRing[i].bufSize = 0;
+	}
+    }
+    (void)epicsTimeGetCurrent(&now);
+    while (pCauDesc->getWaitIx < pCauDesc->nGet) {
+	if (pCauDesc->getSeqIn - pCauDesc->getSeqOut >= CAU_GET_WINDOW &&
+					cauGetRelease(pCauDesc) == 0)
+	    break;
+	if ((pChan = pCauDesc->ppGet[pCauDesc->getWaitIx++]) == NULL)
+	    continue;
+	pGet = &pCauDesc->pGetRing[pCauDesc->getSeqIn % CAU_GET_WINDOW];
+	pGet->pChan = pChan;
+	pGet->seq = pCauDesc->getSeqIn++;
+	pGet->state = CAU_GET_FAIL;
+	if (pChan->connState != CAU_CONN_OK) {
+	    (void)printf("%s not connected\n", pChan->name);
+	    continue;
+	}
+	cauCaDebugDbrAndName("prior to ca_array_get_callback",
+					pChan->dbrType, pChan->name, 0);
+	stat = ca_array_get_callback(pChan->dbrType, pChan->reqCount,
+			pChan->pCh, cauGetDone, (void *)pGet->seq);
+	cauCaDebugStat("back from ca_array_get_callback", stat, 0);
+	if (stat != ECA_NORMAL) {
+	    (void)printf("error on ca_array_get for %s \n", pChan->name);
+	    continue;
+	}
+	pGet->state = CAU_GET_SENT;
+	pGet->tmo.time = now;
+	epicsTimeAddSeconds(&pGet->tmo.time, CAU_GET_TMO);
+	(void)cauTmrArm(&pCauDesc->getHeap, &pGet->tmo);
+    }
+    if (pCauDesc->getWaitIx >= pCauDesc->nGet)
+	pCauDesc->nGet = pCauDesc->getWaitIx = 0;
+    cauCaDebug("prior to ca_flush_io", 0);
+    stat = ca_flush_io();
+    cauCaDebugStat("back from ca_flush_io", stat, 0);
+    (void)cauGetRelease(pCauDesc);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauGetTimeout - time out streamed gets which haven't been answered
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauGetTimeout(pCauDesc)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    CAU_GET	*pGet;		/* pointer to get record */
+    TS_STAMP	now;		/* present time */
+
+    (void)epicsTimeGetCurrent(&now);
+    while (cauTmrDue(&pCauDesc->getHeap, &now)) {
+	pGet = (CAU_GET *)pCauDesc->getHeap.ppTmr[0]->pArg;
+	cauTmrCancel(&pCauDesc->getHeap, &pGet->tmo);
+	pGet->state = CAU_GET_FAIL;
+	if (pGet->pChan != NULL)
+	    (void)printf("timeout on ca_array_get for %s \n", pGet->pChan->name);
+    }
+    if (cauGetRelease(pCauDesc) > 0 && pCauDesc->getWaitIx < pCauDesc->nGet)
+	cauGetSend(pCauDesc);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauHostFind - find (or add) the descriptor for an IOC host
+*
+* RETURNS
+*	CAU_HOST * for host, or
+*	NULL if a new descriptor can't be allocated
+*
+*-*/
+static CAU_HOST *
+cauHostFind(pCauDesc, name)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+const char *name;	/* I host name */
+{
+    CAU_HOST	*pHost;		/* pointer to host descriptor */
+
+    for (pHost=pCauDesc->pHostHead; pHost!=NULL; pHost=pHost->pNext) {
+	if (strncmp(pHost->name, name, CAU_HOST_NAME_DIM-1) == 0)
+	    return pHost;
+    }
+    if ((pHost = (CAU_HOST *)malloc(sizeof(CAU_HOST))) == NULL) {
+	(void)printf("malloc error\n");
+	return NULL;
+    }
+    (void)strncpy(pHost->name, name, CAU_HOST_NAME_DIM-1);
+    pHost->name[CAU_HOST_NAME_DIM-1] = '\0';
+    pHost->backoff = CAU_REARM_MIN;
+    pHost->retry.heapIx = -1;
+    pHost->retry.pArg = pHost;
+    pHost->pRearmHead = NULL;
+    pHost->putNext.secPastEpoch = 0;
+    pHost->putNext.nsec = 0;
+    pHost->nPutSent = pHost->nPutCoalesced = 0;
+    pHost->pNext = pCauDesc->pHostHead;
+    pCauDesc->pHostHead = pHost;
+    return pHost;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauHostRearm - re-arm channels for hosts whose retry time is due
+*
+* DESCRIPTION
+*	For each host whose retry timer has come due, tries to re-arm the
+*	channels on the host's re-arm list.  Channels which are
+*	disconnected again are left for a later attempt.  If channels
+*	remain, the host's wait is doubled (up to CAU_REARM_MAX) and its
+*	timer is armed again; otherwise the wait goes back to
+*	CAU_REARM_MIN.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauHostRearm(pCxCmd, pCauDesc)
+CX_CMD	*pCxCmd;	/* I pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    CAU_HOST	*pHost;		/* pointer to host descriptor */
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    CAU_CHAN	**ppChan;	/* pointer to link to channel */
+    TS_STAMP	now;		/* present time */
+
+    (void)epicsTimeGetCurrent(&now);
+    while (cauTmrDue(&pCauDesc->rearmHeap, &now)) {
+	pHost = (CAU_HOST *)pCauDesc->rearmHeap.ppTmr[0]->pArg;
+	cauTmrCancel(&pCauDesc->rearmHeap, &pHost->retry);
+	ppChan = &pHost->pRearmHead;
+	while ((pChan = *ppChan) != NULL) {
+	    if (pChan->connState == CAU_CONN_OK &&
+			cauChanRearm(pCxCmd, pCauDesc, pChan) == OK) {
+		*ppChan = pChan->pRearmNext;
+		pChan->pRearmNext = NULL;
+		pChan->pHost = NULL;
+	    }
+	    else
+		ppChan = &pChan->pRearmNext;
+	}
+	if (pHost->pRearmHead == NULL) {
+	    pHost->backoff = CAU_REARM_MIN;
+	    continue;
+	}
+	pHost->backoff *= 2.;
+	if (pHost->backoff > CAU_REARM_MAX)
+	    pHost->backoff = CAU_REARM_MAX;
+	pHost->retry.time = now;
+	epicsTimeAddSeconds(&pHost->retry.time, pHost->backoff);
+	(void)cauTmrArm(&pCauDesc->rearmHeap, &pHost->retry);
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cauHostRearmDel - take a channel off its host's re-arm list
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauHostRearmDel(pChan)
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+{
+    CAU_CHAN	**ppChan;	/* pointer to link to channel */
+
+    if (pChan->pHost == NULL)
+	return;
+    for (ppChan=&pChan->pHost->pRearmHead; *ppChan!=NULL;
+					ppChan=&(*ppChan)->pRearmNext) {
+	if (*ppChan == pChan) {
+	    *ppChan = pChan->pRearmNext;
+	    break;
+	}
+    }
+    pChan->pRearmNext = NULL;
+    pChan->pHost = NULL;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauInitAtStartup - initialization for cau
+*
+* DESCRIPTION
+*	Perform several initialization duties:
+*	o   initialize an empty cau descriptor.  In order to
+*	    use the CAU_DESC, channels must be specified.
+*	o   initialize the command context block
+*	o   initialize the help information
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauInitAtStartup(pCauDesc, pCxCmd)
+CAU_DESC *pCauDesc;	/* O pointer to cau descriptor */
+CX_CMD	*pCxCmd;	/* I pointer to command context */
+{
+    int		i;
+
+    pCauDesc->pCxCmd = pCxCmd;
+    pCauDesc->pChanHead = NULL;
+    pCauDesc->pChanTail = NULL;
+    pCauDesc->pChanConnHead = NULL;
+    pCauDesc->pChanConnTail = NULL;
+    pCauDesc->connBatch = 0;
+    pCauDesc->nConnWait = 0;
+    pCauDesc->grBatch = 0;
+    pCauDesc->nGRWait = 0;
+    pCauDesc->ppChanHash = NULL;
+    pCauDesc->chanHashDim = 0;
+    pCauDesc->nChanHash = 0;
+    pCauDesc->ppChanSort = NULL;
+    pCauDesc->chanSortDim = 0;
+    pCauDesc->nChanSort = 0;
+    pCauDesc->chanSortValid = 0;
+    pCauDesc->ppGet = NULL;
+    pCauDesc->getDim = 0;
+    pCauDesc->nGet = 0;
+    pCauDesc->getWaitIx = 0;
+    pCauDesc->getMode = CAU_GET_MODE_PEND;
+    pCauDesc->pGetRing = NULL;
+    pCauDesc->getSeqIn = 0;
+    pCauDesc->getSeqOut = 0;
+    pCauDesc->pGetCxCmd = NULL;
+    pCauDesc->getHeap.ppTmr = NULL;
+    pCauDesc->getHeap.nTmr = 0;
+    pCauDesc->getHeap.dim = 0;
+    pCauDesc->secPerStep = .5;
+    pCauDesc->nSteps = 10;
+    pCauDesc->begVal = 0.;
+    pCauDesc->endVal = 0.;
+    pCauDesc->sigGenHeap.ppTmr = NULL;
+    pCauDesc->sigGenHeap.nTmr = 0;
+    pCauDesc->sigGenHeap.dim = 0;
+    pCauDesc->deadTimeHeap.ppTmr = NULL;
+    pCauDesc->deadTimeHeap.nTmr = 0;
+    pCauDesc->deadTimeHeap.dim = 0;
+    pCauDesc->pHostHead = NULL;
+    pCauDesc->pPollHead = NULL;
+    pCauDesc->pollHeap.ppTmr = NULL;
+    pCauDesc->pollHeap.nTmr = 0;
+    pCauDesc->pollHeap.dim = 0;
+    pCauDesc->pPing = NULL;
+    pCauDesc->pingHeap.ppTmr = NULL;
+    pCauDesc->pingHeap.nTmr = 0;
+    pCauDesc->pingHeap.dim = 0;
+    pCauDesc->putMode = CAU_PUT_MODE_PEND;
+    pCauDesc->pPutHead = pCauDesc->pPutTail = NULL;
+    pCauDesc->nPutOut = pCauDesc->nPutDone = 0;
+    pCauDesc->putLatSum = pCauDesc->putLatMax = 0.;
+    pCauDesc->putChanRate = pCauDesc->putHostRate = 0.;
+    pCauDesc->putHeap.ppTmr = NULL;
+    pCauDesc->putHeap.nTmr = 0;
+    pCauDesc->putHeap.dim = 0;
+    pCauDesc->nPutSent = pCauDesc->nPutCoalesced = pCauDesc->nPutDropped = 0;
+    pCauDesc->rearmHeap.ppTmr = NULL;
+    pCauDesc->rearmHeap.nTmr = 0;
+    pCauDesc->rearmHeap.dim = 0;
+    cauPoolInit(&pCauDesc->chanPool, sizeof(CAU_CHAN));
+    cauPoolInit(&pCauDesc->sigGenPool, sizeof(CAU_SIGGEN));
+    cauPoolInit(&pCauDesc->putPool, sizeof(CAU_PUT));
+#ifdef CAU_MMAP_CACHE
+    pCauDesc->cache.fd = -1;
+    pCauDesc->cache.pHdr = NULL;
+    pCauDesc->cache.pHash = NULL;
+    cauCacheClose(&pCauDesc->cache);
+#endif
+    for (i=0; i<CAU_BUF_CLASS_DIM; i++)
+	cauPoolInit(&pCauDesc->bufPool[i], (size_t)CAU_BUF_MIN << i);
+    pCauDesc->nBufLarge = 0;
+    pCauDesc->nBufLargeGet = 0;
+    pCauDesc->nCaFd = 0;
+    pCauDesc->caFdLost = 0;
+#ifndef vxWorks
+    pCauDesc->cmdQueue = NULL;
+    pCauDesc->cmdQueueSpace = NULL;
+    pCauDesc->cmdDoneEvent = NULL;
+    pCauDesc->nCmdPut = pCauDesc->nCmdDone = 0;
+    pCauDesc->cmdWakeFd[0] = pCauDesc->cmdWakeFd[1] = -1;
+#endif
+#ifdef CAU_SHARDS
+    pCauDesc->pShard = NULL;
+    pCauDesc->nShard = 0;
+#endif
+
+    cmdInitContext(pCxCmd, "  cau:  ");
+
+/*-----------------------------------------------------------------------------
+* help information initialization
+*----------------------------------------------------------------------------*/
+    helpInit(&pCxCmd->helpList);
+/*-----------------------------------------------------------------------------
+* help info--generic commands
+*----------------------------------------------------------------------------*/
+    helpTopicAdd(&pCxCmd->helpList, &pCxCmd->helpCmds, "commands", "\n\
+Generic commands are:\n\
+   dataOut    [filePath]     (default is to normal output)\n\
+   bg\n\
+   help       [topic]\n\
+   quit (or ^D)\n\
+   source     filePath\n\
+");
+/*-----------------------------------------------------------------------------
+* help info--cau-specific commands
+*----------------------------------------------------------------------------*/
+    helpTopicAdd(&pCxCmd->helpList, &pCxCmd->helpCmdsSpec, "commands", "\n\
+cau-specific commands are (the * isn't part of the command):\n\
+   cache         [filePath]  (use help cache for more info)\n\
+   cache-\n\
+   deadband      opt  (where opt is either MDEL or ADEL)\n\
+   debug         [n]  (where n can be 0, 1, 2, or 3; if n omitted, level++)\n\
+   debug-\n\
+   delete        chanName [chanName ...]  (or  all )\n\
+   get[,count]   [chanName [chanName ...]]\n\
+   getMode       opt  (where opt is pend, stream, or ordered)\n\
+  *info          [chanName [chanName ...]]\n\
+  *interval,sec[,jitter]  [chanName [chanName ...]]\n\
+   interval-     [chanName [chanName ...]]\n\
+   load[,batch[,sec]] filePath  (use help load for more info)\n\
+  *monitor[,count] [chanName [chanName ...]]  (count 0 for dynamic length)\n\
+   monitor-      [chanName [chanName ...]]\n\
+  *ping[,count[,rate]] chanName  (put to monitor latency; ping- stops)\n\
+  *poll,rate     [chanName [chanName ...]]  (rate is samples/sec)\n\
+   poll-         [chanName [chanName ...]]\n\
+   poll          (show poll statistics)\n\
+   pools         (show memory pool usage)\n\
+   put           chanName value [chanName value ...]  (use help put)\n\
+  *putMode       [opt]  (where opt is pend or callback)\n\
+   putRate       [chanRate [hostRate]]  (use help putRate for more info)\n\
+   ramp[,params] chanName [chanName ...]]  (use help ramp for more info)\n\
+   ramp-         [chanName [chanName ...]]\n\
+   restore       filePath  (use help snapshot for more info)\n\
+   shards        [n]  (use help shards for more info)\n\
+   snapshot      filePath [chanName [chanName ...]]\n\
+\n\
+Output from commands flagged with * can be routed to a file by using the\n\
+\"dataOut filePath\" command.  The present contents of the file are\n\
+preserved, with new output being written at the end.\n\
+");
+/*-----------------------------------------------------------------------------
+* help info--cache command
+*----------------------------------------------------------------------------*/
+    helpTopicAdd(&pCxCmd->helpList, &helpCache, "cache", "\n\
+   cache      [filePath]  (if filePath omitted, show cache statistics)\n\
+   cache-\n\
+\n\
+The cache command opens a metadata cache file, creating it if necessary.\n\
+The file keeps each channel's native type and count and its DBR_CTRL_...\n\
+information (units, precision, limits, and enum strings).  When that\n\
+information is needed for a channel which is in the cache, cau uses the\n\
+cached copy right away instead of waiting for the IOC; the information\n\
+is still fetched from the IOC, and the cache is updated if it has\n\
+changed.  Using the same cache file on the next run of cau avoids most\n\
+of the waiting when a large list of channels is started again.\n\
+\n\
+The cache- command closes the cache file.  The cache isn't available\n\
+under vxWorks or WIN32.\n\
+");
+/*-----------------------------------------------------------------------------
+* help info--debug command
+*----------------------------------------------------------------------------*/
+    helpTopicAdd(&pCxCmd->helpList, &helpDebug, "debug", "\n\
+   debug      [n]  (where n can be 0, 1, 2, or 3; if n omitted, level++)\n\
+   debug-\n\
+\n\
+The debug command sets a `debug level' which is used to control the\n\
+printing of debug information from Channel Access.  The debug command\n\
+without a value increments the debug level; the debug- command decrements\n\
+the debug level.  A specific level can be set by specifying a number\n\
+following the debug command.  The levels and their result are:\n\
+	0	don't print debug information\n\
+	1	print message before and after most ca_xxx calls\n\
+	2	print message at entry and exit to monitor handler\n\
+	3	print message before and after waiting in main loop\n\
+");
+/*-----------------------------------------------------------------------------
+* help info--bg command
+*----------------------------------------------------------------------------*/
+    helpTopicAdd(&pCxCmd->helpList, &pCxCmd->helpBg, "bg", "\n\
+The bg command under vxWorks allows the cau process to continue\n\
+running without accepting commands from the keyboard.  This allows the\n\
+vxWorks shell to be used for other purposes without the need to\n\
+terminate cau.\n\
+\n\
+Under SunOS, no bg command is directly available.  Instead, if cau\n\
+is being run from the C shell (csh), it can be detached using several\n\
+steps from the keyboard (with the first % on each line being the prompt\n\
+from csh):\n\
+	type ^Z, then type\n\
+	% bg %cau\n\
+\n\
+To move cau to the foreground, type\n\
+	% fg % cau\n\
+");
+/*-----------------------------------------------------------------------------
+* help info--interval command
+*----------------------------------------------------------------------------*/
+    helpTopicAdd(&pCxCmd->helpList, &helpInterval, "interval", "\n\
+The interval command provides for testing the interval between\n\
+successive samples on a channel (or on several channels).  A Channel\n\
+Access monitor is placed on the channel.  Each time a value is received,\n\
+the difference between its time stamp and the time stamp of the prior\n\
+value is computed.  If the difference is outside the specified tolerance,\n\
+then a message is printed.  The two valid forms of the command are:\n\
+\n\
+  *interval,sec[,jitter]  [chanName [chanName ...]]\n\
+   interval-  [chanName [chanName ...]]\n\
+\n\
+The allowable intervals are  \"sec - jitter\" to \"sec + jitter\", inclusive.\n\
+Because of rounding errors, some leeway should be implicit in the\n\
+specification of jitter.  For example, to test BSD_21N:00:00 for a 1\n\
+second interval, plus or minus 4 milli-seconds, use:\n\
+\n\
+   interval,1,.0041 BSD_21N:00:00\n\
+\n\
+Several interval tests can be operating simultaneously on different sets\n\
+of channels; a particular channel can't processed by two different interval\n\
+commands at once.\n\
+\n\
+In addition to the functionality just described, each channel has a\n\
+watchdog to see that it is still sending data.  If no value has been\n\
+received for (1 second + intervalTime) then an error message is printed\n\
+for the channel at that time, and another message is printed when data\n\
+resumes.\n\
+");
+/*-----------------------------------------------------------------------------
+* help info--load command information
+*----------------------------------------------------------------------------*/
+    helpTopicAdd(&pCxCmd->helpList, &helpLoad, "load", "\n\
+The load command adds the channels named in a file to the list, connecting\n\
+them in paced batches so that a very large list doesn't flood the network\n\
+with search requests.  The form is:\n\
+\n\
+   load[,batch[,sec]] filePath\n\
+\n\
+The file has one or more channel names per line, separated by blanks or\n\
+commas; lines beginning with # are ignored.  The file can be of any\n\
+length.  Searches are started for batch names (default 200) at a time,\n\
+with at least sec seconds (default .1) between the starts of batches.\n\
+Progress is printed about once a second; at the end, the number of\n\
+channels connected and the connect rate are printed.  Channels which\n\
+haven't connected by then stay in the list, and connect later.\n\
+\n\
+After loading, use (for example) monitor or \"interval,sec\" with no\n\
+channel names to operate on all the channels.\n\
+");
+/*-----------------------------------------------------------------------------
+* help info--put command
+*----------------------------------------------------------------------------*/
+    helpTopicAdd(&pCxCmd->helpList, &helpPut, "put", "\n\
+put chanName value [chanName value ...]\n\
+\n\
+Each value is converted to the channel's native type and checked against\n\
+the channel's control limits (or, for ENUM channels, its state strings)\n\
+before being sent.  Use \"value\" if the value contains blanks.  Values\n\
+for CHAR, SHORT, and LONG channels (and array elements for ENUM channels)\n\
+must be whole numbers; they aren't rounded.\n\
+\n\
+For channels which aren't STRING, a value can also be an array:\n\
+   [v1,v2,...]    inline values (use \"[v1 v2 ...]\" to separate with blanks)\n\
+   @filePath      a text file of numbers, separated by commas or white space\n\
+   @@filePath     a binary file of elements of the channel's native type,\n\
+                  in this host's byte order\n\
+\n\
+The array is sent with a single put; if it has fewer elements than the\n\
+channel, only those are put.  A binary file is put without conversion\n\
+or checking.  (See also putMode.)\n\
+");
+/*-----------------------------------------------------------------------------
+* help info--putRate command
+*----------------------------------------------------------------------------*/
+    helpTopicAdd(&pCxCmd->helpList, &helpPutRate, "putRate", "\n\
+putRate [chanRate [hostRate]]\n\
+\n\
+limits puts to at most chanRate per second for each channel, and at most\n\
+hostRate per second for all the channels on each IOC host.  0, the\n\
+default, is no limit; hostRate is 0 if it isn't given.\n\
+\n\
+When put or a signal generator (e.g., ramp) produces values for a channel\n\
+faster than that, the value is held and sent when the channel's turn\n\
+comes; if another value arrives first, it replaces the held one (it is\n\
+coalesced), so only the latest value is sent.  Arrays, and puts with\n\
+putMode callback, are sent at once, but count against the rates.  A held\n\
+value is dropped if its channel disconnects.\n\
+\n\
+With no rates, putRate prints the numbers of puts sent, coalesced,\n\
+dropped, and being held, for each host, and for each channel which has\n\
+had puts coalesced.\n\
+");
+/*-----------------------------------------------------------------------------
+* help info--ramp command information
+*----------------------------------------------------------------------------*/
+    helpTopicAdd(&pCxCmd->helpList, &helpRamp, "ramp", "\n\
+The ramp command can be used for numeric, enumerated, or string channels.\n\
+Optional parameters specify the delay time between steps in a cycle,\n\
+the number of steps per cycle, the beginning value, and the ending value.\n\
 If a parameter isn't specified, its value isn't changed.  Commas must be\n\
 used as `placeholders' if a parameter follows one or more omitted\n\
 parameters.  The form (all parameters are optional) is:\n\
@@ -1883,6 +6636,49 @@ For string channels (such as a state record), the generated signal is a\n\
 varying length text string, which is composed of repetitions of the digits\n\
 1 through 0.  begVal and endVal specify the beginning and ending length of\n\
 the string, in characters; default is 0 and 10, respectively.\n\
+\n\
+For channels being ramped, the info command shows how many steps have\n\
+been done and how late (last, average, and maximum) the steps have been.\n\
+");
+/*-----------------------------------------------------------------------------
+* help info--shards command information
+*----------------------------------------------------------------------------*/
+    helpTopicAdd(&pCxCmd->helpList, &helpShards, "shards", "\n\
+The shards command spreads the handling of monitors over several Channel\n\
+Access contexts, each with its own threads, so that a large number of\n\
+monitored channels can make use of several processors.  The form is:\n\
+\n\
+   shards     [n]  (where n is 0 to 64; if n omitted, show shard status)\n\
+\n\
+With n shards, each channel which is monitored (by the monitor or interval\n\
+commands) is given to a shard based on its name.  The shard makes its own\n\
+connection to the channel, and the shard's output is merged into the\n\
+normal output (or dataOut) every 50 milli-seconds.  Output for a channel\n\
+stays in order; output for channels in different shards may not.\n\
+Channels which are already being monitored are moved to the new shards.\n\
+\n\
+The default is 0, which handles monitors in cau's own context.  Shards\n\
+aren't available under vxWorks or WIN32.\n\
+");
+/*-----------------------------------------------------------------------------
+* help info--snapshot and restore commands
+*----------------------------------------------------------------------------*/
+    helpTopicAdd(&pCxCmd->helpList, &helpSnapshot, "snapshot", "\n\
+snapshot filePath [chanName [chanName ...]]\n\
+restore filePath\n\
+\n\
+snapshot writes the values of the named channels (names may be patterns),\n\
+or of all connected channels, to filePath.  Values are saved as each\n\
+channel's native type, with all its elements and its time stamp, in a\n\
+binary file.\n\
+\n\
+restore puts the values from a snapshot file back into the channels.\n\
+Channels which don't connect, or whose type has changed, aren't restored;\n\
+if a channel's element count has changed, the smaller count is used.\n\
+Each such mismatch is reported.\n\
+\n\
+A snapshot file can only be restored on a host with the same byte order\n\
+as the one which took the snapshot.\n\
 ");
 /*-----------------------------------------------------------------------------
 * help info--cau usage information
@@ -1898,6 +6694,18 @@ been used.  If names are specified for a command, then the command applies\n\
 only to those channels; if no names are specified, then the command applies\n\
 to all channels in the list.\n\
 \n\
+For get, monitor, delete, interval, and ramp, a channel name can be a\n\
+pattern, with * matching any characters and ? matching any one\n\
+character (for example, S1:BPM*:X).  A pattern selects the channels in\n\
+the list which are connected and whose names match; it doesn't add any\n\
+channels to the list.\n\
+\n\
+When a channel loses its connection, or is reconnected, a message with\n\
+the time is written to dataOut.  Monitors stay in place across a\n\
+reconnect.  If a channel comes back with a different type or element\n\
+count, its monitor is placed again shortly after the reconnect, with\n\
+channels from the same IOC handled together.\n\
+\n\
 Some commands produce output which can be routed to a file with the\n\
 \"dataOut filePath\" command.  Use \"help commands\" for more information.\n\
 \n\
@@ -1909,278 +6717,2284 @@ For information on moving cau into the background, use the \"help bg\"\n\
 command.\n\
 ");
 }
-
+
+/*+/subr**********************************************************************
+* NAME	cauMonitor - receive monitor buffer from Channel Access
+*
+* DESCRIPTION
+*	Copies the value into the channel's buffer and prints the value.
+*
+*	For channels with interval checking enabled (as indicated by a
+*	non-zero .interval item), the interval checking is done.  The
+*	value is printed only for the initial value and for violations
+*	of the interval criteria.
+*
+*	For channels with interval checking enabled, the channel's
+*	deadTime timer is re-armed to go off if the next value doesn't
+*	arrive within (1 second + interval).
+*
+*	For a channel which is monitored by a shard, this routine runs in
+*	one of the shard's Channel Access threads; it holds the shard's
+*	lock while it works, and prints into the shard's output buffer.
+*	The deadTime timer is kept in the shard's heap.  The update is
+*	copied into the channel's back buffer before the lock is taken,
+*	and the buffers are swapped with the lock held (see CAU_SHARD).
+*	(A channel's updates come from one thread at a time, so the back
+*	buffer needs no lock.)  Otherwise, the update is copied straight
+*	into the channel's buffer, since every reader of the buffer runs
+*	in this thread.  Either way, an update costs a single memcpy,
+*	whatever its type and count.
+*
+* RETURNS
+*	void
+*
+* BUGS
+* o	only prints first element for array channels
+*
+* NOTES
+* 1.	If debug level is 2 or more, then a time stamped message is
+*	printed when this routine is entered, and another is printed
+*	when it exits.
+*
+*-*/
+static void
+cauMonitor(arg)
+struct event_handler_args arg;
+{
+    CAU_CHAN	*pCauChan;	/* pointer to channel descriptor */
+    int		nBytes;		/* total size of `value' buffer */
+    double	interval;	/* difference between present and prev stamp */
+    char 	priorStampText[28];/* time stamp of prior value */
+    double	diff;		/* diff between actual and desired intervals */
+    int		printFlag=1;
+    CX_CMD	*pCxCmd;	/* pointer to command context */
+    char	message[80];
+    char	nowText[28];
+    char	chanTsText[28];
+    CAU_TMR_HEAP *pDeadTimeHeap;/* heap for channel's deadTime timer */
+    FILE	*out;		/* stream for printing */
+#ifdef CAU_SHARDS
+    CAU_SHARD	*pShard;	/* shard monitoring channel, or NULL */
+    union db_access_val *pSwap;	/* for swapping buffers */
+    size_t	sizeSwap;	/* for swapping buffer sizes */
+    int		nBackBytes=0;	/* bytes copied into back buffer */
+    size_t	nNeed=0;	/* size of update too big for back buffer */
+    union db_access_val *pBack;	/* back buffer being copied into */
+#endif
+
+    pCauChan = (CAU_CHAN *)arg.usr;
+    pCxCmd = pCauChan->pCxCmd;
+    out = pCxCmd->dataOut;
+    pDeadTimeHeap = &pglCauDesc->deadTimeHeap;
+#ifdef CAU_SHARDS
+    if ((pShard = pCauChan->pShard) != NULL) {
+	nBackBytes = dbr_size_n(arg.type, arg.count);
+	epicsMutexMustLock(pShard->lock);
+	pBack = NULL;
+	if ((size_t)nBackBytes <= pCauChan->bufBackSize) {
+	    pBack = pCauChan->pBufBack;
+	    pCauChan->bufBackBusy = 1;	/* cauShardGrow must leave it be */
+	}
+	epicsMutexUnlock(pShard->lock);
+	if (pBack != NULL)
+	    (void)memcpy((char *)pBack, (char *)arg.dbr, (size_t)nBackBytes);
+	else {
+	    nNeed = (size_t)nBackBytes;
+	    nBackBytes = 0;	/* shard can't use pools; see cauShardGrow */
+	}
+	epicsMutexMustLock(pShard->lock);
+	pCauChan->bufBackBusy = 0;
+	out = pShard->out[pShard->outIx];
+	pDeadTimeHeap = &pShard->deadTimeHeap;
+	pShard->nMon++;
+	if (nNeed > 0) {
+	    pCauChan->nShardDrop++;
+	    pShard->nDrop++;
+	    if (pCauChan->bufBackNeed == 0) {
+		pShard->nGrow++;
+		(void)fprintf(out,
+		    "%s: update of %lu bytes dropped; growing buffer\n",
+		    pCauChan->name, (unsigned long)nNeed);
+	    }
+	    if (nNeed > pCauChan->bufBackNeed)
+		pCauChan->bufBackNeed = nNeed;
+	}
+    }
+#endif
+
+    (void)epicsTimeGetCurrent(&pCauChan->lastMonTime);
+    if (pCauChan->interval > 0.) {
+	pCauChan->deadTime.time = pCauChan->lastMonTime;
+	epicsTimeAddSeconds(&pCauChan->deadTime.time, pCauChan->interval + 1.);
+	(void)cauTmrArm(pDeadTimeHeap, &pCauChan->deadTime);
+#ifdef CAU_SHARDS
+	if (pShard != NULL && pCauChan->deadTime.heapIx == 0 &&
+		epicsTimeLessThan(&pCauChan->deadTime.time,
+						&pShard->deadTimeWait))
+	    epicsEventSignal(pShard->opEvent);
+#endif
+    }
+    if (pCauChan->lastMonErr != 0) {
+        (void)epicsTimeToStrftime(nowText,28,"%m-%d-%y %H:%M:%S.%09f",&pCauChan->lastMonTime);
+        (void)epicsTimeToStrftime(chanTsText,28,"%m-%d-%y %H:%M:%S.%09f",
+                                                &((struct dbr_time_string *)arg.dbr)->stamp);
+	(void)fprintf(out,
+	    "resume for %s at %s (local) or %s (ioc)\n", pCauChan->name, nowText,chanTsText);
+	if (pCxCmd->dataOut != stdout) {
+	    epicsTimeToStrftime(nowText,28,"%m-%d-%y %H:%M:%S.%09f",&pCauChan->lastMonTime);
+	    epicsTimeToStrftime(chanTsText,28,"%m-%d-%y %H:%M:%S.%09f",
+                                                &((struct dbr_time_string *)arg.dbr)->stamp);
+	    (void)fprintf(out,
+		"resume for %s at %s (local) or %s (ioc)\n", pCauChan->name, nowText,chanTsText);
+	}
+	pCauChan->lastMonErr = 0;
+    }
+    if (glCauDebug > 1) {
+	nBytes = dbr_size_n(arg.type, arg.count);
+	(void)sprintf(message, "enter cauMonitor() for %s %s %d",
+		pCauChan->name, dbr_type_to_text(arg.type), nBytes);
+	cauCaDebug(message, 1);
+    }
+    if (pCauChan->interval > 0. && pCauChan->pBuf->tstrval.status != -2) {
+
+	interval = epicsTimeDiffInSeconds (&((struct dbr_time_string *)arg.dbr)->stamp,
+                                                &pCauChan->pBuf->tstrval.stamp);
+	diff = pCauChan->interval - interval;
+	if (diff < 0.)
+	    diff = -diff;
+	if (diff > pCauChan->jitter) {
+	    (void)epicsTimeToStrftime(priorStampText,28,"%m-%d-%y %H:%M:%S.%09f",
+                                &pCauChan->pBuf->tstrval.stamp);
+	    (void)fprintf(out,
+		    "interval from prior (at %s) to following is %.3f\n",
+                    priorStampText, interval);
+	}
+	else
+	    printFlag = 0;
+    }
+#ifdef CAU_SHARDS
+    if (pShard != NULL) {
+	if ((nBytes = nBackBytes) > 0) {
+	    pSwap = pCauChan->pBuf;
+	    pCauChan->pBuf = pCauChan->pBufBack;
+	    pCauChan->pBufBack = pSwap;
+	    sizeSwap = pCauChan->bufSize;
+	    pCauChan->bufSize = pCauChan->bufBackSize;
+	    pCauChan->bufBackSize = sizeSwap;
+	    pCauChan->nEl = arg.count;
+	}
+    }
+    else
+#endif
+    {
+	nBytes = dbr_size_n(arg.type, arg.count);
+	if (nBytes > pCauChan->bufSize &&
+		cauChanBufNeed(pglCauDesc, pCauChan, (size_t)nBytes) != OK)
+	    nBytes = 0;
+	if (nBytes > 0) {
+	    (void)memcpy((char *)pCauChan->pBuf, (char *)arg.dbr,
+							(size_t)nBytes);
+	    pCauChan->nEl = arg.count;
+	}
+    }
+    if (pCauChan->pPing != NULL) {
+	cauPingMatch(pCauChan->pPing, pCauChan, arg.type, arg.dbr,
+						&pCauChan->lastMonTime);
+	printFlag = 0;
+    }
+    if (printFlag && nBytes > 0)
+	cauPrintBuf(out, pCauChan, 1, 1, 0, 0, 0);
+    CauChanUnlock(pCauChan);
+    cauCaDebug("exit cauMonitor()", 1);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauMonitorAdd - start monitoring a channel
+*
+* DESCRIPTION
+*	Places a Channel Access monitor on the channel, using the
+*	channel's present DBR_xxx type and request count, and the
+*	present deadband option.  cauMonitor is the handler.
+*
+*	If printing the channel's values needs its graphics information,
+*	the information is requested (without waiting) ahead of the
+*	monitor.  Until it arrives, values are printed without it.
+*
+*	If cau has shards, the monitor is instead given to the shard
+*	which the channel's name hashes to.  The shard connects to the
+*	channel in its own context and places the monitor when the
+*	connection is made, so this routine doesn't wait.  Because a
+*	shard can't take buffers from the pools, the channel's buffer is
+*	made big enough for the full request count (or, for a dynamic
+*	count of 0, the native count) first; without shards, the buffer
+*	grows as bigger values arrive.
+*
+* RETURNS
+*	OK, or
+*	ERROR
+*
+*-*/
+static long
+cauMonitorAdd(pCxCmd, pCauDesc, pChan)
+CX_CMD	*pCxCmd;	/* I pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+{
+    long	stat;
+    char	*msg;
+#ifdef CAU_SHARDS
+    CAU_SHARD	*pShard;	/* shard to monitor channel */
+#endif
+
+    if (cauChanGRNeeded(pChan, CAU_GR_NEED_PRINT))
+	cauChanGRRequest(pCauDesc, pChan);
+#ifdef CAU_SHARDS
+    if (pCauDesc->nShard > 0) {
+	if (cauShardBufNeed(pCauDesc, pChan,
+		dbr_size_n(pChan->dbrType, CauChanGetCount(pChan))) != OK)
+	    return ERROR;
+	pShard = &pCauDesc->pShard[pChan->nameHash % pCauDesc->nShard];
+	pChan->pShard = pShard;
+	if (cauShardOpPut(pShard, CAU_SHARD_MON, pChan) != OK) {
+	    (void)printf("shard %d can't monitor %s\n", pShard->ix, pChan->name);
+	    pChan->pShard = NULL;
+	    return ERROR;
+	}
+	return OK;
+    }
+#endif
+
+    if (glCauDeadband & DBE_VALUE)
+	msg = glCauMDEL_msg;
+    else
+	msg = glCauADEL_msg;
+    cauCaDebugDbrAndName(msg, pChan->dbrType, pChan->name, 0);
+    stat = ca_add_masked_array_event(pChan->dbrType,
+		pChan->reqCount, pChan->pCh, cauMonitor, pChan,
+		0., 0., 0., &pChan->pEv, glCauDeadband);
+    cauCaDebugStat("back from ca_add_array_event", stat, 0);
+    if (stat != ECA_NORMAL) {
+	(void)printf("ca_add_event error: %s \n", pChan->name);
+	pChan->pEv = NULL;
+	return ERROR;
+    }
+    return OK;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauMonitorClear - stop monitoring a channel
+*
+* DESCRIPTION
+*	Clears the channel's monitor, if it has one, and cancels its
+*	deadTime timer.  For a channel which is monitored by a shard,
+*	this routine waits until the shard has disconnected (and
+*	cancelled the timer), so that no more monitor callbacks can occur.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauMonitorClear(pCauDesc, pChan)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+{
+    long	stat;
+#ifdef CAU_SHARDS
+    CAU_SHARD	*pShard;	/* shard monitoring channel */
+
+    if ((pShard = pChan->pShard) != NULL) {
+	if (cauShardOpPut(pShard, CAU_SHARD_MON_STOP, pChan) == OK)
+	    cauShardSync(pShard);
+	pChan->pShard = NULL;
+    }
+    cauBufPut(pCauDesc, pChan->pBufBack, pChan->bufBackSize);
+    pChan->pBufBack = NULL;
+    pChan->bufBackSize = 0;
+#endif
+    if (pChan->pEv != NULL) {
+	cauCaDebugName("prior to ca_clear_event", pChan->name, 0);
+	stat = ca_clear_event(pChan->pEv);
+	cauCaDebugStat("back from ca_clear_event", stat, 0);
+	if (stat != ECA_NORMAL) {
+	    (void)printf("ca_clear_event error: %s \n", pChan->name);
+	}
+	pChan->pEv = NULL;
+    }
+    cauTmrCancel(&pCauDesc->deadTimeHeap, &pChan->deadTime);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauNameHash - compute a hash value for a channel name
+*
+* DESCRIPTION
+*	Computes the FNV-1a hash of the first nChar characters of the
+*	name.  (nChar is usually obtained from cauNameLen, so that the
+*	hash doesn't depend on whether .VAL was given.)
+*
+* RETURNS
+*	hash value
+*
+*-*/
+static unsigned long
+cauNameHash(name, nChar)
+char	*name;		/* I channel name */
+int	nChar;		/* I number of characters to use */
+{
+    unsigned long hash=2166136261UL;
+
+    while (nChar-- > 0) {
+	hash ^= (unsigned char)*name++;
+	hash = (hash * 16777619UL) & 0xffffffffUL;
+    }
+    return hash;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauNameLen - get the length of a channel name, without .VAL
+*
+* DESCRIPTION
+*	Since .VAL is assumed if the field is omitted, "xxx" and "xxx.VAL"
+*	are the same channel.  This routine gives the length of the
+*	name with a trailing .VAL omitted, for use in comparing names.
+*
+* RETURNS
+*	length of name, not counting a trailing .VAL
+*
+*-*/
+static int
+cauNameLen(name)
+char	*name;		/* I channel name */
+{
+    int		len;
+
+    len = strlen(name);
+    if (len > 4 && strcmp(&name[len-4], ".VAL") == 0)
+	len -= 4;
+    return len;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPatternCompile - compile a channel name pattern
+*
+* DESCRIPTION
+*	Checks whether a channel name has any wildcards and, if it does,
+*	compiles it for use with cauChanMatchFirst and cauPatternMatch.
+*
+* RETURNS
+*	1 if the name is a pattern, or
+*	0 if it is an ordinary channel name
+*
+*-*/
+static int
+cauPatternCompile(pPat, pattern)
+CAU_PATTERN *pPat;	/* O pointer to compiled pattern */
+char	*pattern;	/* I channel name, possibly with wildcards */
+{
+    char	*pText;		/* pointer into text of pattern */
+
+    pPat->prefixLen = strcspn(pattern, "*?");
+    if (pattern[pPat->prefixLen] == '\0')
+	return 0;
+    (void)strncpy(pPat->text, pattern, db_name_dim-1);
+    pPat->text[db_name_dim-1] = '\0';
+    pPat->nSeg = 0;
+    pText = pPat->text;
+    while (1) {
+	pPat->pSeg[pPat->nSeg] = pText;
+	while (*pText != '*' && *pText != '\0')
+	    pText++;
+	pPat->segLen[pPat->nSeg] = pText - pPat->pSeg[pPat->nSeg];
+	pPat->nSeg++;
+	if (*pText == '\0')
+	    break;
+	*pText++ = '\0';
+    }
+    pPat->ix = 0;
+    return 1;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPatternMatch - check a channel name against a pattern
+*
+* DESCRIPTION
+*	The first segment of the pattern must match at the beginning of
+*	the name and the last segment at the end; the segments between
+*	are found, in order, at the first place each one matches.  (For
+*	patterns with only `*' and `?', taking the first place never
+*	prevents a match, so no backtracking is needed.)
+*
+* RETURNS
+*	1 if the name matches, or
+*	0
+*
+*-*/
+static int
+cauPatternSegMatch(pText, pSeg, len)
+char	*pText;		/* I pointer into name */
+char	*pSeg;		/* I pointer to segment */
+int	len;		/* I length of segment */
+{
+    while (len-- > 0) {
+	if (*pSeg != '?' && *pSeg != *pText)
+	    return 0;
+	pSeg++, pText++;
+    }
+    return 1;
+}
+static int
+cauPatternMatch(pPat, name)
+CAU_PATTERN *pPat;	/* I pointer to compiled pattern */
+char	*name;		/* I channel name */
+{
+    char	*pText=name;	/* pointer to unmatched part of name */
+    char	*pEnd;		/* pointer to end of unmatched part */
+    int		last=pPat->nSeg-1;/* index of last segment */
+    int		i;
+
+    pEnd = name + strlen(name);
+    if (last == 0) {
+	return pEnd - pText == pPat->segLen[0] &&
+		cauPatternSegMatch(pText, pPat->pSeg[0], pPat->segLen[0]);
+    }
+    if (pEnd - pText < pPat->segLen[0] + pPat->segLen[last])
+	return 0;
+    if (!cauPatternSegMatch(pText, pPat->pSeg[0], pPat->segLen[0]))
+	return 0;
+    pText += pPat->segLen[0];
+    pEnd -= pPat->segLen[last];
+    if (!cauPatternSegMatch(pEnd, pPat->pSeg[last], pPat->segLen[last]))
+	return 0;
+    for (i=1; i<last; i++) {
+	while (pEnd - pText >= pPat->segLen[i] &&
+		!cauPatternSegMatch(pText, pPat->pSeg[i], pPat->segLen[i]))
+	    pText++;
+	if (pEnd - pText < pPat->segLen[i])
+	    return 0;
+	pText += pPat->segLen[i];
+    }
+    return 1;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPingDone - finish a ping and print its results
+*
+* DESCRIPTION
+*	Stops the ping, removes the monitor if the ping added it, and
+*	prints, to dataOut, the number of puts sent and lost and the
+*	minimum, median, 99th percentile, and maximum latencies, in
+*	milliseconds.
+*
+* RETURNS
+*	void
+*
+*-*/
+static int
+cauPingCmp(p1, p2)
+const void *p1;
+const void *p2;
+{
+    double	d1 = *(double *)p1, d2 = *(double *)p2;
+
+    return d1 < d2 ? -1 : d1 > d2 ? 1 : 0;
+}
+static void
+cauPingDone(pCauDesc)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    CAU_PING	*pPing=pCauDesc->pPing;/* pointer to ping */
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    double	*pLat;		/* latencies, sorted */
+    FILE	*out;		/* stream for printing */
+    long	nLat=0;		/* number of latencies */
+    long	i;
+
+    pChan = pPing->pChan;
+    out = pPing->pCxCmd->dataOut;
+    cauTmrCancel(&pCauDesc->pingHeap, &pPing->next);
+    CauChanLock(pChan);
+    pChan->pPing = NULL;
+    CauChanUnlock(pChan);
+    pCauDesc->pPing = NULL;
+    if (pPing->monAdded)
+	cauMonitorClear(pCauDesc, pChan);
+
+    pLat = pPing->pLatency;
+    for (i=0; i<pPing->nSent; i++) {
+	if (pLat[i] >= 0.)
+	    pLat[nLat++] = pLat[i];
+    }
+    qsort((void *)pLat, (size_t)nLat, sizeof(double), cauPingCmp);
+    (void)fprintf(out, "%s ping: %ld sent, %ld lost (%.1f%%)\n",
+		pChan->name, pPing->nSent, pPing->nSent - nLat,
+		pPing->nSent > 0 ?
+			100. * (pPing->nSent - nLat) / pPing->nSent : 0.);
+    if (nLat > 0) {
+	(void)fprintf(out,
+		"latency min %.3f median %.3f p99 %.3f max %.3f ms\n",
+		1000. * pLat[0], 1000. * pLat[(nLat-1)/2],
+		1000. * pLat[(long)ceil(.99 * nLat) - 1],
+		1000. * pLat[nLat-1]);
+    }
+    free((char *)pPing->pSendTime);
+    free((char *)pPing->pLatency);
+    free((char *)pPing);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPingMatch - match a monitor update to a ping's put
+*
+* DESCRIPTION
+*	Called from cauMonitor, with the channel locked.  Finds the put
+*	which sent the update's value (the latest one, if values repeat)
+*	and, if that put hasn't been matched yet, records its latency.
+*	Updates whose value wasn't sent by the ping are ignored.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauPingMatch(pPing, pChan, type, pDbr, pRecvTime)
+CAU_PING *pPing;	/* IO pointer to ping */
+CAU_CHAN *pChan;	/* I pointer to channel descriptor */
+chtype	type;		/* I DBR_xxx type of update */
+void	*pDbr;		/* I pointer to update */
+TS_STAMP *pRecvTime;	/* I time update was received */
+{
+    void	*pVal;		/* pointer to update's first value */
+    double	dbl;		/* value, as double */
+    long	k;		/* value, less CAU_PING_BASE */
+    long	i;		/* put which sent the value */
+
+    pVal = dbr_value_ptr(pDbr, type);
+    if (pChan->dbfType == DBF_CHAR)
+	dbl = *(dbr_char_t *)pVal;
+    else if (pChan->dbfType == DBF_SHORT)
+	dbl = *(dbr_short_t *)pVal;
+    else if (pChan->dbfType == DBF_LONG)
+	dbl = *(dbr_long_t *)pVal;
+    else if (pChan->dbfType == DBF_FLOAT)
+	dbl = *(dbr_float_t *)pVal;
+    else if (pChan->dbfType == DBF_DOUBLE)
+	dbl = *(dbr_double_t *)pVal;
+    else
+	return;
+    if (dbl != floor(dbl) || dbl < CAU_PING_BASE)
+	return;
+    k = (long)dbl - CAU_PING_BASE;
+    if (k >= pPing->nSent)
+	return;
+    if (pPing->modulus > 0) {
+	if (k >= pPing->modulus)
+	    return;
+	i = pPing->nSent - 1 - (pPing->nSent - 1 - k) % pPing->modulus;
+    }
+    else
+	i = k;
+    if (pPing->pLatency[i] >= 0.)
+	return;
+    pPing->pLatency[i] = epicsTimeDiffInSeconds(pRecvTime,
+						&pPing->pSendTime[i]);
+    pPing->nRecv++;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPingRun - send a ping's next put, or check for its end
+*
+* DESCRIPTION
+*	Called from cauTask when the ping's timer is due.  Until all the
+*	puts have been sent, sends the next one (with ca_put, bypassing
+*	putRate, so that the measurement isn't distorted) and re-arms for
+*	the next.  After that, checks every CAU_PING_CHECK seconds until
+*	all the updates have arrived, or CAU_PING_TMO seconds have
+*	passed, and then calls cauPingDone.  (cauChanConnDown and
+*	cauChanRearm end the ping if the channel disconnects or changes
+*	type; the channel is checked again here before each put, so that
+*	a put is never sent from a value the type doesn't fill in.)
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauPingRun(pCauDesc)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    long	stat;
+    CAU_PING	*pPing=pCauDesc->pPing;/* pointer to ping */
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    CAU_VALUE	value;		/* value to put */
+    TS_STAMP	now;		/* present time */
+    long	seq;		/* sequence number of put */
+    long	val;		/* value to put */
+    int		done;		/* 1 says all updates have arrived */
+
+    cauTmrCancel(&pCauDesc->pingHeap, &pPing->next);
+    pChan = pPing->pChan;
+    (void)epicsTimeGetCurrent(&now);
+    if (pPing->nSent >= pPing->count) {
+	CauChanLock(pChan);
+	done = pPing->nRecv >= pPing->nSent;
+	CauChanUnlock(pChan);
+	if (done || !epicsTimeLessThan(&now, &pPing->endTime)) {
+	    cauPingDone(pCauDesc);
+	    return;
+	}
+	pPing->next.time = now;
+	epicsTimeAddSeconds(&pPing->next.time, CAU_PING_CHECK);
+	(void)cauTmrArm(&pCauDesc->pingHeap, &pPing->next);
+	return;
+    }
+
+    seq = pPing->nSent;
+    val = CAU_PING_BASE + (pPing->modulus > 0 ? seq % pPing->modulus : seq);
+    if (pChan->connState != CAU_CONN_OK) {
+	cauPingDone(pCauDesc);
+	return;
+    }
+    if (pChan->dbfType == DBF_CHAR)
+	value.chr = (dbr_char_t)val;
+    else if (pChan->dbfType == DBF_SHORT)
+	value.shrt = (dbr_short_t)val;
+    else if (pChan->dbfType == DBF_LONG)
+	value.lng = (dbr_long_t)val;
+    else if (pChan->dbfType == DBF_FLOAT)
+	value.flt = (dbr_float_t)val;
+    else if (pChan->dbfType == DBF_DOUBLE)
+	value.dbl = (dbr_double_t)val;
+    else {
+	(void)fprintf(pPing->pCxCmd->dataOut,
+			"%s is no longer numeric; ping ended\n", pChan->name);
+	cauPingDone(pCauDesc);
+	return;
+    }
+    CauChanLock(pChan);
+    (void)epicsTimeGetCurrent(&pPing->pSendTime[seq]);
+    pPing->nSent++;
+    CauChanUnlock(pChan);
+    cauPutCharge(pCauDesc, pChan, &now);
+    if (cauPutSend(pChan, dbf_type_to_DBR(pChan->dbfType), &value) != 0) {
+	cauCaDebug("prior to ca_flush_io", 0);
+	stat = ca_flush_io();
+	cauCaDebugStat("back from ca_flush_io", stat, 0);
+    }
+    if (pPing->nSent >= pPing->count) {
+	pPing->endTime = now;
+	epicsTimeAddSeconds(&pPing->endTime, CAU_PING_TMO);
+	pPing->next.time = now;
+	epicsTimeAddSeconds(&pPing->next.time, CAU_PING_CHECK);
+    }
+    else {
+	epicsTimeAddSeconds(&pPing->next.time, pPing->period);
+	if (epicsTimeLessThan(&pPing->next.time, &now))
+	    pPing->next.time = now;
+    }
+    (void)cauTmrArm(&pCauDesc->pingHeap, &pPing->next);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPollChanDel - take a channel out of its poll group
+*
+* DESCRIPTION
+*	If the group has no channels left, it is deleted.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauPollChanDel(pCauDesc, pChan)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+{
+    CAU_POLL	*pPoll;		/* pointer to channel's poll group */
+    CAU_POLL	**ppPoll;	/* pointer to link to poll group */
+    int		i;
+
+    if ((pPoll = pChan->pPoll) == NULL)
+	return;
+    for (i=0; i<pPoll->nChan; i++) {
+	if (pPoll->ppChan[i] == pChan) {
+	    pPoll->nChan--;
+	    (void)memmove((char *)&pPoll->ppChan[i],
+		    (char *)&pPoll->ppChan[i+1],
+		    (pPoll->nChan - i) * sizeof(CAU_CHAN *));
+	    break;
+	}
+    }
+    pChan->pollPend = 0;
+    pChan->pPoll = NULL;
+    if (pPoll->nChan > 0)
+	return;
+    cauTmrCancel(&pCauDesc->pollHeap, &pPoll->next);
+    for (ppPoll=&pCauDesc->pPollHead; *ppPoll!=NULL; ppPoll=&(*ppPoll)->pNext){
+	if (*ppPoll == pPoll) {
+	    *ppPoll = pPoll->pNext;
+	    break;
+	}
+    }
+    if (pPoll->ppChan != NULL)
+	free((char *)pPoll->ppChan);
+    free((char *)pPoll);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPollDone - receive a polled value
+*
+* DESCRIPTION
+*	Handler for the ca_array_get_callback sent by cauPollRun.  The
+*	value is copied into the channel's buffer and printed.  An answer
+*	to any get but the channel's latest, or for a channel which has
+*	since been taken out of its poll group, is ignored.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauPollDone(arg)
+struct event_handler_args arg;
+{
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    size_t	size;		/* size of value */
+
+    pChan = (CAU_CHAN *)arg.usr;
+    if (++pChan->pollRecv != pChan->pollSent || !pChan->pollPend)
+	return;				/* answer to an abandoned get */
+    pChan->pollPend = 0;
+    if (arg.status != ECA_NORMAL || arg.dbr == NULL) {
+	(void)printf("error on poll of %s \n", pChan->name);
+	return;
+    }
+    if (arg.type != pChan->dbrType)
+	return;
+    size = dbr_size_n(arg.type, arg.count);
+    CauChanLock(pChan);
+    if (cauChanBufNeed(pglCauDesc, pChan, size) == OK) {
+	(void)memcpy((char *)pChan->pBuf, (char *)arg.dbr, size);
+	pChan->nEl = arg.count;
+	cauPrintBuf(pChan->pPoll->pCxCmd->dataOut, pChan, 1, 1, 0, 0, 0);
+    }
+    CauChanUnlock(pChan);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPollRun - run the poll groups whose deadlines have come
+*
+* DESCRIPTION
+*	For each poll group whose timer has come due, sends a get for each
+*	connected channel in the group.  A channel whose previous get is
+*	still outstanding is skipped (and counted), but the others are
+*	still sampled.  The group's next deadline is one period after
+*	this one; if cau has fallen behind by more than a period, the
+*	deadlines which have already passed are skipped and counted as
+*	missed.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauPollRun(pCauDesc)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    long	stat;
+    CAU_POLL	*pPoll;		/* pointer to poll group */
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    TS_STAMP	now;		/* present time */
+    double	late;		/* seconds past deadline */
+    long	nSkip;		/* deadlines skipped */
+    int		nSent=0;	/* gets sent */
+    int		i;
+
+    (void)epicsTimeGetCurrent(&now);
+    while (cauTmrDue(&pCauDesc->pollHeap, &now)) {
+	pPoll = (CAU_POLL *)pCauDesc->pollHeap.ppTmr[0]->pArg;
+	cauTmrCancel(&pCauDesc->pollHeap, &pPoll->next);
+	late = epicsTimeDiffInSeconds(&now, &pPoll->next.time);
+	pPoll->nCycle++;
+	pPoll->jitterSum += late;
+	if (late > pPoll->jitterMax)
+	    pPoll->jitterMax = late;
+	for (i=0; i<pPoll->nChan; i++) {
+	    pChan = pPoll->ppChan[i];
+	    if (pChan->connState != CAU_CONN_OK)
+		continue;
+	    if (pChan->pollPend) {
+		pPoll->nSkipped++;
+		continue;
+	    }
+	    stat = ca_array_get_callback(pChan->dbrType, pChan->reqCount,
+				pChan->pCh, cauPollDone, pChan);
+	    if (stat != ECA_NORMAL) {
+		(void)printf("error on poll of %s \n", pChan->name);
+		continue;
+	    }
+	    pChan->pollSent++;
+	    pChan->pollPend = 1;
+	    nSent++;
+	}
+	epicsTimeAddSeconds(&pPoll->next.time, pPoll->period);
+	if (late >= pPoll->period) {
+	    nSkip = (long)(late / pPoll->period);
+	    pPoll->nMissed += nSkip;
+	    epicsTimeAddSeconds(&pPoll->next.time, nSkip * pPoll->period);
+	}
+	(void)cauTmrArm(&pCauDesc->pollHeap, &pPoll->next);
+    }
+    if (nSent > 0) {
+	cauCaDebug("prior to ca_flush_io", 0);
+	stat = ca_flush_io();
+	cauCaDebugStat("back from ca_flush_io", stat, 0);
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPoolGet - get an item from a pool
+*
+* DESCRIPTION
+*	Takes an item from the pool's free list.  If the free list is
+*	empty, a new slab is obtained with malloc and carved into items.
+*
+* RETURNS
+*	pointer to item, or
+*	NULL
+*
+*-*/
+static void *
+cauPoolGet(pPool)
+CAU_POOL *pPool;	/* IO pointer to pool */
+{
+    CAU_POOL_SLAB *pSlab;	/* pointer to new slab */
+    CAU_POOL_ITEM *pItem;	/* pointer to item */
+    char	*pItems;	/* pointer to items in slab */
+    int		i;
+
+    if (pPool->pFreeHead == NULL) {
+	pSlab = (CAU_POOL_SLAB *)malloc(sizeof(CAU_POOL_SLAB) +
+				pPool->nPerSlab * pPool->itemSize);
+	if (pSlab == NULL)
+	    return NULL;
+	pSlab->pNext = pPool->pSlabHead;
+	pPool->pSlabHead = pSlab;
+	pPool->nSlab++;
+	pItems = (char *)(pSlab + 1);
+	for (i=pPool->nPerSlab-1; i>=0; i--) {
+	    pItem = (CAU_POOL_ITEM *)(pItems + i * pPool->itemSize);
+	    pItem->pNext = pPool->pFreeHead;
+	    pPool->pFreeHead = pItem;
+	}
+    }
+    pItem = pPool->pFreeHead;
+    pPool->pFreeHead = pItem->pNext;
+    pPool->nGet++;
+    if (++pPool->nUsed > pPool->nUsedMax)
+	pPool->nUsedMax = pPool->nUsed;
+    return (void *)pItem;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPoolInit - initialize a pool
+*
+* DESCRIPTION
+*	Sets up an empty pool for items of the specified size.  The size
+*	is rounded up to keep items aligned.  No memory is obtained until
+*	the first item is requested.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauPoolInit(pPool, itemSize)
+CAU_POOL *pPool;	/* O pointer to pool */
+size_t	itemSize;	/* I size of an item, in bytes */
+{
+    itemSize = (itemSize + sizeof(CAU_POOL_SLAB) - 1) &
+					~(sizeof(CAU_POOL_SLAB) - 1);
+    pPool->itemSize = itemSize;
+    pPool->nPerSlab = CAU_POOL_SLAB_SIZE / itemSize;
+    if (pPool->nPerSlab < 1)
+	pPool->nPerSlab = 1;
+    pPool->pSlabHead = NULL;
+    pPool->pFreeHead = NULL;
+    pPool->nSlab = 0;
+    pPool->nUsed = pPool->nUsedMax = 0;
+    pPool->nGet = 0;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPoolPut - give an item back to a pool
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauPoolPut(pPool, pItem)
+CAU_POOL *pPool;	/* IO pointer to pool */
+void	*pItem;		/* I pointer to item */
+{
+    ((CAU_POOL_ITEM *)pItem)->pNext = pPool->pFreeHead;
+    pPool->pFreeHead = (CAU_POOL_ITEM *)pItem;
+    pPool->nUsed--;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPoolRelease - free the memory held by a pool
+*
+* DESCRIPTION
+*	Frees all the pool's slabs.  Any items still in use become
+*	invalid.  The pool is left empty, ready for use again.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauPoolRelease(pPool)
+CAU_POOL *pPool;	/* IO pointer to pool */
+{
+    CAU_POOL_SLAB *pSlab;	/* pointer to slab */
+
+    while ((pSlab = pPool->pSlabHead) != NULL) {
+	pPool->pSlabHead = pSlab->pNext;
+	free((char *)pSlab);
+    }
+    pPool->pFreeHead = NULL;
+    pPool->nSlab = 0;
+    pPool->nUsed = 0;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPoolShow - print usage statistics for a pool
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauPoolShow(name, pPool)
+char	*name;		/* I name to print for pool */
+CAU_POOL *pPool;	/* I pointer to pool */
+{
+    (void)printf("%-12s %8lu %8ld %8ld %8ld %10lu\n", name,
+		(unsigned long)pPool->itemSize, pPool->nSlab, pPool->nUsed,
+		pPool->nUsedMax, pPool->nGet);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPrintBuf - print a channel's present value
+*
+* DESCRIPTION
+*	Print buffer type, channel name, time stamp, and value.
+*
+*	If the channel's graphics information hasn't arrived, FLOAT and
+*	DOUBLE values are printed with %g and ENUM values as numbers.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauPrintBuf(out, pChan, prName, prTime, prDBRType, prENUMAsShort, prEGU)
+FILE	*out;		/* I stream for printing */
+CAU_CHAN *pChan;	/* I pointer to channel descriptor */
+int	prName;		/* I 1 if channel name is to be printed */
+int	prTime;		/* I 1 if time is to be printed */
+int	prDBRType;	/* I 1 if DBR_type of channel is to be printed */
+int	prENUMAsShort;	/* I 1 if DBR_ENUM values are to print as short */
+int	prEGU;		/* I 1 if EGU is to be printed */
+{
+    char	stampText[28];
+    int		state;		/* state for ENUM's */
+    void	*pVal;		/* pointer to value field */
+    union db_access_val *pGR;	/* pointer to graphics info, or NULL */
+
+    pGR = CauChanGR(pChan);
+    if (prDBRType)
+      (void)fprintf(out,"%-10s ",dbr_type_to_text(pChan->dbrType));
+    if (prName)
+	(void)fprintf(out, "%20s", pChan->name);
+    if (!prTime)
+	;
+    else if (dbr_type_is_TIME(pChan->dbrType)) {
+        (void)epicsTimeToStrftime(stampText,28,"%m-%d-%y %H:%M:%S.%09f"
+                                                ,&pChan->pBuf->tstrval.stamp);
+	(void)fprintf(out, " %s", &stampText[9]);
+    }
+    else {
+	(void)fprintf(out, " buffer not of type DBR_TIME_xxx\n");
+	return;
+    }
+
+    if (pChan->reqCount != 1) {
+	cauPrintBufArray(out, pChan);
+	return;
+    }
+    pVal = dbr_value_ptr(pChan->pBuf, pChan->dbrType);
+    if (pVal == NULL)
+	(void)fprintf(out,"invalid buffer type: %ld", pChan->dbrType);
+    else if (dbr_type_is_STRING(pChan->dbrType))
+	(void)fprintf(out, " %12s", (char *)pVal);
+    else if (dbr_type_is_SHORT(pChan->dbrType))
+	(void)fprintf(out, " %12d", *(short *)pVal);
+    else if (dbr_type_is_LONG(pChan->dbrType))
+	(void)fprintf(out, " %12d", *(int *)pVal);
+    else if (dbr_type_is_CHAR(pChan->dbrType))
+	(void)fprintf(out, " %12d", *(unsigned char *)pVal);
+    else if (dbr_type_is_ENUM(pChan->dbrType)) {
+	state = *(short *)pVal;
+	if (pChan->dbfType != DBF_ENUM || prENUMAsShort || pGR == NULL)
+	    (void)fprintf(out, " %12d", state);
+	else if (state < 0 || state >= pGR->genmval.no_str)
+	    (void)fprintf(out, " %12d (illegal)", state);
+	else
+	    (void)fprintf(out, " %12s", pGR->genmval.strs[state]);
+    }
+    else if (dbr_type_is_FLOAT(pChan->dbrType)) {
+	if (pGR == NULL)
+	    (void)fprintf(out, " %12g", *(float *)pVal);
+	else {
+	    (void)fprintf(out, " %12.*f",
+				pGR->gfltval.precision, *(float *)pVal);
+	}
+    }
+    else if (dbr_type_is_DOUBLE(pChan->dbrType)) {
+	if (pGR == NULL)
+	    (void)fprintf(out, " %12g", *(double *)pVal);
+	else {
+	    (void)fprintf(out, " %12.*f",
+				pGR->gdblval.precision, *(double *)pVal);
+	}
+    }
+    if (pChan->units != NULL && prEGU)
+	(void)fprintf(out, " %s", pChan->units);
+    (void)fprintf(out, "\n");
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPrintBufArray - print an array channel's present value
+*
+* DESCRIPTION
+*	Print values for an array channel, in compressed form
+*
+* RETURNS
+*	void
+*
+*-*/
+static  void cauPrintBufArray(out, pChan)
+FILE	*out;
+CAU_CHAN *pChan;
+{
+    long	nEl, i;
+    int		nBytes, prec;
+    char	*pSrc;
+    char	text[7];
+    chtype	dbrType=pChan->dbrType;
+    union db_access_val *pGR=CauChanGR(pChan);
+
+    (void)fprintf(out, "\n");
+    nEl = pChan->nEl;
+    nBytes = dbr_value_size[dbrType];
+    pSrc = (char *)dbr_value_ptr(pChan->pBuf, dbrType);
+
+    if      (pGR == NULL)                prec = 3;
+    else if (dbr_type_is_FLOAT(dbrType)) prec = pGR->gfltval.precision;
+    else if (dbr_type_is_SHORT(dbrType)) prec = 0;
+    else if (dbr_type_is_DOUBLE(dbrType))prec = pGR->gdblval.precision;
+    else if (dbr_type_is_LONG(dbrType))  prec = 0;
+    else if (dbr_type_is_CHAR(dbrType))  prec = 0;
+    else if (dbr_type_is_ENUM(dbrType))  prec = 0;
+    else 				 prec = 0;
+
+    for (i=0; i<nEl; i++) {
+	if (i % 10 == 0)
+	    (void)fprintf(out, "%05ld", i);
+        if      (dbr_type_is_FLOAT(dbrType))
+	    cvtDblToTxt(text, 6, (double)*(float *)pSrc, prec);
+        else if (dbr_type_is_SHORT(dbrType))
+	    cvtLngToTxt(text, 6, (long)*(short *)pSrc);
+        else if (dbr_type_is_DOUBLE(dbrType))
+	    cvtDblToTxt(text, 6, *(double *)pSrc, prec);
+        else if (dbr_type_is_LONG(dbrType))
+	    cvtLngToTxt(text, 6, *(long *)pSrc);
+        else if (dbr_type_is_CHAR(dbrType))
+	    cvtLngToTxt(text, 6, (long)*(unsigned char *)pSrc);
+        else if (dbr_type_is_ENUM(dbrType))
+	    cvtLngToTxt(text, 6, (long)*(short *)pSrc);
+	(void)fprintf(out, " %6s", text);
+	if ((i+1) % 10 == 0 || i+1 >= nEl)
+	    (void)fprintf(out, "\n");
+	pSrc += nBytes;
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPrintInfo - print some information about a channel
+*
+* DESCRIPTION
+*	Prints channel name, native type and count, and indicates whether
+*	the two buffers (DBR_CTRL_xxx and DBR_TIME_xxx) have received
+*	values from the IOC.  For a channel with signal generation, the
+*	number of steps and how late they have been is also printed.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauPrintInfo(pCxCmd, pChan)
+CX_CMD	*pCxCmd;	/* I pointer to command context */
+CAU_CHAN *pChan;	/* I pointer to channel descriptor */
+{
+    CAU_SIGGEN	*pSg;		/* pointer to signal generation state */
+
+    (void)fprintf(pCxCmd->dataOut, "%20s", pChan->name);
+    if (dbf_type_is_valid(pChan->dbfType))
+	(void)fprintf(pCxCmd->dataOut,
+			" %16s", dbf_type_to_text(pChan->dbfType));
+    else
+	(void)fprintf(pCxCmd->dataOut, "dbfType=%8ld", pChan->dbfType);
+    (void)fprintf(pCxCmd->dataOut, " elCount=%5lu", pChan->elCount);
+
+    CauChanLock(pChan);
+    if (pChan->pBuf->tstrval.status == -2)
+	(void)fprintf(pCxCmd->dataOut, "\nno value has been received");
+    else
+	cauPrintBuf(pCxCmd->dataOut, pChan, 0, 0, 0, 0, 1);
+#ifdef CAU_SHARDS
+    if (pChan->nShardDrop > 0)
+	(void)fprintf(pCxCmd->dataOut,
+		"\n%lu updates dropped by shard (buffer too small)",
+		pChan->nShardDrop);
+#endif
+    CauChanUnlock(pChan);
+
+    if (cauChanGRNeeded(pChan, CAU_GR_NEED_ALL) && CauChanGR(pChan) == NULL)
+	(void)fprintf(pCxCmd->dataOut,
+			"\nno DBR_CTRL_... information has been received");
+
+    if ((pSg = pChan->pSigGen) != NULL && pSg->stepCount > 0) {
+	(void)fprintf(pCxCmd->dataOut,
+		"\n%ld steps, late by %.6f (last) %.6f (avg) %.6f (max) sec",
+		pSg->stepCount, pSg->stepErrLast,
+		pSg->stepErrSum / pSg->stepCount, pSg->stepErrMax);
+	if (pSg->stepSkipCount > 0)
+	    (void)fprintf(pCxCmd->dataOut,
+		", %ld steps skipped", pSg->stepSkipCount);
+    }
+
+    (void)fprintf(pCxCmd->dataOut, "\n");
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPutChanDel - forget a channel's uncompleted puts
+*
+* DESCRIPTION
+*	Called when a channel is deleted; Channel Access won't call
+*	cauPutDone for the channel's puts after that.  A put which is
+*	being held by putRate is discarded.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauPutChanDel(pCauDesc, pChan)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* I pointer to channel descriptor */
+{
+    CAU_PUT	*pPut;		/* pointer to put */
+    CAU_PUT	*pPutNext;	/* pointer to next put */
+
+    for (pPut=pCauDesc->pPutHead; pPut!=NULL; pPut=pPutNext) {
+	pPutNext = pPut->pNext;
+	if (pPut->pChan != pChan)
+	    continue;
+	DoubleListRemove(pPut, pCauDesc->pPutHead, pCauDesc->pPutTail);
+	cauPoolPut(&pCauDesc->putPool, pPut);
+	pCauDesc->nPutOut--;
+    }
+    cauTmrCancel(&pCauDesc->putHeap, &pChan->putHeld);
+    if (pChan->pPutValue != NULL) {
+	cauBufPut(pCauDesc, pChan->pPutValue, sizeof(CAU_VALUE));
+	pChan->pPutValue = NULL;
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPutCharge - account for a put sent to a channel
+*
+* DESCRIPTION
+*	Called for each put which is sent, and counts it, whether or not
+*	putRate is limiting.  If putRate is limiting, moves
+*	the earliest time for the next put, for the channel and for
+*	its IOC host, on by one interval.  (The interval is added to the
+*	later of the present time and the earliest time, so that puts
+*	which weren't held, such as array puts, still use up the rate.)
+*	If a value is being held for the channel, it is now out of date,
+*	so it is discarded and counted as coalesced.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauPutCharge(pCauDesc, pChan, pNow)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+TS_STAMP *pNow;		/* I present time */
+{
+    CAU_HOST	*pHost;		/* pointer to channel's host */
+
+    if (pChan->putHeld.heapIx >= 0) {
+	cauTmrCancel(&pCauDesc->putHeap, &pChan->putHeld);
+	pChan->nPutCoalesced++;
+	pCauDesc->nPutCoalesced++;
+	if (pChan->pPutHost != NULL)
+	    pChan->pPutHost->nPutCoalesced++;
+    }
+    pCauDesc->nPutSent++;
+    if (pCauDesc->putChanRate <= 0. && pCauDesc->putHostRate <= 0.)
+	return;
+    if (epicsTimeLessThan(&pChan->putNext, pNow))
+	pChan->putNext = *pNow;
+    if (pCauDesc->putChanRate > 0.)
+	epicsTimeAddSeconds(&pChan->putNext, 1. / pCauDesc->putChanRate);
+    if ((pHost = cauPutHost(pCauDesc, pChan)) == NULL)
+	return;
+    if (epicsTimeLessThan(&pHost->putNext, pNow))
+	pHost->putNext = *pNow;
+    if (pCauDesc->putHostRate > 0.)
+	epicsTimeAddSeconds(&pHost->putNext, 1. / pCauDesc->putHostRate);
+    pHost->nPutSent++;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPutConvert - convert a value for putting to a channel
+*
+* DESCRIPTION
+*	Converts the text into the channel's native type, so that the IOC
+*	doesn't have to, and so that bad values are caught here:
+*	o  numbers must be entirely numeric and fit the native type; if
+*	   the channel has control limits (lower less than upper), the
+*	   value must be within them
+*	o  for CHAR, SHORT, and LONG channels, the number must be a whole
+*	   number; it isn't rounded or truncated
+*	o  for ENUM channels, the value must be one of the state strings
+*	   (found through the channel's enum hash), or a state number; if
+*	   it isn't, the legal strings are printed
+*	o  STRING values must fit in a DBR_STRING
+*
+*	The control limits and state strings come from the channel's
+*	graphics information, which is fetched if necessary.
+*
+* RETURNS
+*	OK, or
+*	ERROR if the value can't be put
+*
+*-*/
+static long
+cauPutConvert(pCauDesc, pChan, pText, pValue, pType)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+char	*pText;		/* I value to put, as text */
+CAU_VALUE *pValue;	/* O value, as native type */
+chtype	*pType;		/* O DBR_xxx type for put */
+{
+    union db_access_val *pGR;	/* pointer to graphics info, or NULL */
+    char	*pEnd;		/* end of converted number */
+    double	dbl=0.;		/* value, as double */
+    double	lo, hi;		/* control limits */
+    double	min, max;	/* range of native type */
+    int		i;
+
+    *pType = dbf_type_to_DBR(pChan->dbfType);
+    if (pChan->dbfType == DBF_STRING) {
+	if (strlen(pText) >= sizeof(pValue->str)) {
+	    (void)printf("value too long for %s\n", pChan->name);
+	    return ERROR;
+	}
+	(void)strcpy(pValue->str, pText);
+	return OK;
+    }
+    pGR = cauChanGRFetch(pCauDesc, pChan, CAU_GR_NEED_ALL);
+    if (pChan->dbfType == DBF_ENUM) {
+	if (pGR == NULL) {
+	    (void)printf("can't do put--no graphics info for channel\n");
+	    return ERROR;
+	}
+	if ((i = cauChanEnumLookup(pChan, pText)) < 0) {
+	    i = (int)strtol(pText, &pEnd, 10);
+	    if (pEnd == pText || *pEnd != '\0' ||
+					i < 0 || i >= pGR->genmval.no_str)
+		i = -1;
+	}
+	if (i >= 0) {
+	    pValue->enm = i;
+	    return OK;
+	}
+	(void)printf("bad state string; legal state strings are:\n");
+	for (i=0; i<pGR->genmval.no_str; i++)
+	    (void)printf("\"%s\"  ", pGR->genmval.strs[i]);
+	(void)printf("\n");
+	(void)printf(
+"(It is necessary to use \" only if string contains blanks.)\n");
+	return ERROR;
+    }
+
+    dbl = strtod(pText, &pEnd);
+    if (pEnd == pText || *pEnd != '\0') {
+	(void)printf("%s isn't a number\n", pText);
+	return ERROR;
+    }
+    cauPutRange(pChan, pGR, &min, &max, &lo, &hi);
+    if (dbl < min || dbl > max) {
+	(void)printf("%s is out of range for %s\n", pText, pChan->name);
+	return ERROR;
+    }
+    if (pChan->dbfType != DBF_FLOAT && pChan->dbfType != DBF_DOUBLE &&
+							dbl != floor(dbl)) {
+	(void)printf("%s isn't a whole number, as %s needs\n",
+							pText, pChan->name);
+	return ERROR;
+    }
+    if (lo < hi && (dbl < lo || dbl > hi)) {
+	(void)printf("%s is outside the control limits (%g to %g) for %s\n",
+						pText, lo, hi, pChan->name);
+	return ERROR;
+    }
+    if (pChan->dbfType == DBF_CHAR)
+	pValue->chr = (dbr_char_t)(int)dbl;
+    else if (pChan->dbfType == DBF_SHORT)
+	pValue->shrt = (dbr_short_t)dbl;
+    else if (pChan->dbfType == DBF_LONG)
+	pValue->lng = (dbr_long_t)dbl;
+    else if (pChan->dbfType == DBF_FLOAT)
+	pValue->flt = (dbr_float_t)dbl;
+    else
+	pValue->dbl = dbl;
+    return OK;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPutDone - receive the completion of a put
+*
+* DESCRIPTION
+*	Handler for ca_put_callback.  Prints the channel name and the
+*	time from sending the put to its completion, and adds the time to
+*	the put statistics.  When the last outstanding put completes, a
+*	summary is printed.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauPutDone(arg)
+struct event_handler_args arg;
+{
+    CAU_DESC	*pCauDesc=pglCauDesc;
+    CAU_PUT	*pPut;		/* pointer to put */
+    TS_STAMP	now;		/* present time */
+    double	latency;	/* seconds from send to completion */
+    FILE	*out;		/* stream for printing */
+
+    pPut = (CAU_PUT *)arg.usr;
+    out = pPut->pCxCmd->dataOut;
+    (void)epicsTimeGetCurrent(&now);
+    latency = epicsTimeDiffInSeconds(&now, &pPut->sendTime);
+    if (arg.status != ECA_NORMAL) {
+	(void)fprintf(out, "%20s put failed after %.3f ms: %s\n",
+		pPut->pChan->name, 1000. * latency, ca_message(arg.status));
+    }
+    else {
+	(void)fprintf(out, "%20s put done in %.3f ms\n",
+		pPut->pChan->name, 1000. * latency);
+	pCauDesc->nPutDone++;
+	pCauDesc->putLatSum += latency;
+	if (latency > pCauDesc->putLatMax)
+	    pCauDesc->putLatMax = latency;
+    }
+    DoubleListRemove(pPut, pCauDesc->pPutHead, pCauDesc->pPutTail);
+    cauPoolPut(&pCauDesc->putPool, pPut);
+    if (--pCauDesc->nPutOut == 0 && pCauDesc->nPutDone > 0) {
+	(void)fprintf(out,
+		"all puts done; %ld done, latency avg %.3f max %.3f ms\n",
+		pCauDesc->nPutDone,
+		1000. * pCauDesc->putLatSum / pCauDesc->nPutDone,
+		1000. * pCauDesc->putLatMax);
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPutHost - find the IOC host which a channel's puts are charged to
+*
+* DESCRIPTION
+*	If putHostRate is limiting, the host is looked up the first time
+*	it is needed while the channel is connected, and again after a
+*	disconnect.  Every put which is sent--held, array, callback, or
+*	ping--is charged to the host found here, so that they all share
+*	the host's rate.
+*
+* RETURNS
+*	CAU_HOST * for host, or
+*	NULL if the host hasn't been (or can't be) looked up
+*
+*-*/
+static CAU_HOST *
+cauPutHost(pCauDesc, pChan)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+{
+    if (pChan->pPutHost == NULL && pCauDesc->putHostRate > 0. &&
+				pChan->connState == CAU_CONN_OK)
+	pChan->pPutHost = cauHostFind(pCauDesc, ca_host_name(pChan->pCh));
+    return pChan->pPutHost;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPutLimit - put a value, subject to putRate
+*
+* DESCRIPTION
+*	With no putRate limit, the value is sent at once.  Otherwise, it
+*	is sent at once only if the channel, and its IOC host, are due
+*	for another put (see cauPutWhen); if they aren't, the value is
+*	held in the channel until cauPutRelease sends it.  A value which
+*	arrives while another is being held replaces it (the last value
+*	wins), and the replaced value is counted as coalesced.  So each
+*	channel sends no more than putChanRate puts per second, however
+*	fast values are produced, and the last value is never lost.
+*
+*	The caller flushes.
+*
+* RETURNS
+*	1 if a ca_put was sent, or
+*	0 if the value is being held, or the put failed
+*
+*-*/
+static long
+cauPutLimit(pCauDesc, pChan, type, pValue)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+chtype	type;		/* I DBR_xxx type of value */
+void	*pValue;	/* I pointer to a single value */
+{
+    TS_STAMP	now;		/* present time */
+
+    if (pCauDesc->putChanRate <= 0. && pCauDesc->putHostRate <= 0.) {
+	(void)epicsTimeGetCurrent(&now);
+	cauPutCharge(pCauDesc, pChan, &now);	/* counts, drops held put */
+	return cauPutSend(pChan, type, pValue);
+    }
+    if (pChan->putHeld.heapIx >= 0) {
+	(void)memcpy((char *)pChan->pPutValue, pValue, dbr_value_size[type]);
+	pChan->putType = type;
+	pChan->nPutCoalesced++;
+	pCauDesc->nPutCoalesced++;
+	if (pChan->pPutHost != NULL)
+	    pChan->pPutHost->nPutCoalesced++;
+	return 0;
+    }
+    (void)epicsTimeGetCurrent(&now);
+    cauPutWhen(pCauDesc, pChan, &pChan->putHeld.time);
+    if (epicsTimeLessThanEqual(&pChan->putHeld.time, &now)) {
+	cauPutCharge(pCauDesc, pChan, &now);
+	return cauPutSend(pChan, type, pValue);
+    }
+    if (pChan->pPutValue == NULL) {
+	pChan->pPutValue =
+		(CAU_VALUE *)cauBufGet(pCauDesc, sizeof(CAU_VALUE));
+	if (pChan->pPutValue == NULL) {
+	    (void)printf("malloc error\n");
+	    return 0;
+	}
+    }
+    (void)memcpy((char *)pChan->pPutValue, pValue, dbr_value_size[type]);
+    pChan->putType = type;
+    (void)cauTmrArm(&pCauDesc->putHeap, &pChan->putHeld);
+    return 0;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPutRange - get the legal range of values for a channel
+*
+* DESCRIPTION
+*	Gets the range of the channel's native (numeric) type and, if
+*	graphics information is available, its control limits.  The
+*	control limits are only to be checked if lo is less than hi.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauPutRange(pChan, pGR, pMin, pMax, pLo, pHi)
+CAU_CHAN *pChan;	/* I pointer to channel descriptor */
+union db_access_val *pGR;/* I pointer to DBR_CTRL_xxx info, or NULL */
+double	*pMin, *pMax;	/* O range of native type */
+double	*pLo, *pHi;	/* O control limits */
+{
+    *pLo = *pHi = 0.;
+    if (pChan->dbfType == DBF_CHAR) {
+	*pMin = -128.; *pMax = 255.;
+	if (pGR != NULL) {
+	    *pLo = pGR->cchrval.lower_ctrl_limit;
+	    *pHi = pGR->cchrval.upper_ctrl_limit;
+	}
+    }
+    else if (pChan->dbfType == DBF_SHORT) {
+	*pMin = -32768.; *pMax = 32767.;
+	if (pGR != NULL) {
+	    *pLo = pGR->cshrtval.lower_ctrl_limit;
+	    *pHi = pGR->cshrtval.upper_ctrl_limit;
+	}
+    }
+    else if (pChan->dbfType == DBF_ENUM) {
+	*pMin = 0.; *pMax = 65535.;
+    }
+    else if (pChan->dbfType == DBF_LONG) {
+	*pMin = -2147483648.; *pMax = 2147483647.;
+	if (pGR != NULL) {
+	    *pLo = pGR->clngval.lower_ctrl_limit;
+	    *pHi = pGR->clngval.upper_ctrl_limit;
+	}
+    }
+    else if (pChan->dbfType == DBF_FLOAT) {
+	*pMin = -FLT_MAX; *pMax = FLT_MAX;
+	if (pGR != NULL) {
+	    *pLo = pGR->cfltval.lower_ctrl_limit;
+	    *pHi = pGR->cfltval.upper_ctrl_limit;
+	}
+    }
+    else {
+	*pMin = -DBL_MAX; *pMax = DBL_MAX;
+	if (pGR != NULL) {
+	    *pLo = pGR->cdblval.lower_ctrl_limit;
+	    *pHi = pGR->cdblval.upper_ctrl_limit;
+	}
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPutRelease - send the held puts which have come due
+*
+* DESCRIPTION
+*	Called from cauTask when the earliest held put is due.  Each
+*	channel whose time has come is checked again, since another
+*	channel on the same host may have used the host's turn; if so,
+*	it waits for the host's next turn.  (cauChanConnDown drops a
+*	channel's held put when the channel disconnects; the check for a
+*	disconnected channel here is only a safeguard.)
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauPutRelease(pCauDesc)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    long	stat;
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    TS_STAMP	now;		/* present time */
+    int		count=0;	/* number of puts sent */
+
+    (void)epicsTimeGetCurrent(&now);
+    while (cauTmrDue(&pCauDesc->putHeap, &now)) {
+	pChan = (CAU_CHAN *)pCauDesc->putHeap.ppTmr[0]->pArg;
+	cauTmrCancel(&pCauDesc->putHeap, &pChan->putHeld);
+	if (pChan->connState != CAU_CONN_OK) {
+	    pCauDesc->nPutDropped++;
+	    continue;
+	}
+	cauPutWhen(pCauDesc, pChan, &pChan->putHeld.time);
+	if (epicsTimeLessThan(&now, &pChan->putHeld.time)) {
+	    (void)cauTmrArm(&pCauDesc->putHeap, &pChan->putHeld);
+	    continue;
+	}
+	cauPutCharge(pCauDesc, pChan, &now);
+	count += cauPutSend(pChan, pChan->putType, (void *)pChan->pPutValue);
+    }
+    if (count) {
+	cauCaDebug("prior to ca_flush_io", 0);
+	stat = ca_flush_io();
+	cauCaDebugStat("back from ca_flush_io", stat, 0);
+    }
+}
+
 /*+/subr**********************************************************************
-* NAME	cauMonitor - receive monitor buffer from Channel Access
+* NAME	cauPutSend - send a single value with ca_put
+*
+* RETURNS
+*	1 if the put was sent, or
+*	0 if it failed
+*
+*-*/
+static long
+cauPutSend(pChan, type, pValue)
+CAU_CHAN *pChan;	/* I pointer to channel descriptor */
+chtype	type;		/* I DBR_xxx type of value */
+void	*pValue;	/* I pointer to value */
+{
+    long	stat;
+
+    cauCaDebugDbrAndName("prior to ca_put", type, pChan->name, 0);
+    stat = ca_put(type, pChan->pCh, pValue);
+    cauCaDebugStat("back from ca_put", stat, 0);
+    if (stat != ECA_NORMAL) {
+	(void)printf("error on ca_put for %s\n", pChan->name);
+	return 0;
+    }
+    return 1;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPutStart - send a put with completion callback
 *
 * DESCRIPTION
-*	Copies the value into the channel's buffer and prints the value.
+*	Sends the value (already converted to the channel's native type)
+*	with ca_array_put_callback, with cauPutDone as the handler, and
+*	adds the put to the list of puts waiting for completion.  The
+*	caller flushes.
 *
-*	For channels with interval checking enabled (as indicated by a
-*	non-zero .interval item), the interval checking is done.  The
-*	value is printed only for the initial value and for violations
-*	of the interval criteria.
+* RETURNS
+*	OK, or
+*	ERROR
+*
+*-*/
+static long
+cauPutStart(pCxCmd, pCauDesc, pChan, type, count, pValue)
+CX_CMD	*pCxCmd;	/* I pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* I pointer to channel descriptor */
+chtype	type;		/* I DBR_xxx type of value */
+unsigned long count;	/* I number of elements to put */
+void	*pValue;	/* I value to put */
+{
+    long	stat;
+    CAU_PUT	*pPut;		/* pointer to put */
+
+    if ((pPut = (CAU_PUT *)cauPoolGet(&pCauDesc->putPool)) == NULL) {
+	(void)printf("malloc error\n");
+	return ERROR;
+    }
+    pPut->pChan = pChan;
+    pPut->pCxCmd = pCxCmd->pCxCmdRoot;
+    (void)epicsTimeGetCurrent(&pPut->sendTime);
+    cauCaDebugDbrAndName("prior to ca_array_put_callback",
+						type, pChan->name, 0);
+    stat = ca_array_put_callback(type, count, pChan->pCh, pValue,
+							cauPutDone, pPut);
+    cauCaDebugStat("back from ca_array_put_callback", stat, 0);
+    if (stat != ECA_NORMAL) {
+	(void)printf("error on ca_put_callback for %s\n", pChan->name);
+	cauPoolPut(&pCauDesc->putPool, pPut);
+	return ERROR;
+    }
+    DoubleListAppend(pPut, pCauDesc->pPutHead, pCauDesc->pPutTail);
+    pCauDesc->nPutOut++;
+    return OK;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauPutWhen - find when a channel may next be put
+*
+* DESCRIPTION
+*	The time is the later of the channel's own earliest time and,
+*	if putHostRate is limiting, its IOC host's.
 *
 * RETURNS
 *	void
 *
-* BUGS
-* o	assumes that type and count match the buffer
-* o	only prints first element for array channels
+*-*/
+static void
+cauPutWhen(pCauDesc, pChan, pWhen)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+TS_STAMP *pWhen;	/* O earliest time for next put */
+{
+    CAU_HOST	*pHost;		/* pointer to channel's host */
+
+    *pWhen = pChan->putNext;
+    if (pCauDesc->putHostRate <= 0.)
+	return;
+    if ((pHost = cauPutHost(pCauDesc, pChan)) != NULL &&
+			epicsTimeLessThan(pWhen, &pHost->putNext))
+	*pWhen = pHost->putNext;
+}
+
+#ifdef CAU_SHARDS
+/*+/subr**********************************************************************
+* NAME	cauShardBufNeed - make sure a shard channel's buffers are big enough
 *
-* NOTES
-* 1.	If debug level is 2 or more, then a time stamped message is
-*	printed when this routine is entered, and another is printed
-*	when it exits.
+* DESCRIPTION
+*	Grows the channel's monitor buffer (keeping its value) and its
+*	back buffer to at least the size needed.  Runs in cauTask, which
+*	owns the buffer pools; if a shard is using the channel, the caller
+*	must hold the shard's lock.
+*
+* RETURNS
+*	OK, or
+*	ERROR
+*
+*-*/
+static long
+cauShardBufNeed(pCauDesc, pChan, nBytes)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
+size_t	nBytes;		/* I size needed, in bytes */
+{
+    union db_access_val *pBufBack;	/* pointer to new back buffer */
+
+    if (cauChanBufNeed(pCauDesc, pChan, nBytes) != OK)
+	return ERROR;
+    if (pChan->pBufBack != NULL && pChan->bufBackSize >= pChan->bufSize)
+	return OK;
+    pBufBack = (union db_access_val *)cauBufGet(pCauDesc, pChan->bufSize);
+    if (pBufBack == NULL) {
+	(void)printf("malloc error\n");
+	return ERROR;
+    }
+    cauBufPut(pCauDesc, pChan->pBufBack, pChan->bufBackSize);
+    pChan->pBufBack = pBufBack;
+    pChan->bufBackSize = pChan->bufSize;
+    return OK;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauShardConn - connection handler for a shard's channels
+*
+* DESCRIPTION
+*	Runs in one of the shard's Channel Access threads.  When the
+*	shard's connection to a channel is first made, a monitor is placed
+*	on the channel.  (The monitor survives later disconnects and
+*	reconnects, so nothing else needs to be done.)  The type and count
+*	are taken with the shard's lock, since cauTask may be changing
+*	them for a get.
+*
+* RETURNS
+*	void
 *
 *-*/
 static void
-cauMonitor(arg)
-struct event_handler_args arg;
+cauShardConn(arg)
+struct connection_handler_args arg;
 {
-    CAU_CHAN	*pCauChan;	/* pointer to channel descriptor */
-    int		nBytes;		/* total size of `value' buffer */
-    double	interval;	/* difference between present and prev stamp */
-    char 	priorStampText[28];/* time stamp of prior value */
-    double	diff;		/* diff between actual and desired intervals */
-    int		printFlag=1;
-    CX_CMD	*pCxCmd;	/* pointer to command context */
-    char	message[80];
-    char	nowText[28];
-    char	chanTsText[28];
+    long	stat;
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    chtype	dbrType;	/* DBR_xxx type for monitor */
+    unsigned long reqCount;	/* number of elements for monitor */
 
-    pCauChan = (CAU_CHAN *)arg.usr;
-    pCxCmd = pCauChan->pCxCmd;
+    pChan = (CAU_CHAN *)ca_puser(arg.chid);
+    if (arg.op != CA_OP_CONN_UP || pChan->pShardEv != NULL)
+	return;
+    CauChanLock(pChan);
+    dbrType = pChan->dbrType;
+    reqCount = pChan->reqCount;
+    CauChanUnlock(pChan);
+    cauCaDebugDbrAndName("shard, prior to ca_add_masked_array_event",
+						dbrType, pChan->name, 0);
+    stat = ca_add_masked_array_event(dbrType,
+		reqCount, arg.chid, cauMonitor, pChan,
+		0., 0., 0., &pChan->pShardEv, glCauDeadband);
+    cauCaDebugStat("back from ca_add_array_event", stat, 0);
+    if (stat != ECA_NORMAL) {
+	(void)printf("ca_add_event error: %s \n", pChan->name);
+	pChan->pShardEv = NULL;
+    }
+    (void)ca_flush_io();
+}
 
-    (void)epicsTimeGetCurrent(&pCauChan->lastMonTime);
-    if (pCauChan->lastMonErr != 0) {
-        (void)epicsTimeToStrftime(nowText,28,"%m-%d-%y %H:%M:%S.%09f",&pCauChan->lastMonTime);
-        (void)epicsTimeToStrftime(chanTsText,28,"%m-%d-%y %H:%M:%S.%09f",
-                                                &((struct dbr_time_string *)arg.dbr)->stamp);
-	(void)fprintf(pCxCmd->dataOut,
-	    "resume for %s at %s (local) or %s (ioc)\n", pCauChan->name, nowText,chanTsText);
-	if (pCxCmd->dataOut != stdout) {
-	    epicsTimeToStrftime(nowText,28,"%m-%d-%y %H:%M:%S.%09f",&pCauChan->lastMonTime);
-	    epicsTimeToStrftime(chanTsText,28,"%m-%d-%y %H:%M:%S.%09f",
-                                                &((struct dbr_time_string *)arg.dbr)->stamp);
-	    (void)fprintf(pCxCmd->dataOut,
-		"resume for %s at %s (local) or %s (ioc)\n", pCauChan->name, nowText,chanTsText);
+/*+/subr**********************************************************************
+* NAME	cauShardGrow - grow the buffers which shards have asked for
+*
+* DESCRIPTION
+*	Called from cauTask.  For each shard with channels waiting, grows
+*	the buffers of each channel whose bufBackNeed is set, with the
+*	shard's lock, and clears the request.  A channel whose back
+*	buffer is being copied into is left for the next call.  If the
+*	buffers can't be grown, the request is cleared anyway; the next
+*	update which is too big asks again.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauShardGrow(pCauDesc)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    CAU_SHARD	*pShard;	/* pointer to shard */
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    int		i;
+
+    for (i=0; i<pCauDesc->nShard; i++) {
+	pShard = &pCauDesc->pShard[i];
+	epicsMutexMustLock(pShard->lock);
+	for (pChan=pShard->pChanHead; pChan!=NULL && pShard->nGrow>0;
+						pChan=pChan->pShardNext) {
+	    if (pChan->bufBackNeed == 0 || pChan->bufBackBusy)
+		continue;			/* if busy, try next time */
+	    (void)cauShardBufNeed(pCauDesc, pChan, pChan->bufBackNeed);
+	    pChan->bufBackNeed = 0;
+	    pShard->nGrow--;
 	}
-	pCauChan->lastMonErr = 0;
-    }
-    if (glCauDebug > 1) {
-	nBytes = dbr_size_n(arg.type, arg.count);
-	(void)sprintf(message, "enter cauMonitor() for %s %s %d",
-		pCauChan->name, dbr_type_to_text(arg.type), nBytes);
-	cauCaDebug(message, 1);
+	epicsMutexUnlock(pShard->lock);
     }
-    if (pCauChan->interval > 0. && pCauChan->pBuf->tstrval.status != -2) {
+}
 
-	interval = epicsTimeDiffInSeconds (&((struct dbr_time_string *)arg.dbr)->stamp,
-                                                &pCauChan->pBuf->tstrval.stamp);
-	diff = pCauChan->interval - interval;
-	if (diff < 0.)
-	    diff = -diff;
-	if (diff > pCauChan->jitter) {
-	    (void)epicsTimeToStrftime(priorStampText,28,"%m-%d-%y %H:%M:%S.%09f",
-                                &pCauChan->pBuf->tstrval.stamp);
-	    (void)fprintf(pCxCmd->dataOut,
-		    "interval from prior (at %s) to following is %.3f\n",
-                    priorStampText, interval);
+/*+/subr**********************************************************************
+* NAME	cauShardMerge - merge output from the shards into dataOut
+*
+* DESCRIPTION
+*	For each shard, the shard's output streams are swapped, and the
+*	output which the shard has printed since the last merge is
+*	written to dataOut.  The swap is done while holding the shard's
+*	lock, so each monitor's output is kept together; the writing
+*	is done without the lock, so the shard isn't held up.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauShardMerge(pCxCmd, pCauDesc)
+CX_CMD	*pCxCmd;	/* I pointer to command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    CAU_SHARD	*pShard;	/* pointer to shard */
+    int		i, ix;
+    size_t	nBytes;		/* number of bytes of output */
+
+    for (i=0; i<pCauDesc->nShard; i++) {
+	pShard = &pCauDesc->pShard[i];
+	epicsMutexMustLock(pShard->lock);
+	ix = pShard->outIx;
+	(void)fflush(pShard->out[ix]);
+	if ((nBytes = pShard->outSize[ix]) > 0)
+	    pShard->outIx = 1 - ix;
+	epicsMutexUnlock(pShard->lock);
+	if (nBytes > 0) {
+	    (void)fwrite(pShard->outBuf[ix], 1, nBytes, pCxCmd->dataOut);
+	    rewind(pShard->out[ix]);
 	}
-	else
-	    printFlag = 0;
     }
-    nBytes = dbr_size_n(arg.type, arg.count);
-    while (nBytes-- > 0)
-	((char *)pCauChan->pBuf)[nBytes] = ((char *)arg.dbr)[nBytes];
-    if (printFlag)
-	cauPrintBuf(pCxCmd, pCauChan, 1, 1, 0, 0, 0);
-    cauCaDebug("exit cauMonitor()", 1);
 }
-
+
 /*+/subr**********************************************************************
-* NAME	cauPrintBuf - print a channel's present value
+* NAME	cauShardOpDo - do an op for a shard
 *
 * DESCRIPTION
-*	Print buffer type, channel name, time stamp, and value.
+*	Runs in the shard's thread, to start or stop a monitor.  Starting
+*	a monitor creates a channel in the shard's context, with
+*	cauShardConn as the connection handler, and puts the channel on
+*	the shard's channel list.  Stopping a monitor clears the channel
+*	(which clears the monitor, too) and takes it off the list.
 *
 * RETURNS
 *	void
 *
 *-*/
 static void
-cauPrintBuf(pCxCmd, pChan, prName, prTime, prDBRType, prENUMAsShort, prEGU)
-CX_CMD	*pCxCmd;	/* I pointer to command context */
-CAU_CHAN *pChan;	/* I pointer to channel descriptor */
-int	prName;		/* I 1 if channel name is to be printed */
-int	prTime;		/* I 1 if time is to be printed */
-int	prDBRType;	/* I 1 if DBR_type of channel is to be printed */
-int	prENUMAsShort;	/* I 1 if DBR_ENUM values are to print as short */
-int	prEGU;		/* I 1 if EGU is to be printed */
+cauShardOpDo(pShard, op, pChan)
+CAU_SHARD *pShard;	/* IO pointer to shard */
+int	op;		/* I CAU_SHARD_MON or CAU_SHARD_MON_STOP */
+CAU_CHAN *pChan;	/* IO pointer to channel descriptor */
 {
-    char	stampText[28];
-    int		prec;
-    int		state;		/* state for ENUM's */
-    void	*pVal;		/* pointer to value field */
+    long	stat;
 
-    if (prDBRType)
-      (void)fprintf(pCxCmd->dataOut,"%-10s ",dbr_type_to_text(pChan->dbrType));
-    if (prName)
-	(void)fprintf(pCxCmd->dataOut, "%20s", pChan->name);
-    if (!prTime)
-	;
-    else if (dbr_type_is_TIME(pChan->dbrType)) {
-        (void)epicsTimeToStrftime(stampText,28,"%m-%d-%y %H:%M:%S.%09f"
-                                                ,&pChan->pBuf->tstrval.stamp);
-	(void)fprintf(pCxCmd->dataOut, " %s", &stampText[9]);
+    if (op == CAU_SHARD_MON) {
+	pChan->pShardEv = NULL;
+	cauCaDebugName("shard, prior to ca_create_channel", pChan->name, 0);
+	stat = ca_create_channel(pChan->name, cauShardConn, pChan,
+				CA_PRIORITY_DEFAULT, &pChan->pShardCh);
+	cauCaDebugStat("back from ca_create_channel", stat, 0);
+	if (stat != ECA_NORMAL) {
+	    (void)printf("error on search for %s\n", pChan->name);
+	    pChan->pShardCh = NULL;
+	}
+	epicsMutexMustLock(pShard->lock);
+	pChan->pShardNext = NULL;
+	pChan->pShardPrev = pShard->pChanTail;
+	if (pShard->pChanTail != NULL)
+	    pShard->pChanTail->pShardNext = pChan;
+	else
+	    pShard->pChanHead = pChan;
+	pShard->pChanTail = pChan;
+	pShard->nChan++;
+	epicsMutexUnlock(pShard->lock);
     }
-    else {
-	(void)fprintf(pCxCmd->dataOut, " buffer not of type DBR_TIME_xxx\n");
-	return;
+    else if (op == CAU_SHARD_MON_STOP) {
+	if (pChan->pShardCh != NULL) {
+	    cauCaDebugName("shard, prior to ca_clear_channel", pChan->name, 0);
+	    stat = ca_clear_channel(pChan->pShardCh);
+	    cauCaDebugStat("back from ca_clear_channel", stat, 0);
+	}
+	pChan->pShardCh = NULL;
+	pChan->pShardEv = NULL;
+	epicsMutexMustLock(pShard->lock);
+	cauTmrCancel(&pShard->deadTimeHeap, &pChan->deadTime);
+	if (pChan->bufBackNeed > 0) {
+	    pChan->bufBackNeed = 0;		/* nothing left to grow for */
+	    pShard->nGrow--;
+	}
+	if (pChan->pShardPrev != NULL)
+	    pChan->pShardPrev->pShardNext = pChan->pShardNext;
+	else
+	    pShard->pChanHead = pChan->pShardNext;
+	if (pChan->pShardNext != NULL)
+	    pChan->pShardNext->pShardPrev = pChan->pShardPrev;
+	else
+	    pShard->pChanTail = pChan->pShardPrev;
+	pChan->pShardPrev = pChan->pShardNext = NULL;
+	pShard->nChan--;
+	epicsMutexUnlock(pShard->lock);
     }
+}
 
-    if (pChan->reqCount > 1) {
-	cauPrintBufArray(pCxCmd->dataOut, pChan);
-	return;
-    }
-    pVal = dbr_value_ptr(pChan->pBuf, pChan->dbrType);
-    if (pVal == NULL)
-	(void)fprintf(pCxCmd->dataOut,"invalid buffer type: %ld", pChan->dbrType);
-    else if (dbr_type_is_STRING(pChan->dbrType))
-	(void)fprintf(pCxCmd->dataOut, " %12s", (char *)pVal);
-    else if (dbr_type_is_SHORT(pChan->dbrType))
-	(void)fprintf(pCxCmd->dataOut, " %12d", *(short *)pVal);
-    else if (dbr_type_is_LONG(pChan->dbrType))
-	(void)fprintf(pCxCmd->dataOut, " %12d", *(int *)pVal);
-    else if (dbr_type_is_CHAR(pChan->dbrType))
-	(void)fprintf(pCxCmd->dataOut, " %12d", *(unsigned char *)pVal);
-    else if (dbr_type_is_ENUM(pChan->dbrType)) {
-	state = *(short *)pVal;
-	if (pChan->dbfType != DBF_ENUM || prENUMAsShort)
-	    (void)fprintf(pCxCmd->dataOut, " %12d", state);
-	else if (state < 0 || state >= pChan->pGRBuf->genmval.no_str)
-	    (void)fprintf(pCxCmd->dataOut, " %12d (illegal)", state);
-	else {
-	    (void)fprintf(pCxCmd->dataOut,
-				" %12s", pChan->pGRBuf->genmval.strs[state]);
+/*+/subr**********************************************************************
+* NAME	cauShardOpPut - put an op into a shard's op queue
+*
+* DESCRIPTION
+*	Queues an op for the shard and wakes up the shard's thread.  If
+*	the queue is full, this routine waits for the shard to make room.
+*
+* RETURNS
+*	OK, or
+*	ERROR if the shard has stopped
+*
+*-*/
+static long
+cauShardOpPut(pShard, op, pChan)
+CAU_SHARD *pShard;	/* IO pointer to shard */
+int	op;		/* I CAU_SHARD_MON or CAU_SHARD_MON_STOP */
+CAU_CHAN *pChan;	/* I pointer to channel descriptor */
+{
+    CAU_SHARD_OP shardOp;	/* op for queue */
+
+    shardOp.op = op;
+    shardOp.pChan = pChan;
+    pShard->nOpPut++;
+    while (epicsRingBytesPut(pShard->opQueue, (char *)&shardOp,
+				sizeof(shardOp)) != sizeof(shardOp)) {
+	if (pShard->stopped) {
+	    pShard->nOpPut--;
+	    return ERROR;
 	}
+	epicsEventSignal(pShard->opEvent);
+	(void)epicsEventWaitWithTimeout(pShard->opDoneEvent, .5);
     }
-    else if (dbr_type_is_FLOAT(pChan->dbrType)) {
-	prec = pChan->pGRBuf->gfltval.precision;
-	(void)fprintf(pCxCmd->dataOut, " %12.*f", prec, *(float *)pVal);
+    epicsEventSignal(pShard->opEvent);
+    return OK;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauShardStart - start a shard
+*
+* DESCRIPTION
+*	Creates the shard's lock, op queue, and output streams, and then
+*	starts the shard's thread.  This routine waits until the thread
+*	has created the shard's Channel Access context.
+*
+* RETURNS
+*	OK, or
+*	ERROR
+*
+*-*/
+static long
+cauShardStart(pShard, ix)
+CAU_SHARD *pShard;	/* O pointer to shard */
+int	ix;		/* I index of shard */
+{
+    char	name[20];	/* name for shard's thread */
+
+    pShard->ix = ix;
+    pShard->pCtx = NULL;
+    pShard->nOpPut = pShard->nOpDone = 0;
+    pShard->stop = 0;
+    pShard->stopped = 1;
+    pShard->pChanHead = pShard->pChanTail = NULL;
+    pShard->nChan = 0;
+    pShard->nMon = 0;
+    pShard->nDrop = 0;
+    pShard->nGrow = 0;
+    pShard->deadTimeHeap.ppTmr = NULL;
+    pShard->deadTimeHeap.nTmr = pShard->deadTimeHeap.dim = 0;
+    pShard->deadTimeWait.secPastEpoch = 0;
+    pShard->outIx = 0;
+    pShard->lock = epicsMutexCreate();
+    pShard->opQueue =
+		epicsRingBytesCreate(CAU_SHARD_Q_DIM * sizeof(CAU_SHARD_OP));
+    pShard->opEvent = epicsEventCreate(epicsEventEmpty);
+    pShard->opDoneEvent = epicsEventCreate(epicsEventEmpty);
+    pShard->outBuf[0] = pShard->outBuf[1] = NULL;
+    pShard->out[0] = open_memstream(&pShard->outBuf[0], &pShard->outSize[0]);
+    pShard->out[1] = open_memstream(&pShard->outBuf[1], &pShard->outSize[1]);
+    if (pShard->lock == NULL || pShard->opQueue == NULL ||
+		pShard->opEvent == NULL || pShard->opDoneEvent == NULL ||
+		pShard->out[0] == NULL || pShard->out[1] == NULL) {
+	(void)printf("cau: can't create shard %d\n", ix);
+	return ERROR;
+    }
+
+    pShard->stopped = 0;
+    pShard->nOpPut = 1;		/* the thread's first op is CA startup */
+    (void)sprintf(name, "cauShard%d", ix);
+    if (epicsThreadCreate(name, epicsThreadPriorityMedium,
+		epicsThreadGetStackSize(epicsThreadStackMedium),
+		cauShardTask, (void *)pShard) == NULL) {
+	(void)printf("error spawning %s\n", name);
+	pShard->stopped = 1;
+	return ERROR;
+    }
+    cauShardSync(pShard);
+    if (pShard->pCtx == NULL)
+	return ERROR;
+    return OK;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauShardStop - stop a shard
+*
+* DESCRIPTION
+*	Asks the shard's thread to stop and waits until it has done so,
+*	and then frees the shard's resources.  Output which hasn't been
+*	merged is discarded.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauShardStop(pShard)
+CAU_SHARD *pShard;	/* IO pointer to shard */
+{
+    int		i;
+
+    pShard->stop = 1;
+    while (!pShard->stopped) {
+	epicsEventSignal(pShard->opEvent);
+	(void)epicsEventWaitWithTimeout(pShard->opDoneEvent, .5);
     }
-    else if (dbr_type_is_DOUBLE(pChan->dbrType)) {
-	prec = pChan->pGRBuf->gdblval.precision;
-	(void)fprintf(pCxCmd->dataOut, " %12.*f", prec, *(double *)pVal);
+    if (pShard->lock != NULL)
+	epicsMutexDestroy(pShard->lock);
+    if (pShard->opQueue != NULL)
+	epicsRingBytesDelete(pShard->opQueue);
+    if (pShard->opEvent != NULL)
+	epicsEventDestroy(pShard->opEvent);
+    if (pShard->opDoneEvent != NULL)
+	epicsEventDestroy(pShard->opDoneEvent);
+    for (i=0; i<2; i++) {
+	if (pShard->out[i] != NULL)
+	    (void)fclose(pShard->out[i]);
+	if (pShard->outBuf[i] != NULL)
+	    free(pShard->outBuf[i]);
     }
-    if (pChan->units != NULL && prEGU)
-	(void)fprintf(pCxCmd->dataOut, " %s", pChan->units);
-    (void)fprintf(pCxCmd->dataOut, "\n");
+    if (pShard->deadTimeHeap.ppTmr != NULL)
+	free((char *)pShard->deadTimeHeap.ppTmr);
 }
-
+
 /*+/subr**********************************************************************
-* NAME	cauPrintBufArray - print an array channel's present value
+* NAME	cauShardSync - wait until a shard has done its queued ops
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauShardSync(pShard)
+CAU_SHARD *pShard;	/* I pointer to shard */
+{
+    while (pShard->nOpDone != pShard->nOpPut && !pShard->stopped)
+	(void)epicsEventWaitWithTimeout(pShard->opDoneEvent, .5);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauShardTask - thread for a shard
 *
 * DESCRIPTION
-*	Print values for an array channel, in compressed form
+*	Creates the shard's Channel Access context, with preemptive
+*	callbacks, and then does the ops which cauTask queues for the
+*	shard.  Monitor callbacks are run by Channel Access in its own
+*	threads for the context.  Between ops, the shard's thread waits
+*	for the earliest deadTime timer for the shard's channels, and
+*	reports the channels whose timers come due.
+*
+*	When asked to stop, any channels still on the shard's list are
+*	cleared and the context is destroyed.
+*
+*	Signals are blocked, so that they are delivered to cauTask.
+*	(The Channel Access threads for the context inherit this.)
 *
 * RETURNS
 *	void
 *
 *-*/
-static  void cauPrintBufArray(out, pChan)
-FILE	*out;
-CAU_CHAN *pChan;
+static void
+cauShardTask(pArg)
+void	*pArg;		/* IO pointer to shard */
 {
-    int		nEl, nBytes, i, prec;
-    char	*pSrc;
-    char	text[7];
-    chtype	dbrType=pChan->dbrType;
+    CAU_SHARD	*pShard=(CAU_SHARD *)pArg;
+    CAU_SHARD_OP shardOp;	/* op from queue */
+    long	stat;
+    int		nOp;		/* number of ops done */
+    double	timeout;	/* longest wait, in seconds */
+    TS_STAMP	now;		/* present time */
+    sigset_t	sigSet;
 
-    (void)fprintf(out, "\n");
-    nEl = pChan->reqCount;
-    nBytes = dbr_value_size[dbrType];
-    pSrc = (char *)dbr_value_ptr(pChan->pBuf, dbrType);
+    (void)sigfillset(&sigSet);
+    (void)pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
 
-    if      (dbr_type_is_FLOAT(dbrType)) prec=pChan->pGRBuf->gfltval.precision;
-    else if (dbr_type_is_SHORT(dbrType)) prec = 0;
-    else if (dbr_type_is_DOUBLE(dbrType))prec=pChan->pGRBuf->gdblval.precision;
-    else if (dbr_type_is_LONG(dbrType))  prec = 0;
-    else if (dbr_type_is_CHAR(dbrType))  prec = 0;
-    else if (dbr_type_is_ENUM(dbrType))  prec = 0;
-    else 				 prec = 0;
+    stat = ca_context_create(ca_enable_preemptive_callback);
+    if (stat != ECA_NORMAL) {
+	(void)printf("shard %d: ca_context_create error: %s\n",
+					pShard->ix, ca_message(stat));
+	pShard->stop = 1;
+    }
+    else
+	pShard->pCtx = ca_current_context();
+    pShard->nOpDone++;
+    epicsEventSignal(pShard->opDoneEvent);
 
-    for (i=0; i<nEl; i++) {
-	if (i % 10 == 0)
-	    (void)fprintf(out, "%05d", i);
-        if      (dbr_type_is_FLOAT(dbrType))
-	    cvtDblToTxt(text, 6, (double)*(float *)pSrc, prec);
-        else if (dbr_type_is_SHORT(dbrType))
-	    cvtLngToTxt(text, 6, (long)*(short *)pSrc);
-        else if (dbr_type_is_DOUBLE(dbrType))
-	    cvtDblToTxt(text, 6, *(double *)pSrc, prec);
-        else if (dbr_type_is_LONG(dbrType))
-	    cvtLngToTxt(text, 6, *(long *)pSrc);
-        else if (dbr_type_is_CHAR(dbrType))
-	    cvtLngToTxt(text, 6, (long)*(unsigned char *)pSrc);
-        else if (dbr_type_is_ENUM(dbrType))
-	    cvtLngToTxt(text, 6, (long)*(short *)pSrc);
-	(void)fprintf(out, " %6s", text);
-	if ((i+1) % 10 == 0 || i+1 >= nEl)
-	    (void)fprintf(out, "\n");
-	pSrc += nBytes;
+    while (!pShard->stop) {
+	timeout = .5;
+	(void)epicsTimeGetCurrent(&now);
+	epicsMutexMustLock(pShard->lock);
+	if (pShard->deadTimeHeap.nTmr > 0)
+	    cauWaitLimit(&pShard->deadTimeHeap.ppTmr[0]->time, &now, &timeout);
+	pShard->deadTimeWait = now;
+	epicsTimeAddSeconds(&pShard->deadTimeWait, timeout);
+	epicsMutexUnlock(pShard->lock);
+	if (timeout > 0.)
+	    (void)epicsEventWaitWithTimeout(pShard->opEvent, timeout);
+
+	(void)epicsTimeGetCurrent(&now);
+	epicsMutexMustLock(pShard->lock);
+	if (cauTmrDue(&pShard->deadTimeHeap, &now)) {
+	    cau_interval_deadTime_test(&pShard->deadTimeHeap,
+					pShard->out[pShard->outIx]);
+	}
+	epicsMutexUnlock(pShard->lock);
+
+	nOp = 0;
+	while (epicsRingBytesGet(pShard->opQueue, (char *)&shardOp,
+				sizeof(shardOp)) == sizeof(shardOp)) {
+	    cauShardOpDo(pShard, shardOp.op, shardOp.pChan);
+	    nOp++;
+	}
+	if (nOp > 0) {
+	    (void)ca_flush_io();
+	    pShard->nOpDone += nOp;
+	    epicsEventSignal(pShard->opDoneEvent);
+	}
     }
+
+    while (pShard->pChanHead != NULL)
+	cauShardOpDo(pShard, CAU_SHARD_MON_STOP, pShard->pChanHead);
+    if (pShard->pCtx != NULL)
+	ca_context_destroy();
+    pShard->stopped = 1;
+    epicsEventSignal(pShard->opDoneEvent);
 }
-
+
 /*+/subr**********************************************************************
-* NAME	cauPrintInfo - print some information about a channel
+* NAME	cauShardsSet - set the number of shards
 *
 * DESCRIPTION
-*	Prints channel name, native type and count, and indicates whether
-*	the two buffers (DBR_GR_xxx and DBR_TIME_xxx) have received
-*	values from the IOC.
+*	Stops the present shards (if any) and starts the specified number
+*	of new ones.  Channels being monitored by the old shards are
+*	moved to the new shards (or to cauTask's own context, if there
+*	are no new shards).
 *
 * RETURNS
-*	void
+*	OK, or
+*	ERROR
 *
 *-*/
-static void
-cauPrintInfo(pCxCmd, pChan)
+static long
+cauShardsSet(pCxCmd, pCauDesc, nShard)
 CX_CMD	*pCxCmd;	/* I pointer to command context */
-CAU_CHAN *pChan;	/* I pointer to channel descriptor */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+int	nShard;		/* I number of shards; 0 for none */
 {
-    (void)fprintf(pCxCmd->dataOut, "%20s", pChan->name);
-    if (dbf_type_is_valid(pChan->dbfType))
-	(void)fprintf(pCxCmd->dataOut,
-			" %16s", dbf_type_to_text(pChan->dbfType));
-    else
-	(void)fprintf(pCxCmd->dataOut, "dbfType=%8ld", pChan->dbfType);
-    (void)fprintf(pCxCmd->dataOut, " elCount=%5d", pChan->elCount);
+    long	retStat=OK;	/* return status to caller */
+    CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    CAU_CHAN	**ppMoved=NULL;	/* channels whose monitors are moved */
+    int		nMoved=0;	/* number of channels in ppMoved */
+    int		i;
 
-    if (pChan->pBuf->tstrval.status == -2)
-	(void)fprintf(pCxCmd->dataOut, "\nno value has been received");
-    else
-	cauPrintBuf(pCxCmd, pChan, 0, 0, 0, 0, 1);
+    if (pCauDesc->nShard > 0) {
+	for (pChan=pCauDesc->pChanHead; pChan!=NULL; pChan=pChan->pNext) {
+	    if (pChan->pShard != NULL)
+		nMoved++;
+	}
+	if (nMoved > 0) {
+	    ppMoved = (CAU_CHAN **)malloc(nMoved * sizeof(CAU_CHAN *));
+	    if (ppMoved == NULL) {
+		(void)printf("malloc error\n");
+		return ERROR;
+	    }
+	}
+	nMoved = 0;
+	for (pChan=pCauDesc->pChanHead; pChan!=NULL; pChan=pChan->pNext) {
+	    if (pChan->pShard != NULL) {
+		cauMonitorClear(pCauDesc, pChan);
+		ppMoved[nMoved++] = pChan;
+	    }
+	}
+	cauShardMerge(pCxCmd, pCauDesc);
+	for (i=0; i<pCauDesc->nShard; i++)
+	    cauShardStop(&pCauDesc->pShard[i]);
+	free((char *)pCauDesc->pShard);
+	pCauDesc->pShard = NULL;
+	pCauDesc->nShard = 0;
+    }
 
-    if (pChan->pGRBuf->gstrval.status == -2)
-	(void)fprintf(pCxCmd->dataOut,
-			"\nno DBR_GR_... information has been received");
+    if (nShard > 0) {
+	pCauDesc->pShard = (CAU_SHARD *)calloc(nShard, sizeof(CAU_SHARD));
+	if (pCauDesc->pShard == NULL) {
+	    (void)printf("malloc error\n");
+	    retStat = ERROR;
+	}
+	for (i=0; retStat==OK && i<nShard; i++) {
+	    if (cauShardStart(&pCauDesc->pShard[i], i) != OK) {
+		do {
+		    cauShardStop(&pCauDesc->pShard[i]);
+		} while (--i >= 0);
+		free((char *)pCauDesc->pShard);
+		pCauDesc->pShard = NULL;
+		retStat = ERROR;
+	    }
+	}
+	if (retStat == OK)
+	    pCauDesc->nShard = nShard;
+    }
 
-    (void)fprintf(pCxCmd->dataOut, "\n");
+    for (i=0; i<nMoved; i++)
+	(void)cauMonitorAdd(pCxCmd, pCauDesc, ppMoved[i]);
+    if (ppMoved != NULL)
+	free((char *)ppMoved);
+
+    return retStat;
 }
-
+#endif
+
 /*+/subr**********************************************************************
 * NAME	cauSigGen - make a signal generation pass, doing ca_put's
 *
 * DESCRIPTION
-*	For all channels in the list which specify a signal generation
-*	function:
-*	o  decrement the counter
-*	o  if the counter has reached zero,
-*	   -  call the function and
-*	   -  do a ca_put for the new value; then
-*	   -  restart the counter with the base count
+*	For each channel whose signal generation step has come due (as
+*	found from the signal generation timer heap):
+*	o  call the function and do a ca_put for the new value
+*	o  note how late the step was, for reporting by cauPrintInfo
+*	o  re-arm the channel's timer for its next step.  If the channel
+*	   is more than a whole step behind, the missed steps are skipped
+*	   (and counted) rather than being done in a burst.
+*
+*	Channels which aren't due aren't looked at.
 *
 *	If any ca_put calls were actually made, ca_flush_io is called.
 *
@@ -2194,24 +9008,37 @@ CX_CMD	*pCxCmd;	/* I pointer to command context */
 CAU_DESC	*pCauDesc;	/* IO pointer to cau descriptor */
 {
     CAU_CHAN	*pChan;		/* pointer to channel descriptor */
+    CAU_SIGGEN	*pSg;		/* pointer to signal generation state */
     long	stat;           /* status return from calls */
     int		count=0;
     TS_STAMP	now;		/* present time */
+    double	lateness;	/* how late step is, in seconds */
 
     assert(pCauDesc != NULL);
 
     (void)epicsTimeGetCurrent(&now);
-    pChan = pCauDesc->pChanHead;
-    while (pChan != NULL) {
-	if (pChan->pFn != NULL) {
-	    if ( epicsTimeGreaterThanEqual(&now, &pChan->nextTime)) {  /*true if left >= right */
-
-		(pChan->pFn)(pCxCmd, pChan);
-		count += cauSigGenPut(pCxCmd, pChan);
-		epicsTimeAddSeconds(&pChan->nextTime, pChan->secPerStep);
-	    }
+    while (cauTmrDue(&pCauDesc->sigGenHeap, &now)) {
+	pChan = (CAU_CHAN *)pCauDesc->sigGenHeap.ppTmr[0]->pArg;
+	pSg = pChan->pSigGen;
+	assert(pSg != NULL && pSg->pFn != NULL);
+
+	lateness = epicsTimeDiffInSeconds(&now, &pSg->nextTime.time);
+	pSg->stepCount++;
+	pSg->stepErrLast = lateness;
+	pSg->stepErrSum += lateness;
+	if (lateness > pSg->stepErrMax)
+	    pSg->stepErrMax = lateness;
+
+	(pSg->pFn)(pCxCmd, pChan);
+	count += cauSigGenPut(pCxCmd, pChan);
+
+	epicsTimeAddSeconds(&pSg->nextTime.time, pSg->secPerStep);
+	if (epicsTimeLessThanEqual(&pSg->nextTime.time, &now)) {
+	    pSg->stepSkipCount += (long)(lateness / pSg->secPerStep);
+	    pSg->nextTime.time = now;
+	    epicsTimeAddSeconds(&pSg->nextTime.time, pSg->secPerStep);
 	}
-	pChan = pChan->pNext;
+	cauTmrArm(&pCauDesc->sigGenHeap, &pSg->nextTime);
     }
     if (count) {
 	cauCaDebug("prior to ca_flush_io", 0);
@@ -2219,7 +9046,7 @@ CAU_DESC	*pCauDesc;	/* IO pointer to cau descriptor */
 	cauCaDebugStat("back from ca_flush_io", stat, 0);
     }
 }
-
+
 /*+/subr**********************************************************************
 * NAME	cauSigGenGetParams - get signal generation parameters
 *
@@ -2317,7 +9144,8 @@ CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
 *
 * DESCRIPTION
 *	Sends, with ca_put, the .currVal item for the channel, using
-*	the native type.
+*	the native type.  The put goes through cauPutLimit, so that a
+*	fast signal generator is held to putRate.
 *
 * RETURNS
 *	number of ca_put's done
@@ -2331,55 +9159,44 @@ cauSigGenPut(pCxCmd, pCauChan)
 CX_CMD	*pCxCmd;	/* I pointer to command context */
 CAU_CHAN *pCauChan;	/* channel pointer */
 {
-    long	stat;           /* status return from calls */
-    int		count=0;
+    CAU_SIGGEN	*pSg=pCauChan->pSigGen;/* signal generation state */
+    chtype	type;		/* DBR_xxx type of value */
+    void	*pValue;	/* pointer to value */
 
     if (pCauChan->dbfType == DBF_STRING) {
-	cauCaDebug("prior to ca_put--DBR_STRING", 0);
-	stat = ca_put(DBR_STRING, pCauChan->pCh, (void *)pCauChan->str.string);
-	cauCaDebugStat("back from ca_put", stat, 0);
-	count++;
+	type = DBR_STRING;
+	pValue = (void *)pSg->val.str.string;
     }
     else if (pCauChan->dbfType == DBF_FLOAT) {
-	cauCaDebug("prior to ca_put--DBR_FLOAT", 0);
-	stat = ca_put(DBR_FLOAT, pCauChan->pCh, (void *)&pCauChan->flt.currVal);
-	cauCaDebugStat("back from ca_put", stat, 0);
-	count++;
+	type = DBR_FLOAT;
+	pValue = (void *)&pSg->val.flt.currVal;
     }
     else if (pCauChan->dbfType == DBF_SHORT) {
-	cauCaDebug("prior to ca_put--DBR_SHORT", 0);
-	stat = ca_put(DBR_SHORT, pCauChan->pCh,(void *)&pCauChan->shrt.currVal);
-	cauCaDebugStat("back from ca_put", stat, 0);
-	count++;
+	type = DBR_SHORT;
+	pValue = (void *)&pSg->val.shrt.currVal;
     }
     else if (pCauChan->dbfType == DBF_ENUM) {
-	cauCaDebug("prior to ca_put--DBR_ENUM", 0);
-	stat = ca_put(DBR_ENUM, pCauChan->pCh, (void *)&pCauChan->enm.currVal);
-	cauCaDebugStat("back from ca_put", stat, 0);
-	count++;
+	type = DBR_ENUM;
+	pValue = (void *)&pSg->val.enm.currVal;
     }
     else if (pCauChan->dbfType == DBF_DOUBLE) {
-	cauCaDebug("prior to ca_put--DBR_DOUBLE", 0);
-	stat = ca_put(DBR_DOUBLE,pCauChan->pCh,(void *)&pCauChan->dbl.currVal);
-	cauCaDebugStat("back from ca_put", stat, 0);
-	count++;
+	type = DBR_DOUBLE;
+	pValue = (void *)&pSg->val.dbl.currVal;
     }
     else if (pCauChan->dbfType == DBF_LONG) {
-	cauCaDebug("prior to ca_put--DBR_LONG", 0);
-	stat = ca_put(DBR_LONG, pCauChan->pCh,(void *)&pCauChan->lng.currVal);
-	cauCaDebugStat("back from ca_put", stat, 0);
-	count++;
+	type = DBR_LONG;
+	pValue = (void *)&pSg->val.lng.currVal;
     }
     else if (pCauChan->dbfType == DBF_CHAR) {
-	cauCaDebug("prior to ca_put--DBR_CHAR", 0);
-	stat = ca_put(DBR_CHAR, pCauChan->pCh,(void *)&pCauChan->chr.currVal);
-	cauCaDebugStat("back from ca_put", stat, 0);
-	count++;
+	type = DBR_CHAR;
+	pValue = (void *)&pSg->val.chr.currVal;
     }
+    else
+	return 0;
 
-    return count;
+    return cauPutLimit(pglCauDesc, pCauChan, type, pValue);
 }
-
+
 static char *cauRampString="1234567890123456789012345678901234567890";
 /*+/subr**********************************************************************
 * NAME	cauSigGenRamp - generate ramp function
@@ -2398,115 +9215,116 @@ cauSigGenRamp(pCxCmd, pCauChan)
 CX_CMD	*pCxCmd;	/* I pointer to command context */
 CAU_CHAN *pCauChan;	/* channel pointer */
 {
+    CAU_SIGGEN	*pSg=pCauChan->pSigGen;/* signal generation state */
     int		count=0;
 
     if (pCauChan->dbfType == DBF_STRING) {
-	pCauChan->str.currVal += pCauChan->str.addVal;
-	strcpy(pCauChan->str.string, cauRampString);
-	if (pCauChan->str.currVal < db_strval_dim)
-	    pCauChan->str.string[pCauChan->str.currVal] = '\0';
+	pSg->val.str.currVal += pSg->val.str.addVal;
+	strcpy(pSg->val.str.string, cauRampString);
+	if (pSg->val.str.currVal < db_strval_dim)
+	    pSg->val.str.string[pSg->val.str.currVal] = '\0';
 	else
-	    pCauChan->str.string[db_strval_dim-1] = '\0';
-	if (pCauChan->str.endVal > pCauChan->str.begVal) {
-	    if (pCauChan->str.currVal >= pCauChan->str.endVal) {
+	    pSg->val.str.string[db_strval_dim-1] = '\0';
+	if (pSg->val.str.endVal > pSg->val.str.begVal) {
+	    if (pSg->val.str.currVal >= pSg->val.str.endVal) {
 		count += cauSigGenPut(pCxCmd, pCauChan);
-		pCauChan->str.currVal = pCauChan->str.begVal;
-		strcpy(pCauChan->str.string, cauRampString);
-		if (pCauChan->str.currVal < db_strval_dim)
-		    pCauChan->str.string[pCauChan->str.currVal] = '\0';
+		pSg->val.str.currVal = pSg->val.str.begVal;
+		strcpy(pSg->val.str.string, cauRampString);
+		if (pSg->val.str.currVal < db_strval_dim)
+		    pSg->val.str.string[pSg->val.str.currVal] = '\0';
 		else
-		    pCauChan->str.string[db_strval_dim-1] = '\0';
+		    pSg->val.str.string[db_strval_dim-1] = '\0';
 	    }
 	}
 	else {
-	    if (pCauChan->str.currVal <= pCauChan->str.endVal) {
+	    if (pSg->val.str.currVal <= pSg->val.str.endVal) {
 		count += cauSigGenPut(pCxCmd, pCauChan);
-		pCauChan->str.currVal = pCauChan->str.begVal;
-		strcpy(pCauChan->str.string, cauRampString);
-		if (pCauChan->str.currVal < db_strval_dim)
-		    pCauChan->str.string[pCauChan->str.currVal] = '\0';
+		pSg->val.str.currVal = pSg->val.str.begVal;
+		strcpy(pSg->val.str.string, cauRampString);
+		if (pSg->val.str.currVal < db_strval_dim)
+		    pSg->val.str.string[pSg->val.str.currVal] = '\0';
 		else
-		    pCauChan->str.string[db_strval_dim-1] = '\0';
+		    pSg->val.str.string[db_strval_dim-1] = '\0';
 	    }
 	}
     }
     else if (pCauChan->dbfType == DBF_FLOAT) {
-	pCauChan->flt.currVal += pCauChan->flt.addVal;
-	if (pCauChan->flt.endVal > pCauChan->flt.begVal) {
-	    if (pCauChan->flt.currVal >= pCauChan->flt.endVal) {
+	pSg->val.flt.currVal += pSg->val.flt.addVal;
+	if (pSg->val.flt.endVal > pSg->val.flt.begVal) {
+	    if (pSg->val.flt.currVal >= pSg->val.flt.endVal) {
 		count += cauSigGenPut(pCxCmd, pCauChan);
-		pCauChan->flt.currVal = pCauChan->flt.begVal;
+		pSg->val.flt.currVal = pSg->val.flt.begVal;
 	    }
 	}
 	else {
-	    if (pCauChan->flt.currVal <= pCauChan->flt.endVal) {
+	    if (pSg->val.flt.currVal <= pSg->val.flt.endVal) {
 		count += cauSigGenPut(pCxCmd, pCauChan);
-		pCauChan->flt.currVal = pCauChan->flt.begVal;
+		pSg->val.flt.currVal = pSg->val.flt.begVal;
 	    }
 	}
     }
     else if (pCauChan->dbfType == DBF_SHORT) {
-	pCauChan->shrt.currVal += pCauChan->shrt.addVal;
-	if (pCauChan->shrt.endVal > pCauChan->shrt.begVal) {
-	    if (pCauChan->shrt.currVal >= pCauChan->shrt.endVal) {
+	pSg->val.shrt.currVal += pSg->val.shrt.addVal;
+	if (pSg->val.shrt.endVal > pSg->val.shrt.begVal) {
+	    if (pSg->val.shrt.currVal >= pSg->val.shrt.endVal) {
 		count += cauSigGenPut(pCxCmd, pCauChan);
-		pCauChan->shrt.currVal = pCauChan->shrt.begVal;
+		pSg->val.shrt.currVal = pSg->val.shrt.begVal;
 	    }
 	}
 	else {
-	    if (pCauChan->shrt.currVal <= pCauChan->shrt.endVal) {
+	    if (pSg->val.shrt.currVal <= pSg->val.shrt.endVal) {
 		count += cauSigGenPut(pCxCmd, pCauChan);
-		pCauChan->shrt.currVal = pCauChan->shrt.begVal;
+		pSg->val.shrt.currVal = pSg->val.shrt.begVal;
 	    }
 	}
     }
     else if (pCauChan->dbfType == DBF_ENUM) {
-	pCauChan->enm.currVal += pCauChan->enm.addVal;
-	if (pCauChan->enm.currVal > pCauChan->enm.endVal)
-	    pCauChan->enm.currVal = pCauChan->enm.begVal;
+	pSg->val.enm.currVal += pSg->val.enm.addVal;
+	if (pSg->val.enm.currVal > pSg->val.enm.endVal)
+	    pSg->val.enm.currVal = pSg->val.enm.begVal;
     }
     else if (pCauChan->dbfType == DBF_DOUBLE) {
-	pCauChan->dbl.currVal += pCauChan->dbl.addVal;
-	if (pCauChan->dbl.endVal > pCauChan->dbl.begVal) {
-	    if (pCauChan->dbl.currVal >= pCauChan->dbl.endVal) {
+	pSg->val.dbl.currVal += pSg->val.dbl.addVal;
+	if (pSg->val.dbl.endVal > pSg->val.dbl.begVal) {
+	    if (pSg->val.dbl.currVal >= pSg->val.dbl.endVal) {
 		count += cauSigGenPut(pCxCmd, pCauChan);
-		pCauChan->dbl.currVal = pCauChan->dbl.begVal;
+		pSg->val.dbl.currVal = pSg->val.dbl.begVal;
 	    }
 	}
 	else {
-	    if (pCauChan->dbl.currVal <= pCauChan->dbl.endVal) {
+	    if (pSg->val.dbl.currVal <= pSg->val.dbl.endVal) {
 		count += cauSigGenPut(pCxCmd, pCauChan);
-		pCauChan->dbl.currVal = pCauChan->dbl.begVal;
+		pSg->val.dbl.currVal = pSg->val.dbl.begVal;
 	    }
 	}
     }
     else if (pCauChan->dbfType == DBF_LONG) {
-	pCauChan->lng.currVal += pCauChan->lng.addVal;
-	if (pCauChan->lng.endVal > pCauChan->lng.begVal) {
-	    if (pCauChan->lng.currVal >= pCauChan->lng.endVal) {
+	pSg->val.lng.currVal += pSg->val.lng.addVal;
+	if (pSg->val.lng.endVal > pSg->val.lng.begVal) {
+	    if (pSg->val.lng.currVal >= pSg->val.lng.endVal) {
 		count += cauSigGenPut(pCxCmd, pCauChan);
-		pCauChan->lng.currVal = pCauChan->lng.begVal;
+		pSg->val.lng.currVal = pSg->val.lng.begVal;
 	    }
 	}
 	else {
-	    if (pCauChan->lng.currVal <= pCauChan->lng.endVal) {
+	    if (pSg->val.lng.currVal <= pSg->val.lng.endVal) {
 		count += cauSigGenPut(pCxCmd, pCauChan);
-		pCauChan->lng.currVal = pCauChan->lng.begVal;
+		pSg->val.lng.currVal = pSg->val.lng.begVal;
 	    }
 	}
     }
     else if (pCauChan->dbfType == DBF_CHAR) {
-	pCauChan->chr.currVal += pCauChan->chr.addVal;
-	if (pCauChan->chr.endVal > pCauChan->chr.begVal) {
-	    if (pCauChan->chr.currVal >= pCauChan->chr.endVal) {
+	pSg->val.chr.currVal += pSg->val.chr.addVal;
+	if (pSg->val.chr.endVal > pSg->val.chr.begVal) {
+	    if (pSg->val.chr.currVal >= pSg->val.chr.endVal) {
 		count += cauSigGenPut(pCxCmd, pCauChan);
-		pCauChan->chr.currVal = pCauChan->chr.begVal;
+		pSg->val.chr.currVal = pSg->val.chr.begVal;
 	    }
 	}
 	else {
-	    if (pCauChan->chr.currVal <= pCauChan->chr.endVal) {
+	    if (pSg->val.chr.currVal <= pSg->val.chr.endVal) {
 		count += cauSigGenPut(pCxCmd, pCauChan);
-		pCauChan->chr.currVal = pCauChan->chr.begVal;
+		pSg->val.chr.currVal = pSg->val.chr.begVal;
 	    }
 	}
     }
@@ -2523,144 +9341,462 @@ CAU_CHAN *pChan;	/* IO channel pointer */
     long	lngDiff;	/* endVal-begVal for long */
     char	chrDiff;	/* endVal-begVal for char */
     TS_STAMP	now;		/* present time */
+    union db_access_val *pGR=NULL;/* pointer to graphics info */
+    CAU_SIGGEN	*pSg;		/* pointer to signal generation state */
 
+    if (pChan->dbfType == DBF_ENUM || (pChan->dbfType != DBF_STRING &&
+				pCauDesc->endVal == pCauDesc->begVal)) {
+	pGR = cauChanGRFetch(pCauDesc, pChan, CAU_GR_NEED_ALL);
+	if (pGR == NULL) {
+	    (void)printf("can't ramp %s--no graphics info for channel\n",
+								pChan->name);
+	    return;
+	}
+    }
+
+    if ((pSg = pChan->pSigGen) == NULL) {
+	pSg = (CAU_SIGGEN *)cauPoolGet(&pCauDesc->sigGenPool);
+	if (pSg == NULL) {
+	    (void)printf("malloc error\n");
+	    return;
+	}
+	pSg->nextTime.heapIx = -1;
+	pSg->nextTime.pArg = pChan;
+	pChan->pSigGen = pSg;
+    }
+    pSg->pFn = NULL;
     (void)epicsTimeGetCurrent(&now);
-    pChan->secPerStep = pCauDesc->secPerStep;
-    pChan->nextTime = now;
+    pSg->secPerStep = pCauDesc->secPerStep;
+    pSg->nextTime.time = now;
+    pSg->stepCount = 0;
+    pSg->stepSkipCount = 0;
+    pSg->stepErrLast = 0.;
+    pSg->stepErrMax = 0.;
+    pSg->stepErrSum = 0.;
 
     if (pChan->dbfType == DBF_STRING) {
-	pChan->pFn = cauSigGenRamp;
-	pChan->nSteps = pCauDesc->nSteps;
+	pSg->pFn = cauSigGenRamp;
+	pSg->nSteps = pCauDesc->nSteps;
 	if (pCauDesc->endVal == pCauDesc->begVal) {
-	    pChan->str.endVal = 10;
-	    pChan->str.begVal = 0;
+	    pSg->val.str.endVal = 10;
+	    pSg->val.str.begVal = 0;
 	}
 	else {
-	    pChan->str.endVal = (char)pCauDesc->endVal;
-	    if (pChan->str.endVal < 0)
-		pChan->str.endVal = 0;
-	    else if (pChan->str.endVal >= db_strval_dim)
-		pChan->str.endVal = db_strval_dim-1;
-	    pChan->str.begVal = (char)pCauDesc->begVal;
-	    if (pChan->str.begVal < 0)
-		pChan->str.begVal = 0;
-	    else if (pChan->str.begVal >= db_strval_dim)
-		pChan->str.begVal = db_strval_dim-1;
-	    if (pChan->str.endVal == pChan->str.begVal) {
-		pChan->str.endVal = 10;
-		pChan->str.begVal = 0;
+	    pSg->val.str.endVal = (char)pCauDesc->endVal;
+	    if (pSg->val.str.endVal < 0)
+		pSg->val.str.endVal = 0;
+	    else if (pSg->val.str.endVal >= db_strval_dim)
+		pSg->val.str.endVal = db_strval_dim-1;
+	    pSg->val.str.begVal = (char)pCauDesc->begVal;
+	    if (pSg->val.str.begVal < 0)
+		pSg->val.str.begVal = 0;
+	    else if (pSg->val.str.begVal >= db_strval_dim)
+		pSg->val.str.begVal = db_strval_dim-1;
+	    if (pSg->val.str.endVal == pSg->val.str.begVal) {
+		pSg->val.str.endVal = 10;
+		pSg->val.str.begVal = 0;
 	    }
 	}
-	shrtDiff = pChan->str.endVal - pChan->str.begVal;
+	shrtDiff = pSg->val.str.endVal - pSg->val.str.begVal;
 	if (shrtDiff < 0)
 	    shrtDiff = -shrtDiff;
-	if (shrtDiff < pChan->nSteps)
-	    pChan->nSteps = shrtDiff;
-	pChan->str.addVal = (pChan->str.endVal - pChan->str.begVal) /
-								pChan->nSteps;
-	pChan->str.currVal = pChan->str.begVal;
-	strcpy(pChan->str.string, cauRampString);
-	pChan->str.string[pChan->str.currVal] = '\0';
+	if (shrtDiff < pSg->nSteps)
+	    pSg->nSteps = shrtDiff;
+	pSg->val.str.addVal = (pSg->val.str.endVal - pSg->val.str.begVal) /
+								pSg->nSteps;
+	pSg->val.str.currVal = pSg->val.str.begVal;
+	strcpy(pSg->val.str.string, cauRampString);
+	pSg->val.str.string[pSg->val.str.currVal] = '\0';
     }
     else if (pChan->dbfType == DBF_FLOAT) {
-	pChan->pFn = cauSigGenRamp;
-	pChan->nSteps = pCauDesc->nSteps;
+	pSg->pFn = cauSigGenRamp;
+	pSg->nSteps = pCauDesc->nSteps;
 	if (pCauDesc->endVal == pCauDesc->begVal) {
-	    pChan->flt.endVal = pChan->pGRBuf->gfltval.upper_disp_limit;
-	    pChan->flt.begVal = pChan->pGRBuf->gfltval.lower_disp_limit;
+	    pSg->val.flt.endVal = pGR->gfltval.upper_disp_limit;
+	    pSg->val.flt.begVal = pGR->gfltval.lower_disp_limit;
 	}
 	else {
-	    pChan->flt.endVal = pCauDesc->endVal;
-	    pChan->flt.begVal = pCauDesc->begVal;
+	    pSg->val.flt.endVal = pCauDesc->endVal;
+	    pSg->val.flt.begVal = pCauDesc->begVal;
 	}
-	pChan->flt.addVal = (pChan->flt.endVal - pChan->flt.begVal) /
-				((float)pChan->nSteps - .00001);
-	pChan->flt.currVal = pChan->flt.begVal;
+	pSg->val.flt.addVal = (pSg->val.flt.endVal - pSg->val.flt.begVal) /
+				((float)pSg->nSteps - .00001);
+	pSg->val.flt.currVal = pSg->val.flt.begVal;
     }
     else if (pChan->dbfType == DBF_SHORT) {
-	pChan->pFn = cauSigGenRamp;
-	pChan->nSteps = pCauDesc->nSteps;
+	pSg->pFn = cauSigGenRamp;
+	pSg->nSteps = pCauDesc->nSteps;
 	if (pCauDesc->endVal == pCauDesc->begVal) {
-	    pChan->shrt.endVal = pChan->pGRBuf->gshrtval.upper_disp_limit;
-	    pChan->shrt.begVal = pChan->pGRBuf->gshrtval.lower_disp_limit;
+	    pSg->val.shrt.endVal = pGR->gshrtval.upper_disp_limit;
+	    pSg->val.shrt.begVal = pGR->gshrtval.lower_disp_limit;
 	}
 	else {
-	    pChan->shrt.endVal = (short)pCauDesc->endVal;
-	    pChan->shrt.begVal = (short)pCauDesc->begVal;
+	    pSg->val.shrt.endVal = (short)pCauDesc->endVal;
+	    pSg->val.shrt.begVal = (short)pCauDesc->begVal;
 	}
-	shrtDiff = pChan->shrt.endVal - pChan->shrt.begVal;
+	shrtDiff = pSg->val.shrt.endVal - pSg->val.shrt.begVal;
 	if (shrtDiff < 0)
 	    shrtDiff = -shrtDiff;
-	if (shrtDiff < pChan->nSteps)
-	    pChan->nSteps = shrtDiff;
-	pChan->shrt.addVal = (pChan->shrt.endVal - pChan->shrt.begVal) /
-								pChan->nSteps;
-	pChan->shrt.currVal = pChan->shrt.begVal;
+	if (shrtDiff < pSg->nSteps)
+	    pSg->nSteps = shrtDiff;
+	pSg->val.shrt.addVal = (pSg->val.shrt.endVal - pSg->val.shrt.begVal) /
+								pSg->nSteps;
+	pSg->val.shrt.currVal = pSg->val.shrt.begVal;
     }
     else if (pChan->dbfType == DBF_ENUM) {
-	pChan->pFn = cauSigGenRamp;
-	pChan->nSteps = pChan->pGRBuf->genmval.no_str;
-	pChan->enm.endVal = pChan->pGRBuf->genmval.no_str - 1;
-	pChan->enm.begVal = 0;
-	pChan->enm.addVal = 1;
-	pChan->enm.currVal = pChan->enm.endVal;
+	pSg->pFn = cauSigGenRamp;
+	pSg->nSteps = pGR->genmval.no_str;
+	pSg->val.enm.endVal = pGR->genmval.no_str - 1;
+	pSg->val.enm.begVal = 0;
+	pSg->val.enm.addVal = 1;
+	pSg->val.enm.currVal = pSg->val.enm.endVal;
     }
     else if (pChan->dbfType == DBF_DOUBLE) {
-	pChan->pFn = cauSigGenRamp;
-	pChan->nSteps = pCauDesc->nSteps;
+	pSg->pFn = cauSigGenRamp;
+	pSg->nSteps = pCauDesc->nSteps;
 	if (pCauDesc->endVal == pCauDesc->begVal) {
-	    pChan->dbl.endVal = pChan->pGRBuf->gdblval.upper_disp_limit;
-	    pChan->dbl.begVal = pChan->pGRBuf->gdblval.lower_disp_limit;
+	    pSg->val.dbl.endVal = pGR->gdblval.upper_disp_limit;
+	    pSg->val.dbl.begVal = pGR->gdblval.lower_disp_limit;
 	}
 	else {
-	    pChan->dbl.endVal = pCauDesc->endVal;
-	    pChan->dbl.begVal = pCauDesc->begVal;
+	    pSg->val.dbl.endVal = pCauDesc->endVal;
+	    pSg->val.dbl.begVal = pCauDesc->begVal;
 	}
-	pChan->dbl.addVal = (pChan->dbl.endVal - pChan->dbl.begVal) /
-				((double)pChan->nSteps - .00001);
-	pChan->dbl.currVal = pChan->dbl.begVal;
+	pSg->val.dbl.addVal = (pSg->val.dbl.endVal - pSg->val.dbl.begVal) /
+				((double)pSg->nSteps - .00001);
+	pSg->val.dbl.currVal = pSg->val.dbl.begVal;
     }
     else if (pChan->dbfType == DBF_LONG) {
-	pChan->pFn = cauSigGenRamp;
-	pChan->nSteps = pCauDesc->nSteps;
+	pSg->pFn = cauSigGenRamp;
+	pSg->nSteps = pCauDesc->nSteps;
 	if (pCauDesc->endVal == pCauDesc->begVal) {
-	    pChan->lng.endVal = pChan->pGRBuf->glngval.upper_disp_limit;
-	    pChan->lng.begVal = pChan->pGRBuf->glngval.lower_disp_limit;
+	    pSg->val.lng.endVal = pGR->glngval.upper_disp_limit;
+	    pSg->val.lng.begVal = pGR->glngval.lower_disp_limit;
 	}
 	else {
-	    pChan->lng.endVal = (long)pCauDesc->endVal;
-	    pChan->lng.begVal = (long)pCauDesc->begVal;
+	    pSg->val.lng.endVal = (long)pCauDesc->endVal;
+	    pSg->val.lng.begVal = (long)pCauDesc->begVal;
 	}
-	lngDiff = pChan->lng.endVal - pChan->lng.begVal;
+	lngDiff = pSg->val.lng.endVal - pSg->val.lng.begVal;
 	if (lngDiff < 0)
 	    lngDiff = -lngDiff;
-	if (lngDiff < pChan->nSteps)
-	    pChan->nSteps = lngDiff;
-	pChan->lng.addVal = (pChan->lng.endVal - pChan->lng.begVal) /
-								pChan->nSteps;
-	pChan->lng.currVal = pChan->lng.begVal;
+	if (lngDiff < pSg->nSteps)
+	    pSg->nSteps = lngDiff;
+	pSg->val.lng.addVal = (pSg->val.lng.endVal - pSg->val.lng.begVal) /
+								pSg->nSteps;
+	pSg->val.lng.currVal = pSg->val.lng.begVal;
     }
     else if (pChan->dbfType == DBF_CHAR) {
-	pChan->pFn = cauSigGenRamp;
-	pChan->nSteps = pCauDesc->nSteps;
+	pSg->pFn = cauSigGenRamp;
+	pSg->nSteps = pCauDesc->nSteps;
 	if (pCauDesc->endVal == pCauDesc->begVal) {
-	    pChan->chr.endVal = pChan->pGRBuf->gchrval.upper_disp_limit;
-	    pChan->chr.begVal = pChan->pGRBuf->gchrval.lower_disp_limit;
+	    pSg->val.chr.endVal = pGR->gchrval.upper_disp_limit;
+	    pSg->val.chr.begVal = pGR->gchrval.lower_disp_limit;
 	}
 	else {
-	    pChan->chr.endVal = (char)pCauDesc->endVal;
-	    pChan->chr.begVal = (char)pCauDesc->begVal;
+	    pSg->val.chr.endVal = (char)pCauDesc->endVal;
+	    pSg->val.chr.begVal = (char)pCauDesc->begVal;
 	}
-	chrDiff = pChan->chr.endVal - pChan->chr.begVal;
+	chrDiff = pSg->val.chr.endVal - pSg->val.chr.begVal;
 	if (chrDiff < 0)
 	    chrDiff = -chrDiff;
-	if (chrDiff < pChan->nSteps)
-	    pChan->nSteps = chrDiff;
-	pChan->chr.addVal = (pChan->chr.endVal - pChan->chr.begVal) /
-								pChan->nSteps;
-	pChan->chr.currVal = pChan->chr.begVal;
+	if (chrDiff < pSg->nSteps)
+	    pSg->nSteps = chrDiff;
+	pSg->val.chr.addVal = (pSg->val.chr.endVal - pSg->val.chr.begVal) /
+								pSg->nSteps;
+	pSg->val.chr.currVal = pSg->val.chr.begVal;
     }
     else {
 	printf("%s doesn't have ramp implemented yet\n", pChan->name);
     }
+
+    if (pSg->pFn == NULL)
+	cauSigGenStop(pCauDesc, pChan);
+    else if (cauTmrArm(&pCauDesc->sigGenHeap, &pSg->nextTime) != OK) {
+	(void)printf("can't schedule ramp for %s\n", pChan->name);
+	cauSigGenStop(pCauDesc, pChan);
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cauSigGenStop - stop signal generation for a channel
+*
+* DESCRIPTION
+*	Cancels the channel's next step and gives its signal generation
+*	state back to the pool.  Nothing is done if the channel has no
+*	signal generation.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauSigGenStop(pCauDesc, pChan)
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+CAU_CHAN *pChan;	/* IO channel pointer */
+{
+    if (pChan->pSigGen == NULL)
+	return;
+    cauTmrCancel(&pCauDesc->sigGenHeap, &pChan->pSigGen->nextTime);
+    cauPoolPut(&pCauDesc->sigGenPool, pChan->pSigGen);
+    pChan->pSigGen = NULL;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauTmrArm - arm (or re-arm) a timer
+*
+* DESCRIPTION
+*	Puts a timer into a timer heap, using the deadline which has been
+*	stored in the timer by the caller.  If the timer is already in
+*	the heap (i.e., its deadline has been changed), it is moved to
+*	its new position.
+*
+* RETURNS
+*	OK, or
+*	ERROR if the heap can't be expanded
+*
+*-*/
+static long
+cauTmrArm(pHeap, pTmr)
+CAU_TMR_HEAP *pHeap;	/* IO pointer to timer heap */
+CAU_TMR	*pTmr;		/* IO pointer to timer */
+{
+    CAU_TMR	**ppNew;	/* expanded heap array */
+    int		dim;
+
+    if (pTmr->heapIx < 0) {
+	if (pHeap->nTmr >= pHeap->dim) {
+	    dim = pHeap->dim > 0 ? 2 * pHeap->dim : 64;
+	    ppNew = (CAU_TMR **)realloc((char *)pHeap->ppTmr,
+						dim * sizeof(CAU_TMR *));
+	    if (ppNew == NULL) {
+		(void)printf("malloc error\n");
+		return ERROR;
+	    }
+	    pHeap->ppTmr = ppNew;
+	    pHeap->dim = dim;
+	}
+	pTmr->heapIx = pHeap->nTmr++;
+	pHeap->ppTmr[pTmr->heapIx] = pTmr;
+    }
+    cauTmrSift(pHeap, pTmr->heapIx);
+    return OK;
+}
+
+/*+/subr**********************************************************************
+* NAME	cauTmrCancel - remove a timer from a timer heap
+*
+* DESCRIPTION
+*	Removes a timer from a timer heap.  It isn't an error if the
+*	timer isn't armed.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauTmrCancel(pHeap, pTmr)
+CAU_TMR_HEAP *pHeap;	/* IO pointer to timer heap */
+CAU_TMR	*pTmr;		/* IO pointer to timer */
+{
+    int		ix;
+
+    if ((ix = pTmr->heapIx) < 0)
+	return;
+    pTmr->heapIx = -1;
+    if (ix < --pHeap->nTmr) {
+	pHeap->ppTmr[ix] = pHeap->ppTmr[pHeap->nTmr];
+	pHeap->ppTmr[ix]->heapIx = ix;
+	cauTmrSift(pHeap, ix);
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cauTmrDue - check whether the earliest timer has come due
+*
+* RETURNS
+*	1 if the timer at the top of the heap is due, or
+*	0 if it isn't due or the heap is empty
+*
+*-*/
+static int
+cauTmrDue(pHeap, pNow)
+CAU_TMR_HEAP *pHeap;	/* I pointer to timer heap */
+TS_STAMP *pNow;		/* I present time */
+{
+    if (pHeap->nTmr <= 0)
+	return 0;
+    return epicsTimeGreaterThanEqual(pNow, &pHeap->ppTmr[0]->time);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauTmrSift - restore heap order around a timer
+*
+* DESCRIPTION
+*	Moves the timer at the specified heap index up toward the top, or
+*	down toward the bottom, until its deadline is in order relative
+*	to its parent and children.
+*
+* RETURNS
+*	void
+*
+*-*/
+#define CauTmrSwap(pHeap, i, j) \
+{\
+    CAU_TMR *pTmp = pHeap->ppTmr[i];\
+    pHeap->ppTmr[i] = pHeap->ppTmr[j];\
+    pHeap->ppTmr[j] = pTmp;\
+    pHeap->ppTmr[i]->heapIx = i;\
+    pHeap->ppTmr[j]->heapIx = j;\
+}
+#define CauTmrLess(pHeap, i, j) \
+    epicsTimeLessThan(&pHeap->ppTmr[i]->time, &pHeap->ppTmr[j]->time)
+
+static void
+cauTmrSift(pHeap, ix)
+CAU_TMR_HEAP *pHeap;	/* IO pointer to timer heap */
+int	ix;		/* I heap index of timer */
+{
+    int		parent, child;
+
+    while (ix > 0) {
+	parent = (ix - 1) / 2;
+	if (!CauTmrLess(pHeap, ix, parent))
+	    break;
+	CauTmrSwap(pHeap, ix, parent);
+	ix = parent;
+    }
+    while ((child = 2 * ix + 1) < pHeap->nTmr) {
+	if (child + 1 < pHeap->nTmr && CauTmrLess(pHeap, child + 1, child))
+	    child++;
+	if (!CauTmrLess(pHeap, child, ix))
+	    break;
+	CauTmrSwap(pHeap, ix, child);
+	ix = child;
+    }
+}
+
+/*+/subr**********************************************************************
+* NAME	cauWait - wait until there is something for cauTask to do
+*
+* DESCRIPTION
+*	Blocks until Channel Access has activity to be handled, a command
+*	is waiting in the command queue, or the next signal generator step or deadTime
+*	check comes due, whichever happens first.  Channel Access callbacks
+*	are then dispatched.
+*
+*	Under SunOS (and other hosts with select), the file descriptors
+*	registered by Channel Access are watched along with the pipe
+*	which cauInTask writes when it queues a command, and ca_poll is
+*	called after select returns.  Under VxWorks and WIN32,
+*	ca_pend_event is used instead, with the wait limited so that
+*	commands are still noticed promptly.
+*
+*	If a command is already waiting in the queue, there is no wait.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauWait(pCxCmd, pCauDesc)
+CX_CMD	*pCxCmd;	/* I pointer to present command context */
+CAU_DESC *pCauDesc;	/* IO pointer to cau descriptor */
+{
+    long	stat;
+    double	timeout;	/* longest wait, in seconds */
+    TS_STAMP	now;		/* present time */
+#if !defined(vxWorks) && !defined(_WIN32)
+    fd_set	fdSet;		/* set of fd's to watch with select */
+    int		fdMax;		/* highest fd in fdSet */
+    struct timeval fdSetTimeout;/* timeout interval for select */
+    char	wakeBuf[CAU_CMD_Q_DIM];/* for draining the wake pipe */
+    int		i;
+#endif
+
+    (void)epicsTimeGetCurrent(&now);
+    timeout = CAU_WAIT_MAX;
+    if (pCauDesc->sigGenHeap.nTmr > 0)
+	cauWaitLimit(&pCauDesc->sigGenHeap.ppTmr[0]->time, &now, &timeout);
+    if (pCauDesc->deadTimeHeap.nTmr > 0)
+	cauWaitLimit(&pCauDesc->deadTimeHeap.ppTmr[0]->time, &now, &timeout);
+    if (pCauDesc->rearmHeap.nTmr > 0)
+	cauWaitLimit(&pCauDesc->rearmHeap.ppTmr[0]->time, &now, &timeout);
+    if (pCauDesc->getHeap.nTmr > 0)
+	cauWaitLimit(&pCauDesc->getHeap.ppTmr[0]->time, &now, &timeout);
+    if (pCauDesc->pollHeap.nTmr > 0)
+	cauWaitLimit(&pCauDesc->pollHeap.ppTmr[0]->time, &now, &timeout);
+    if (pCauDesc->putHeap.nTmr > 0)
+	cauWaitLimit(&pCauDesc->putHeap.ppTmr[0]->time, &now, &timeout);
+    if (pCauDesc->pingHeap.nTmr > 0)
+	cauWaitLimit(&pCauDesc->pingHeap.ppTmr[0]->time, &now, &timeout);
+#ifndef vxWorks
+    if (!epicsRingBytesIsEmpty(pCauDesc->cmdQueue))
+	timeout = 0.;
+#endif
+
+#if defined(vxWorks) || defined(_WIN32)
+    if (timeout > CAU_WAIT_POLL)
+	timeout = CAU_WAIT_POLL;
+    cauCaDebug("main loop, prior to ca_pend_event", 2);
+    if (timeout > 0.)
+	stat = ca_pend_event(timeout);
+    else
+	stat = ca_poll();
+    cauCaDebugStat("main loop, back from ca_pend_event", stat, 2);
+#else
+    if (pCauDesc->caFdLost && timeout > CAU_WAIT_POLL)
+	timeout = CAU_WAIT_POLL;
+#ifdef CAU_SHARDS
+    if (pCauDesc->nShard > 0 && timeout > CAU_SHARD_MERGE)
+	timeout = CAU_SHARD_MERGE;
+#endif
+    FD_ZERO(&fdSet);
+    fdMax = pCauDesc->cmdWakeFd[0];
+    FD_SET(fdMax, &fdSet);
+    for (i=0; i<pCauDesc->nCaFd; i++) {
+	FD_SET(pCauDesc->caFd[i], &fdSet);
+	if (pCauDesc->caFd[i] > fdMax)
+	    fdMax = pCauDesc->caFd[i];
+    }
+    fdSetTimeout.tv_sec = (long)timeout;
+    fdSetTimeout.tv_usec = (long)((timeout - fdSetTimeout.tv_sec) * 1000000.);
+    cauCaDebug("main loop, prior to select", 2);
+    (void)select(fdMax+1, &fdSet, NULL, NULL, &fdSetTimeout);
+    if (FD_ISSET(pCauDesc->cmdWakeFd[0], &fdSet)) {
+	while (read(pCauDesc->cmdWakeFd[0], wakeBuf, sizeof(wakeBuf)) > 0)
+	    ;
+    }
+    stat = ca_poll();
+    cauCaDebugStat("main loop, back from ca_poll", stat, 2);
+#endif
+    assert(stat != ECA_EVDISALLOW);
+}
+
+/*+/subr**********************************************************************
+* NAME	cauWaitLimit - limit a wait to a deadline
+*
+* DESCRIPTION
+*	If the deadline is set (i.e., isn't zero) and comes before the
+*	end of the wait, the wait is shortened to end at the deadline.
+*
+* RETURNS
+*	void
+*
+*-*/
+static void
+cauWaitLimit(pDeadline, pNow, pTimeout)
+TS_STAMP *pDeadline;	/* I deadline, or 0 if none */
+TS_STAMP *pNow;		/* I present time */
+double	*pTimeout;	/* IO wait time, in seconds */
+{
+    double	diff;
+
+    if (pDeadline->secPastEpoch == 0)
+	return;
+    diff = epicsTimeDiffInSeconds(pDeadline, pNow);
+    if (diff < 0.)
+	diff = 0.;
+    if (diff < *pTimeout)
+	*pTimeout = diff;
 }